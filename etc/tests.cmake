@@ -1,5 +1,11 @@
 enable_testing ()
 
 add_test(NAME t_websocket_loop         COMMAND websocket-loop)
+add_test(NAME t_multiserver_load       COMMAND multiserver-loadtest 4 0.5)
+add_test(NAME t_sack_roundtrip         COMMAND sack-benchmark 4000)
+add_test(NAME t_fec_recovery           COMMAND fec-recovery)
+add_test(NAME t_rate_controller_steps  COMMAND rate-controller-steps)
+add_test(NAME t_retransmit_pacing      COMMAND retransmit-pacing)
+add_test(NAME t_partial_frame_store    COMMAND partial-frame-store-random)
 
 add_custom_target(check COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --timeout 10 -R '^t_')
@@ -11,6 +11,7 @@
 #include <tuple>
 
 #include "alsa_devices.hh"
+#include "conversion_kernel.hh"
 #include "exception.hh"
 
 using namespace std;
@@ -353,65 +354,51 @@ void AudioPair::loopback( ChannelPair& capture_output, const ChannelPair& playba
   microphone_.copy_all_available_samples_to( headphone_, capture_output, playback_input, statistics_.sample_stats );
 }
 
-inline float sample_to_float( const int32_t sample )
-{
-  if ( sample & 0xff ) {
-    throw runtime_error( "invalid sample: " + to_string( sample ) );
-  }
-  constexpr float maxval = uint64_t( 1 ) << 31;
-  const float ret = sample / maxval;
-  if ( ret > 1.0 or ret < -1.0 ) {
-    throw runtime_error( "invalid sample: " + to_string( sample ) );
-  }
-  return ret;
-}
-
-inline int32_t float_to_sample( const float sample_f )
-{
-  constexpr float maxval = uint64_t( 1 ) << 31;
-  return lrint( clamp( sample_f, -1.0f, 1.0f ) * maxval );
-}
-
 void AudioInterface::copy_all_available_samples_to( AudioInterface& other,
                                                     ChannelPair& capture_output,
                                                     const ChannelPair& playback_input,
                                                     AudioStatistics::SampleStats& stats )
 {
+  const ConversionKernel& kernel = ConversionKernel::best();
+  const LoopbackGains gains { config_.ch1_loopback_gain, config_.ch2_loopback_gain };
+
+  array<float, max_block_frames> ch1, ch2, playback1, playback2;
+
   unsigned int avail_remaining = avail();
 
   while ( avail_remaining ) {
-    Buffer read_buf { *this, avail_remaining };
+    Buffer read_buf { *this, min( avail_remaining, max_block_frames ) };
     Buffer write_buf { other, read_buf.frame_count() };
 
     const unsigned int num_frames = write_buf.frame_count();
 
-    for ( unsigned int i = 0; i < num_frames; i++ ) {
-      const float ch1_sample = sample_to_float( read_buf.sample( false, i ) );
-      const float ch2_sample = sample_to_float( read_buf.sample( true, i ) );
-
-      /* capture into output buffer */
-      capture_output.safe_set( cursor_, { ch1_sample, ch2_sample } );
+    /* capture into output buffer, and track statistics */
+    BlockLevels levels;
+    if ( not kernel.capture( read_buf.frames(), ch1.data(), ch2.data(), num_frames, levels ) ) {
+      for ( unsigned int i = 0; i < 2 * num_frames; i++ ) {
+        if ( read_buf.frames()[i] & 0xff ) {
+          throw runtime_error( "invalid sample: " + to_string( read_buf.frames()[i] ) );
+        }
+      }
+    }
 
-      /* track statistics */
-      stats.samples_counted++;
-      stats.ssa_ch1 += stats.max_ch1_amplitude * stats.max_ch1_amplitude;
-      stats.ssa_ch2 += stats.max_ch2_amplitude * stats.max_ch2_amplitude;
-      stats.max_ch1_amplitude = max( stats.max_ch1_amplitude, abs( ch1_sample ) );
-      stats.max_ch2_amplitude = max( stats.max_ch2_amplitude, abs( ch2_sample ) );
+    capture_output.ch1().safe_set_region( cursor_, { ch1.data(), num_frames } );
+    capture_output.ch2().safe_set_region( cursor_, { ch2.data(), num_frames } );
 
-      /* play from input buffer + captured sample */
-      const auto playback_sample = playback_input.safe_get( cursor_ );
+    stats.samples_counted += num_frames;
+    stats.ssa_ch1 += levels.ssa_ch1;
+    stats.ssa_ch2 += levels.ssa_ch2;
+    stats.max_ch1_amplitude = max( stats.max_ch1_amplitude, levels.max_ch1_amplitude );
+    stats.max_ch2_amplitude = max( stats.max_ch2_amplitude, levels.max_ch2_amplitude );
 
-      write_buf.sample( false, i )
-        = float_to_sample( ch1_sample * config_.ch1_loopback_gain[0] + ch2_sample * config_.ch2_loopback_gain[0]
-                           + playback_sample.first );
+    /* play from input buffer + captured sample */
+    playback_input.ch1().safe_get_region( cursor_, { playback1.data(), num_frames } );
+    playback_input.ch2().safe_get_region( cursor_, { playback2.data(), num_frames } );
 
-      write_buf.sample( true, i )
-        = float_to_sample( ch1_sample * config_.ch1_loopback_gain[1] + ch2_sample * config_.ch2_loopback_gain[1]
-                           + playback_sample.second );
+    kernel.playback(
+      ch1.data(), ch2.data(), playback1.data(), playback2.data(), gains, write_buf.frames(), num_frames );
 
-      cursor_++;
-    }
+    cursor_ += num_frames;
 
     unsigned int amount_to_write = num_frames;
 
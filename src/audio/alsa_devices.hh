@@ -55,6 +55,9 @@ struct AudioStatistics
 
 class AudioInterface
 {
+  //! Largest number of frames converted at once (bounds the scratch space on the stack)
+  static constexpr unsigned int max_block_frames = 256;
+
   std::string interface_name_, annotation_;
   snd_pcm_t* pcm_;
 
@@ -82,6 +85,9 @@ class AudioInterface
       return *( static_cast<int32_t*>( areas_[0].addr ) + right_channel + 2 * ( offset_ + sample_num ) );
     }
 
+    //! The interleaved frames of this buffer, contiguous in the device's mmap area
+    int32_t* frames() { return &sample( false, 0 ); }
+
     /* can't copy or assign */
     Buffer( const Buffer& other ) = delete;
     Buffer& operator=( const Buffer& other ) = delete;
@@ -1,4 +1,10 @@
+#include <iostream>
+
+#include <pthread.h>
+#include <sched.h>
+
 #include "audio_task.hh"
+#include "exception.hh"
 #include "timestamp.hh"
 
 using namespace std;
@@ -6,99 +12,260 @@ using namespace chrono;
 
 AudioDeviceTask::AudioDeviceTask( const string_view interface_name, EventLoop& loop )
   : device_( interface_name )
+  , applied_gain_( device_.config().ch1_loopback_gain.at( 0 ) )
+  , loopback_gain_( applied_gain_ )
 {
   device_.initialize();
 
-  install_rules( loop );
+  loop.add_rule( "audio capture", capture_ready_, Direction::In, [&] { receive_capture(); } );
+}
+
+AudioDeviceTask::~AudioDeviceTask()
+{
+  stopping_ = true;
+  if ( device_thread_.joinable() ) {
+    stop_requested_.notify();
+    device_thread_.join();
+  }
+}
+
+void AudioDeviceTask::start()
+{
+  if ( device_thread_.joinable() ) {
+    throw runtime_error( "AudioDeviceTask already started" );
+  }
+
+  device_thread_ = thread( [&] { device_thread_main(); } );
 }
 
-void AudioDeviceTask::install_rules( EventLoop& loop )
+void AudioDeviceTask::device_thread_main()
 {
-  loop.add_rule(
-    "audio loopback [fast path]", [&] { service_device(); }, [&] { return device_.mic_has_samples(); } );
-
-  loop.add_rule(
-    "audio loopback [slow path]",
-    device_.fd(),
-    Direction::In,
-    [&] { service_device(); },
-    [] { return true; },
-    [] {},
-    [&] {
-      device_.recover();
-      return true;
-    } );
+  try {
+    /* real-time priority, above the EventLoop thread */
+    try {
+      sched_param param;
+      param.sched_priority = CheckSystemCall( "sched_get_priority_max", sched_get_priority_max( SCHED_FIFO ) );
+      const int ret = pthread_setschedparam( pthread_self(), SCHED_FIFO, &param );
+      if ( ret ) {
+        throw unix_error( "pthread_setschedparam", ret );
+      }
+    } catch ( const exception& e ) {
+      cerr << "Audio device thread: " << e.what() << "\n";
+    }
+
+    EventLoop loop;
+
+    loop.add_rule(
+      "audio loopback [fast path]", [&] { service_device(); }, [&] { return device_.mic_has_samples(); } );
+
+    loop.add_rule(
+      "audio loopback [slow path]",
+      device_.fd(),
+      Direction::In,
+      [&] { service_device(); },
+      [] { return true; },
+      [] {},
+      [&] {
+        device_.recover();
+        return true;
+      } );
+
+    loop.add_rule( "stop", stop_requested_, Direction::In, [&] { stop_requested_.drain(); } );
+
+    device_.start();
+
+    while ( not stopping_ and loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {
+    }
+  } catch ( ... ) {
+    /* hand the exception to the EventLoop thread, which rethrows it */
+    device_exception_ = current_exception();
+    device_failed_.store( true, memory_order_release );
+    capture_ready_.notify();
+  }
 }
 
 void AudioDeviceTask::service_device()
 {
-  device_.loopback( capture_, playback_ );
-  playback_.pop_before( device_.cursor() );
+  receive_playback();
+
+  const float gain = loopback_gain_.load( memory_order_relaxed );
+  if ( gain != applied_gain_ ) {
+    auto config = device_.config();
+    config.ch1_loopback_gain = { gain, gain };
+    config.ch2_loopback_gain = { gain, gain };
+    device_.set_config( config );
+    applied_gain_ = gain;
+  }
+
+  device_.loopback( device_capture_, device_playback_ );
+  device_playback_.pop_before( device_.cursor() );
+
+  if ( playback_received_ < device_.cursor() ) {
+    handoff_stats_.playback_underruns++;
+  }
+
+  send_capture();
+  publish_snapshot();
+}
+
+void AudioDeviceTask::receive_playback()
+{
+  const auto samples = playback_ring_.readable_region();
+  for ( size_t i = 0; i < samples.size(); i++ ) {
+    device_playback_.safe_set( playback_received_ + i, { samples[i].ch1, samples[i].ch2 } );
+  }
+  playback_received_ += samples.size();
+  playback_ring_.pop( samples.size() );
+}
+
+void AudioDeviceTask::send_capture()
+{
+  const size_t num_captured = device_.cursor() - capture_pushed_;
+  if ( num_captured == 0 ) {
+    return;
+  }
+
+  /* if the ring is full, the rest waits in device_capture_ for the next wakeup */
+  auto slots = capture_ring_.writable_region();
+  const size_t num_to_push = min( slots.size(), num_captured );
+  if ( num_to_push < num_captured ) {
+    handoff_stats_.capture_overruns++;
+  }
+
+  for ( size_t i = 0; i < num_to_push; i++ ) {
+    const auto [ch1, ch2] = device_capture_.safe_get( capture_pushed_ + i );
+    slots[i] = { ch1, ch2 };
+  }
+  capture_ring_.push( num_to_push );
+  capture_pushed_ += num_to_push;
+  device_capture_.pop_before( capture_pushed_ );
+
+  if ( num_to_push ) {
+    capture_ready_.notify();
+  }
+}
+
+void AudioDeviceTask::publish_snapshot()
+{
+  /* never block the device thread; if summary() holds the lock, publish on the next wakeup instead */
+  unique_lock<mutex> lock { snapshot_mutex_, try_to_lock };
+  if ( not lock ) {
+    return;
+  }
+
+  if ( reset_requested_.exchange( false ) ) {
+    device_.reset_statistics();
+    handoff_stats_ = {};
+  }
+
+  snapshot_ = { device_.statistics(), device_.config(), device_.cursor(), handoff_stats_ };
+}
+
+void AudioDeviceTask::receive_capture()
+{
+  capture_ready_.drain();
+
+  if ( device_failed_.load( memory_order_acquire ) ) {
+    rethrow_exception( device_exception_ );
+  }
+
+  const auto samples = capture_ring_.readable_region();
+  for ( size_t i = 0; i < samples.size(); i++ ) {
+    capture_.safe_set( cursor_ + i, { samples[i].ch1, samples[i].ch2 } );
+  }
+  cursor_ += samples.size();
+  capture_ring_.pop( samples.size() );
+}
+
+void AudioDeviceTask::commit_playback( const size_t end )
+{
+  if ( end <= playback_pushed_ ) {
+    return;
+  }
+
+  /* if the ring is full, the rest is handed over on the next call */
+  auto slots = playback_ring_.writable_region();
+  const size_t num_to_push = min( slots.size(), end - playback_pushed_ );
+  for ( size_t i = 0; i < num_to_push; i++ ) {
+    const auto [ch1, ch2] = playback_.safe_get( playback_pushed_ + i );
+    slots[i] = { ch1, ch2 };
+  }
+  playback_ring_.push( num_to_push );
+  playback_pushed_ += num_to_push;
+  playback_.pop_before( playback_pushed_ );
 }
 
 void AudioDeviceTask::summary( ostream& out ) const
 {
-  if ( device_.statistics().sample_stats.samples_counted ) {
+  DeviceSnapshot device;
+  {
+    lock_guard<mutex> lock { snapshot_mutex_ };
+    device = snapshot_;
+  }
+
+  const auto& stats = device.statistics;
+
+  if ( stats.sample_stats.samples_counted ) {
     out << "Audio info: dB = [ " << setw( 3 ) << setprecision( 1 ) << fixed
-        << float_to_dbfs(
-             sqrt( device_.statistics().sample_stats.ssa_ch1 / device_.statistics().sample_stats.samples_counted ) )
-        << "/" << setw( 3 ) << setprecision( 1 ) << fixed
-        << float_to_dbfs( device_.statistics().sample_stats.max_ch1_amplitude ) << ", ";
+        << float_to_dbfs( sqrt( stats.sample_stats.ssa_ch1 / stats.sample_stats.samples_counted ) ) << "/"
+        << setw( 3 ) << setprecision( 1 ) << fixed << float_to_dbfs( stats.sample_stats.max_ch1_amplitude )
+        << ", ";
 
     out << setw( 3 ) << setprecision( 1 ) << fixed
-        << float_to_dbfs(
-             sqrt( device_.statistics().sample_stats.ssa_ch2 / device_.statistics().sample_stats.samples_counted ) )
-        << "/" << setw( 3 ) << setprecision( 1 ) << fixed
-        << float_to_dbfs( device_.statistics().sample_stats.max_ch2_amplitude ) << " ]";
+        << float_to_dbfs( sqrt( stats.sample_stats.ssa_ch2 / stats.sample_stats.samples_counted ) ) << "/"
+        << setw( 3 ) << setprecision( 1 ) << fixed << float_to_dbfs( stats.sample_stats.max_ch2_amplitude )
+        << " ]";
   }
 
   out << " cursor=";
-  pp_samples( out, device_.cursor() );
-  if ( device_.cursor() - capture_.range_begin() > 120 ) {
+  pp_samples( out, device.cursor );
+  if ( cursor_ - capture_.range_begin() > 120 ) {
     out << " capture=";
-    pp_samples( out, device_.cursor() - capture_.range_begin() );
+    pp_samples( out, cursor_ - capture_.range_begin() );
   }
-  if ( device_.cursor() != playback_.range_begin() ) {
-    out << " playback=";
-    pp_samples( out, device_.cursor() - playback_.range_begin() );
+  if ( device.cursor > cursor_ + 120 ) {
+    out << " handoff=";
+    pp_samples( out, device.cursor - cursor_ );
   }
 
-  if ( device_.statistics().recoveries ) {
-    out << " recoveries=" << device_.statistics().recoveries;
+  if ( stats.recoveries ) {
+    out << " recoveries=" << stats.recoveries;
   }
 
-  if ( device_.statistics().last_recovery
-       and ( device_.cursor() - device_.statistics().last_recovery < 48000 * 60 ) ) {
+  if ( stats.last_recovery and ( device.cursor - stats.last_recovery < 48000 * 60 ) ) {
     out << " last recovery=";
-    pp_samples( out, device_.cursor() - device_.statistics().last_recovery );
-    out << " skipped=" << device_.statistics().sample_stats.samples_skipped;
+    pp_samples( out, device.cursor - stats.last_recovery );
+    out << " skipped=" << stats.sample_stats.samples_skipped;
   }
 
-  if ( device_.statistics().max_microphone_avail > 32 ) {
-    out << " mic<=" << device_.statistics().max_microphone_avail << "!";
+  if ( stats.max_microphone_avail > 32 ) {
+    out << " mic<=" << stats.max_microphone_avail << "!";
+  }
+  if ( stats.min_headphone_delay <= 6 ) {
+    out << " phone>=" << stats.min_headphone_delay << "!";
+  }
+  if ( stats.max_combined_samples > 64 ) {
+    out << " combined<=" << stats.max_combined_samples << "!";
   }
-  if ( device_.statistics().min_headphone_delay <= 6 ) {
-    out << " phone>=" << device_.statistics().min_headphone_delay << "!";
+  if ( stats.empty_wakeups ) {
+    out << " empty=" << stats.empty_wakeups << "/" << stats.total_wakeups << "!";
   }
-  if ( device_.statistics().max_combined_samples > 64 ) {
-    out << " combined<=" << device_.statistics().max_combined_samples << "!";
+  if ( device.handoff.capture_overruns ) {
+    out << " capture overruns=" << device.handoff.capture_overruns << "!";
   }
-  if ( device_.statistics().empty_wakeups ) {
-    out << " empty=" << device_.statistics().empty_wakeups << "/" << device_.statistics().total_wakeups << "!";
+  if ( device.handoff.playback_underruns ) {
+    out << " playback underruns=" << device.handoff.playback_underruns << "!";
   }
-  out << " loopback gains=" << device_.config().ch1_loopback_gain[0] << ":" << device_.config().ch1_loopback_gain[1]
-      << ":" << device_.config().ch2_loopback_gain[0] << ":" << device_.config().ch2_loopback_gain[1];
+  out << " loopback gains=" << device.config.ch1_loopback_gain[0] << ":" << device.config.ch1_loopback_gain[1]
+      << ":" << device.config.ch2_loopback_gain[0] << ":" << device.config.ch2_loopback_gain[1];
 }
 
 void AudioDeviceTask::set_loopback_gain( const float gain )
 {
-  auto config = device_.config();
-  config.ch1_loopback_gain = { gain, gain };
-  config.ch2_loopback_gain = { gain, gain };
-  device_.set_config( config );
+  loopback_gain_ = gain;
 }
 
 float AudioDeviceTask::loopback_gain() const
 {
-  return device_.config().ch1_loopback_gain.at( 0 );
+  return loopback_gain_;
 }
@@ -1,35 +1,99 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <exception>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <thread>
 
 #include "alsa_devices.hh"
+#include "eventfd.hh"
 #include "eventloop.hh"
+#include "spsc_ring_buffer.hh"
 #include "summarize.hh"
 
+//! Services the audio device on its own SCHED_FIFO thread
+//! \details The device thread owns the AudioPair. Captured samples travel to the EventLoop thread, and samples
+//! to be played travel to the device thread, through lock-free single-producer/single-consumer rings, so
+//! encoding, decoding and network work on the EventLoop thread cannot delay servicing of the device.
 class AudioDeviceTask : public Summarizable
 {
+  struct StereoSample
+  {
+    float ch1, ch2;
+  };
+
+  struct HandoffStatistics
+  {
+    unsigned int capture_overruns, playback_underruns;
+  };
+
+  struct DeviceSnapshot
+  {
+    AudioStatistics statistics {};
+    AudioInterface::Configuration config {};
+    size_t cursor {};
+    HandoffStatistics handoff {};
+  };
+
+  /* touched only by the device thread (once started) */
   AudioPair device_;
+  ChannelPair device_capture_ { 65536 }, device_playback_ { 65536 };
+  size_t capture_pushed_ {}, playback_received_ {};
+  float applied_gain_;
+  HandoffStatistics handoff_stats_ {};
+
+  /* shared between the two threads */
+  SPSCRingBuffer<StereoSample> capture_ring_ { 8192 }, playback_ring_ { 8192 };
+  EventFD capture_ready_ {}, stop_requested_ {};
+  std::atomic<bool> stopping_ {}, reset_requested_ {}, device_failed_ {};
+  std::atomic<float> loopback_gain_;
+  std::exception_ptr device_exception_ {};
+
+  mutable std::mutex snapshot_mutex_ {};
+  DeviceSnapshot snapshot_ {};
+
+  /* touched only by the EventLoop thread */
   ChannelPair capture_ { 65536 }, playback_ { 65536 };
+  size_t cursor_ {}, playback_pushed_ {};
+
+  std::thread device_thread_ {};
+
+  void device_thread_main();
   void service_device();
-  void install_rules( EventLoop& loop );
+  void receive_playback();
+  void send_capture();
+  void publish_snapshot();
+
+  void receive_capture();
 
 public:
   AudioDeviceTask( const std::string_view interface_name, EventLoop& loop );
+  ~AudioDeviceTask();
+
+  //! Start the audio device and the thread that services it
+  void start();
+
   void summary( std::ostream& out ) const override;
-  void reset_summary() override { device_.reset_statistics(); }
+  void reset_summary() override { reset_requested_ = true; }
 
-  AudioPair& device() { return device_; }
   ChannelPair& capture() { return capture_; }
   ChannelPair& playback() { return playback_; }
 
-  const AudioPair& device() const { return device_; }
   const ChannelPair& capture() const { return capture_; }
   const ChannelPair& playback() const { return playback_; }
 
-  size_t cursor() const { return device().cursor(); }
+  //! Number of captured samples handed to the EventLoop thread so far
+  size_t cursor() const { return cursor_; }
+
+  //! Hand every sample in playback() before `end` to the device thread; they must not be written again
+  void commit_playback( const size_t end );
 
   void set_loopback_gain( const float gain );
   float loopback_gain() const;
+
+  AudioDeviceTask( const AudioDeviceTask& other ) = delete;
+  AudioDeviceTask& operator=( const AudioDeviceTask& other ) = delete;
 };
@@ -0,0 +1,205 @@
+#include "conversion_kernel.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define CONVERSION_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static constexpr float full_scale = uint64_t( 1 ) << 31;
+
+/* the largest float below 2^31, so a full-scale positive sample can't wrap around to -2^31 */
+static constexpr float max_sample_value = 2147483520.0f;
+
+static void capture_portable_range( const int32_t* frames,
+                                    float* ch1,
+                                    float* ch2,
+                                    const size_t begin,
+                                    const size_t end,
+                                    BlockLevels& levels,
+                                    int32_t& low_bits )
+{
+  for ( size_t i = begin; i < end; i++ ) {
+    const int32_t left = frames[2 * i], right = frames[2 * i + 1];
+    low_bits |= left | right;
+
+    ch1[i] = left / full_scale;
+    ch2[i] = right / full_scale;
+
+    levels.max_ch1_amplitude = max( levels.max_ch1_amplitude, abs( ch1[i] ) );
+    levels.max_ch2_amplitude = max( levels.max_ch2_amplitude, abs( ch2[i] ) );
+    levels.ssa_ch1 += ch1[i] * ch1[i];
+    levels.ssa_ch2 += ch2[i] * ch2[i];
+  }
+}
+
+static bool capture_portable( const int32_t* frames,
+                              float* ch1,
+                              float* ch2,
+                              const size_t num_frames,
+                              BlockLevels& levels )
+{
+  levels = {};
+  int32_t low_bits = 0;
+  capture_portable_range( frames, ch1, ch2, 0, num_frames, levels, low_bits );
+  return not( low_bits & 0xff );
+}
+
+static void playback_portable_range( const float* ch1,
+                                     const float* ch2,
+                                     const float* playback1,
+                                     const float* playback2,
+                                     const LoopbackGains& gains,
+                                     int32_t* frames,
+                                     const size_t begin,
+                                     const size_t end )
+{
+  for ( size_t i = begin; i < end; i++ ) {
+    const float left = ch1[i] * gains.ch1_gain[0] + ch2[i] * gains.ch2_gain[0] + playback1[i];
+    const float right = ch1[i] * gains.ch1_gain[1] + ch2[i] * gains.ch2_gain[1] + playback2[i];
+
+    frames[2 * i] = lrint( clamp( left * full_scale, -full_scale, max_sample_value ) );
+    frames[2 * i + 1] = lrint( clamp( right * full_scale, -full_scale, max_sample_value ) );
+  }
+}
+
+static void playback_portable( const float* ch1,
+                               const float* ch2,
+                               const float* playback1,
+                               const float* playback2,
+                               const LoopbackGains& gains,
+                               int32_t* frames,
+                               const size_t num_frames )
+{
+  playback_portable_range( ch1, ch2, playback1, playback2, gains, frames, 0, num_frames );
+}
+
+#ifdef CONVERSION_KERNEL_X86
+__attribute__( ( target( "avx2" ) ) ) static float horizontal_max( const __m256 x )
+{
+  __m128 m = _mm_max_ps( _mm256_castps256_ps128( x ), _mm256_extractf128_ps( x, 1 ) );
+  m = _mm_max_ps( m, _mm_movehl_ps( m, m ) );
+  m = _mm_max_ss( m, _mm_shuffle_ps( m, m, 1 ) );
+  return _mm_cvtss_f32( m );
+}
+
+__attribute__( ( target( "avx2" ) ) ) static float horizontal_sum( const __m256 x )
+{
+  __m128 s = _mm_add_ps( _mm256_castps256_ps128( x ), _mm256_extractf128_ps( x, 1 ) );
+  s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+  s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+  return _mm_cvtss_f32( s );
+}
+
+/* 8 frames (two vectors of interleaved samples) per iteration */
+__attribute__( ( target( "avx2,fma" ) ) ) static bool capture_avx2( const int32_t* frames,
+                                                                    float* ch1,
+                                                                    float* ch2,
+                                                                    const size_t num_frames,
+                                                                    BlockLevels& levels )
+{
+  const __m256 scale = _mm256_set1_ps( 1.0f / full_scale );
+  const __m256 sign_bit = _mm256_set1_ps( -0.0f );
+
+  __m256i low_bits_v = _mm256_setzero_si256();
+  __m256 max1 = _mm256_setzero_ps(), max2 = _mm256_setzero_ps();
+  __m256 ssa1 = _mm256_setzero_ps(), ssa2 = _mm256_setzero_ps();
+
+  size_t i = 0;
+  for ( ; i + 8 <= num_frames; i += 8 ) {
+    const __m256i a = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( frames + 2 * i ) );
+    const __m256i b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( frames + 2 * i + 8 ) );
+    low_bits_v = _mm256_or_si256( low_bits_v, _mm256_or_si256( a, b ) );
+
+    /* exact: a sample with a clear low byte has only 24 significant bits */
+    const __m256 fa = _mm256_mul_ps( _mm256_cvtepi32_ps( a ), scale );
+    const __m256 fb = _mm256_mul_ps( _mm256_cvtepi32_ps( b ), scale );
+
+    /* the shuffle leaves the 64-bit pairs in order 0, 2, 1, 3; the permute puts them back */
+    const __m256 left = _mm256_castpd_ps( _mm256_permute4x64_pd(
+      _mm256_castps_pd( _mm256_shuffle_ps( fa, fb, _MM_SHUFFLE( 2, 0, 2, 0 ) ) ), _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+    const __m256 right = _mm256_castpd_ps( _mm256_permute4x64_pd(
+      _mm256_castps_pd( _mm256_shuffle_ps( fa, fb, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ), _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+
+    _mm256_storeu_ps( ch1 + i, left );
+    _mm256_storeu_ps( ch2 + i, right );
+
+    max1 = _mm256_max_ps( max1, _mm256_andnot_ps( sign_bit, left ) );
+    max2 = _mm256_max_ps( max2, _mm256_andnot_ps( sign_bit, right ) );
+    ssa1 = _mm256_fmadd_ps( left, left, ssa1 );
+    ssa2 = _mm256_fmadd_ps( right, right, ssa2 );
+  }
+
+  levels.max_ch1_amplitude = horizontal_max( max1 );
+  levels.max_ch2_amplitude = horizontal_max( max2 );
+  levels.ssa_ch1 = horizontal_sum( ssa1 );
+  levels.ssa_ch2 = horizontal_sum( ssa2 );
+
+  int32_t low_bits = 0;
+  capture_portable_range( frames, ch1, ch2, i, num_frames, levels, low_bits );
+
+  return not( low_bits & 0xff ) and _mm256_testz_si256( low_bits_v, _mm256_set1_epi32( 0xff ) );
+}
+
+/* 8 frames per iteration */
+__attribute__( ( target( "avx2,fma" ) ) ) static void playback_avx2( const float* ch1,
+                                                                     const float* ch2,
+                                                                     const float* playback1,
+                                                                     const float* playback2,
+                                                                     const LoopbackGains& gains,
+                                                                     int32_t* frames,
+                                                                     const size_t num_frames )
+{
+  const __m256 g1_left = _mm256_set1_ps( gains.ch1_gain[0] ), g1_right = _mm256_set1_ps( gains.ch1_gain[1] );
+  const __m256 g2_left = _mm256_set1_ps( gains.ch2_gain[0] ), g2_right = _mm256_set1_ps( gains.ch2_gain[1] );
+  const __m256 scale = _mm256_set1_ps( full_scale );
+  const __m256 lowest = _mm256_set1_ps( -full_scale ), highest = _mm256_set1_ps( max_sample_value );
+
+  size_t i = 0;
+  for ( ; i + 8 <= num_frames; i += 8 ) {
+    const __m256 c1 = _mm256_loadu_ps( ch1 + i ), c2 = _mm256_loadu_ps( ch2 + i );
+
+    __m256 left = _mm256_fmadd_ps( c1, g1_left, _mm256_fmadd_ps( c2, g2_left, _mm256_loadu_ps( playback1 + i ) ) );
+    __m256 right
+      = _mm256_fmadd_ps( c1, g1_right, _mm256_fmadd_ps( c2, g2_right, _mm256_loadu_ps( playback2 + i ) ) );
+
+    left = _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( left, scale ), lowest ), highest );
+    right = _mm256_min_ps( _mm256_max_ps( _mm256_mul_ps( right, scale ), lowest ), highest );
+
+    /* round to nearest (as lrint does), then interleave: unpack works within each 128-bit lane */
+    const __m256i left_i = _mm256_cvtps_epi32( left ), right_i = _mm256_cvtps_epi32( right );
+    const __m256i low = _mm256_unpacklo_epi32( left_i, right_i ), high = _mm256_unpackhi_epi32( left_i, right_i );
+
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( frames + 2 * i ),
+                         _mm256_permute2x128_si256( low, high, 0x20 ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( frames + 2 * i + 8 ),
+                         _mm256_permute2x128_si256( low, high, 0x31 ) );
+  }
+
+  playback_portable_range( ch1, ch2, playback1, playback2, gains, frames, i, num_frames );
+}
+#endif
+
+const ConversionKernel& ConversionKernel::portable()
+{
+  static const ConversionKernel kernel { capture_portable, playback_portable, "portable" };
+  return kernel;
+}
+
+const ConversionKernel& ConversionKernel::best()
+{
+  static const ConversionKernel kernel = [] {
+#ifdef CONVERSION_KERNEL_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) and __builtin_cpu_supports( "fma" ) ) {
+      return ConversionKernel { capture_avx2, playback_avx2, "avx2" };
+    }
+#endif
+    return portable();
+  }();
+  return kernel;
+}
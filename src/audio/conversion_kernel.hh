@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//! Peak and energy of one block of captured samples
+struct BlockLevels
+{
+  float max_ch1_amplitude, max_ch2_amplitude;
+  float ssa_ch1, ssa_ch2;
+};
+
+//! Loopback matrix: out[side] = ch1 * ch1_gain[side] + ch2 * ch2_gain[side] + playback[side]
+struct LoopbackGains
+{
+  std::array<float, 2> ch1_gain, ch2_gain;
+};
+
+//! Converts between ALSA's interleaved S32 frames and a pair of float channels, a block at a time.
+//! \details The implementation (AVX2 or portable) is chosen once at runtime from the CPU's features.
+class ConversionKernel
+{
+  using CaptureImplementation = bool ( * )( const int32_t* frames,
+                                            float* ch1,
+                                            float* ch2,
+                                            const size_t num_frames,
+                                            BlockLevels& levels );
+
+  using PlaybackImplementation = void ( * )( const float* ch1,
+                                             const float* ch2,
+                                             const float* playback1,
+                                             const float* playback2,
+                                             const LoopbackGains& gains,
+                                             int32_t* frames,
+                                             const size_t num_frames );
+
+  CaptureImplementation capture_;
+  PlaybackImplementation playback_;
+  const char* name_;
+
+  ConversionKernel( const CaptureImplementation capture_impl,
+                    const PlaybackImplementation playback_impl,
+                    const char* name )
+    : capture_( capture_impl )
+    , playback_( playback_impl )
+    , name_( name )
+  {}
+
+public:
+  //! The best implementation for this machine
+  static const ConversionKernel& best();
+
+  //! Sample-at-a-time loop without explicit SIMD (the reference)
+  static const ConversionKernel& portable();
+
+  //! Deinterleave S32 frames into [-1, 1) floats and measure the block's levels
+  //! \returns false if any sample has bits set below the top 24 (which the device should never produce)
+  bool capture( const int32_t* frames, float* ch1, float* ch2, const size_t num_frames, BlockLevels& levels ) const
+  {
+    return capture_( frames, ch1, ch2, num_frames, levels );
+  }
+
+  //! Apply the loopback matrix, clamp to full scale, round, and interleave into S32 frames
+  void playback( const float* ch1,
+                 const float* ch2,
+                 const float* playback1,
+                 const float* playback2,
+                 const LoopbackGains& gains,
+                 int32_t* frames,
+                 const size_t num_frames ) const
+  {
+    playback_( ch1, ch2, playback1, playback2, gains, frames, num_frames );
+  }
+
+  const char* name() const { return name_; }
+};
@@ -84,6 +84,32 @@ OpusEncoderProcess::TrackedEncoder::TrackedEncoder( const int bit_rate,
 void OpusEncoderProcess::TrackedEncoder::reset( const int bit_rate, const int sample_rate )
 {
   enc_ = { bit_rate, sample_rate, channel_count_, OPUS_APPLICATION_RESTRICTED_LOWDELAY };
+  if ( expected_loss_percent_ ) {
+    enc_.set_expected_loss( expected_loss_percent_ );
+  }
+  if ( complexity_.has_value() ) {
+    enc_.set_complexity( complexity_.value() );
+  }
+}
+
+void OpusEncoderProcess::TrackedEncoder::set_complexity( const int complexity )
+{
+  if ( complexity < 0 or complexity > 10 ) {
+    throw runtime_error( "Opus complexity must be between 0 and 10" );
+  }
+
+  complexity_ = complexity;
+  enc_.set_complexity( complexity );
+}
+
+void OpusEncoderProcess::TrackedEncoder::set_expected_loss( const int percent )
+{
+  if ( percent < 0 or percent > 100 ) {
+    throw runtime_error( "expected loss must be between 0 and 100 percent" );
+  }
+
+  expected_loss_percent_ = percent;
+  enc_.set_expected_loss( percent );
 }
 
 size_t OpusEncoderProcess::min_encode_cursor() const
@@ -138,6 +164,27 @@ void OpusEncoderProcess::reset( const int bit_rate1, const int bit_rate2, const
   enc2_.value().reset( bit_rate2, sample_rate );
 }
 
+void OpusEncoderProcess::set_expected_loss( const int percent )
+{
+  enc1_.set_expected_loss( percent );
+  if ( enc2_.has_value() ) {
+    enc2_->set_expected_loss( percent );
+  }
+}
+
+void OpusEncoderProcess::set_bitrate( const int bit_rate1 )
+{
+  enc1_.set_bitrate( bit_rate1 );
+}
+
+void OpusEncoderProcess::set_complexity( const int complexity )
+{
+  enc1_.set_complexity( complexity );
+  if ( enc2_.has_value() ) {
+    enc2_->set_complexity( complexity );
+  }
+}
+
 void OpusEncoderProcess::encode_one_frame( const AudioChannel& ch1, const AudioChannel& ch2 )
 {
   if ( enc2_.has_value() ) {
@@ -151,11 +198,16 @@ void OpusEncoderProcess::encode_one_frame( const AudioChannel& ch1, const AudioC
 AudioFrame OpusEncoderProcess::front( const uint32_t frame_index ) const
 {
   AudioFrame ret;
-  ret.frame_index = frame_index;
-  ret.separate_channels = enc2_.has_value();
-  ret.frame1 = enc1_.output().value();
+  front( frame_index, ret );
+  return ret;
+}
+
+void OpusEncoderProcess::front( const uint32_t frame_index, AudioFrame& out ) const
+{
+  out.frame_index = frame_index;
+  out.separate_channels = enc2_.has_value();
+  out.frame1 = enc1_.output().value();
   if ( enc2_.has_value() ) {
-    ret.frame2 = enc2_.value().output().value();
+    out.frame2 = enc2_.value().output().value();
   }
-  return ret;
 }
@@ -11,6 +11,8 @@ class OpusEncoderProcess
   class TrackedEncoder
   {
     int channel_count_;
+    int expected_loss_percent_ {};
+    std::optional<int> complexity_ {};
     OpusEncoder enc_;
     std::optional<opus_frame> output_ {};
     size_t num_pushed_ {};
@@ -27,6 +29,9 @@ class OpusEncoderProcess
     const std::optional<opus_frame>& output() const { return output_; }
 
     void reset( const int bit_rate, const int sample_rate );
+    void set_expected_loss( const int percent );
+    void set_bitrate( const int bit_rate ) { enc_.set_bitrate( bit_rate ); }
+    void set_complexity( const int complexity );
   };
 
   size_t num_popped_ {};
@@ -45,11 +50,23 @@ public:
   void reset( const int bit_rate1, const int sample_rate );
   void reset( const int bit_rate1, const int bit_rate2, const int sample_rate );
 
+  //! Enable Opus in-band FEC with a packet-loss hint (in percent), or disable it with 0; survives reset()
+  void set_expected_loss( const int percent );
+
+  //! Change the bit rate of the first (or only) encoder without resetting it; a second channel keeps its rate
+  void set_bitrate( const int bit_rate1 );
+
+  //! Change every encoder's complexity (0 to 10) without resetting it; survives reset()
+  void set_complexity( const int complexity );
+
   size_t min_encode_cursor() const;
   size_t frame_index() const { return num_popped_; }
 
   AudioFrame front( const uint32_t frame_index ) const;
 
+  //! Write the next frame straight into `out` (the sender's own storage for it)
+  void front( const uint32_t frame_index, AudioFrame& out ) const;
+
   void encode_one_frame( const AudioChannel& ch1, const AudioChannel& ch2 );
 };
 
@@ -0,0 +1,171 @@
+#include "mix_kernel.hh"
+
+#include <stdexcept>
+#include <string>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define MIX_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+static void mix_portable_range( const MixInput* inputs,
+                                const size_t num_inputs,
+                                float* ch1,
+                                float* ch2,
+                                const size_t begin,
+                                const size_t end )
+{
+  for ( size_t input_i = 0; input_i < num_inputs; input_i++ ) {
+    const float* src = inputs[input_i].samples;
+    const float gain_into_1 = inputs[input_i].gain_into_1;
+    const float gain_into_2 = inputs[input_i].gain_into_2;
+    for ( size_t sample_i = begin; sample_i < end; sample_i++ ) {
+      ch1[sample_i] += gain_into_1 * src[sample_i];
+      ch2[sample_i] += gain_into_2 * src[sample_i];
+    }
+  }
+}
+
+static void mix_portable( const MixInput* inputs,
+                          const size_t num_inputs,
+                          float* ch1,
+                          float* ch2,
+                          const size_t num_samples )
+{
+  mix_portable_range( inputs, num_inputs, ch1, ch2, 0, num_samples );
+}
+
+#ifdef MIX_KERNEL_X86
+/* 4 x 8 samples per iteration for each side, so eight independent FMA chains are in flight */
+__attribute__( ( target( "avx2,fma" ) ) ) static void mix_avx2( const MixInput* inputs,
+                                                                const size_t num_inputs,
+                                                                float* ch1,
+                                                                float* ch2,
+                                                                const size_t num_samples )
+{
+  size_t sample_i = 0;
+
+  for ( ; sample_i + 32 <= num_samples; sample_i += 32 ) {
+    __m256 a1[4], a2[4];
+    for ( unsigned int k = 0; k < 4; k++ ) {
+      a1[k] = _mm256_loadu_ps( ch1 + sample_i + 8 * k );
+      a2[k] = _mm256_loadu_ps( ch2 + sample_i + 8 * k );
+    }
+
+    for ( size_t input_i = 0; input_i < num_inputs; input_i++ ) {
+      const __m256 g1 = _mm256_set1_ps( inputs[input_i].gain_into_1 );
+      const __m256 g2 = _mm256_set1_ps( inputs[input_i].gain_into_2 );
+      const float* src = inputs[input_i].samples + sample_i;
+      for ( unsigned int k = 0; k < 4; k++ ) {
+        const __m256 value = _mm256_loadu_ps( src + 8 * k );
+        a1[k] = _mm256_fmadd_ps( g1, value, a1[k] );
+        a2[k] = _mm256_fmadd_ps( g2, value, a2[k] );
+      }
+    }
+
+    for ( unsigned int k = 0; k < 4; k++ ) {
+      _mm256_storeu_ps( ch1 + sample_i + 8 * k, a1[k] );
+      _mm256_storeu_ps( ch2 + sample_i + 8 * k, a2[k] );
+    }
+  }
+
+  for ( ; sample_i + 8 <= num_samples; sample_i += 8 ) {
+    __m256 a1 = _mm256_loadu_ps( ch1 + sample_i );
+    __m256 a2 = _mm256_loadu_ps( ch2 + sample_i );
+
+    for ( size_t input_i = 0; input_i < num_inputs; input_i++ ) {
+      const __m256 value = _mm256_loadu_ps( inputs[input_i].samples + sample_i );
+      a1 = _mm256_fmadd_ps( _mm256_set1_ps( inputs[input_i].gain_into_1 ), value, a1 );
+      a2 = _mm256_fmadd_ps( _mm256_set1_ps( inputs[input_i].gain_into_2 ), value, a2 );
+    }
+
+    _mm256_storeu_ps( ch1 + sample_i, a1 );
+    _mm256_storeu_ps( ch2 + sample_i, a2 );
+  }
+
+  mix_portable_range( inputs, num_inputs, ch1, ch2, sample_i, num_samples );
+}
+
+__attribute__( ( target( "sse2" ) ) ) static void mix_sse( const MixInput* inputs,
+                                                           const size_t num_inputs,
+                                                           float* ch1,
+                                                           float* ch2,
+                                                           const size_t num_samples )
+{
+  size_t sample_i = 0;
+
+  for ( ; sample_i + 16 <= num_samples; sample_i += 16 ) {
+    __m128 a1[4], a2[4];
+    for ( unsigned int k = 0; k < 4; k++ ) {
+      a1[k] = _mm_loadu_ps( ch1 + sample_i + 4 * k );
+      a2[k] = _mm_loadu_ps( ch2 + sample_i + 4 * k );
+    }
+
+    for ( size_t input_i = 0; input_i < num_inputs; input_i++ ) {
+      const __m128 g1 = _mm_set1_ps( inputs[input_i].gain_into_1 );
+      const __m128 g2 = _mm_set1_ps( inputs[input_i].gain_into_2 );
+      const float* src = inputs[input_i].samples + sample_i;
+      for ( unsigned int k = 0; k < 4; k++ ) {
+        const __m128 value = _mm_loadu_ps( src + 4 * k );
+        a1[k] = _mm_add_ps( a1[k], _mm_mul_ps( g1, value ) );
+        a2[k] = _mm_add_ps( a2[k], _mm_mul_ps( g2, value ) );
+      }
+    }
+
+    for ( unsigned int k = 0; k < 4; k++ ) {
+      _mm_storeu_ps( ch1 + sample_i + 4 * k, a1[k] );
+      _mm_storeu_ps( ch2 + sample_i + 4 * k, a2[k] );
+    }
+  }
+
+  for ( ; sample_i + 4 <= num_samples; sample_i += 4 ) {
+    __m128 a1 = _mm_loadu_ps( ch1 + sample_i );
+    __m128 a2 = _mm_loadu_ps( ch2 + sample_i );
+
+    for ( size_t input_i = 0; input_i < num_inputs; input_i++ ) {
+      const __m128 value = _mm_loadu_ps( inputs[input_i].samples + sample_i );
+      a1 = _mm_add_ps( a1, _mm_mul_ps( _mm_set1_ps( inputs[input_i].gain_into_1 ), value ) );
+      a2 = _mm_add_ps( a2, _mm_mul_ps( _mm_set1_ps( inputs[input_i].gain_into_2 ), value ) );
+    }
+
+    _mm_storeu_ps( ch1 + sample_i, a1 );
+    _mm_storeu_ps( ch2 + sample_i, a2 );
+  }
+
+  mix_portable_range( inputs, num_inputs, ch1, ch2, sample_i, num_samples );
+}
+#endif
+
+const MixKernel& MixKernel::portable()
+{
+  static const MixKernel kernel { mix_portable, "portable" };
+  return kernel;
+}
+
+const MixKernel& MixKernel::best()
+{
+  static const MixKernel kernel = [] {
+#ifdef MIX_KERNEL_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) and __builtin_cpu_supports( "fma" ) ) {
+      return MixKernel { mix_avx2, "avx2" };
+    }
+    if ( __builtin_cpu_supports( "sse2" ) ) {
+      return MixKernel { mix_sse, "sse2" };
+    }
+#endif
+    return portable();
+  }();
+  return kernel;
+}
+
+void MixKernel::mix( const span_view<MixInput> inputs, span<float> ch1, span<float> ch2 ) const
+{
+  if ( ch1.size() != ch2.size() ) {
+    throw runtime_error( "MixKernel::mix: ch1 and ch2 have different lengths" );
+  }
+
+  impl_( inputs.data(), inputs.size(), ch1.mutable_data(), ch2.mutable_data(), ch1.size() );
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+
+#include "spans.hh"
+
+//! One channel to be summed into a stereo target, with its gain into each side.
+struct MixInput
+{
+  const float* samples;
+  float gain_into_1, gain_into_2;
+};
+
+//! Sums N mono channels into a stereo pair in one pass (ch1 += gain_into_1 * x, ch2 += gain_into_2 * x).
+//! \details The implementation (AVX2, SSE, or portable) is chosen once at runtime from the CPU's features.
+class MixKernel
+{
+  using Implementation = void ( * )( const MixInput* inputs,
+                                     const size_t num_inputs,
+                                     float* ch1,
+                                     float* ch2,
+                                     const size_t num_samples );
+
+  Implementation impl_;
+  const char* name_;
+
+  MixKernel( const Implementation impl, const char* name )
+    : impl_( impl )
+    , name_( name )
+  {}
+
+public:
+  //! The best implementation for this machine
+  static const MixKernel& best();
+
+  //! Channel-at-a-time loop without explicit SIMD (the reference)
+  static const MixKernel& portable();
+
+  void mix( const span_view<MixInput> inputs, span<float> ch1, span<float> ch2 ) const;
+
+  const char* name() const { return name_; }
+};
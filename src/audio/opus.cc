@@ -93,6 +93,22 @@ void OpusEncoder::encode_stereo( const span_view<float> ch1,
                                                         encoded_output.capacity() ) ) );
 }
 
+void OpusEncoder::set_bitrate( const int bit_rate )
+{
+  opus_check( opus_encoder_ctl( encoder_.get(), OPUS_SET_BITRATE( bit_rate ) ) );
+}
+
+void OpusEncoder::set_complexity( const int complexity )
+{
+  opus_check( opus_encoder_ctl( encoder_.get(), OPUS_SET_COMPLEXITY( complexity ) ) );
+}
+
+void OpusEncoder::set_expected_loss( const int percent )
+{
+  opus_check( opus_encoder_ctl( encoder_.get(), OPUS_SET_INBAND_FEC( percent > 0 ) ) );
+  opus_check( opus_encoder_ctl( encoder_.get(), OPUS_SET_PACKET_LOSS_PERC( percent ) ) );
+}
+
 void OpusDecoder::decoder_deleter::operator()( OpusDecoder* x ) const
 {
   opus_decoder_destroy( x );
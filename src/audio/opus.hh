@@ -27,6 +27,15 @@ public:
   OpusEncoder( const int bit_rate, const int sample_rate, const int channels, const int application );
   void encode( const span_view<float> samples, opus_frame& encoded_output );
   void encode_stereo( const span_view<float> ch1, const span_view<float> ch2, opus_frame& encoded_output );
+
+  //! Change the bit rate or complexity (0 to 10) of the running encoder, keeping its state
+  void set_bitrate( const int bit_rate );
+  void set_complexity( const int complexity );
+
+  //! Tell the encoder what fraction of frames to expect to be lost (0 to 100), and enable in-band FEC if any
+  //! \details In-band FEC (LBRR) only exists in SILK frames; for 2.5 ms CELT frames the hint instead makes
+  //! each frame depend less on its predecessors, so the decoder recovers faster after a loss.
+  void set_expected_loss( const int percent );
 };
 
 class OpusDecoder
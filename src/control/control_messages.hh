@@ -44,17 +44,13 @@ struct set_cursor_lag : public control_message<0>
   {
     s.object( feed );
     s.object( name );
-    s.integer( target_samples );
-    s.integer( min_samples );
-    s.integer( max_samples );
+    s.fixed( target_samples, min_samples, max_samples );
   }
   void parse( Parser& p )
   {
     p.object( feed );
     p.object( name );
-    p.integer( target_samples );
-    p.integer( min_samples );
-    p.integer( max_samples );
+    p.fixed( target_samples, min_samples, max_samples );
   }
 };
 
@@ -71,15 +67,13 @@ struct set_gain : public control_message<1>
   {
     s.object( board_name );
     s.object( channel_name );
-    s.floating( gain1 );
-    s.floating( gain2 );
+    s.fixed( gain1, gain2 );
   }
   void parse( Parser& p )
   {
     p.object( board_name );
     p.object( channel_name );
-    p.floating( gain1 );
-    p.floating( gain2 );
+    p.fixed( gain1, gain2 );
   }
 };
 
@@ -102,29 +96,14 @@ struct client_report : public control_message<3>
 
   static constexpr uint32_t serialized_length()
   {
-    return sizeof( uint32_t ) + 4 * sizeof( uint16_t ) + 2 * sizeof( float );
+    return wire::size_of<uint32_t, uint16_t, uint16_t, uint16_t, float, float, float>;
   }
 
   void serialize( Serializer& s ) const
   {
-    s.integer( resets );
-    s.integer( target_lag );
-    s.integer( min_lag );
-    s.integer( max_lag );
-    s.floating( actual_lag );
-    s.floating( quality );
-    s.floating( self_gain );
-  }
-  void parse( Parser& p )
-  {
-    p.integer( resets );
-    p.integer( target_lag );
-    p.integer( min_lag );
-    p.integer( max_lag );
-    p.floating( actual_lag );
-    p.floating( quality );
-    p.floating( self_gain );
+    s.fixed( resets, target_lag, min_lag, max_lag, actual_lag, quality, self_gain );
   }
+  void parse( Parser& p ) { p.fixed( resets, target_lag, min_lag, max_lag, actual_lag, quality, self_gain ); }
 };
 
 struct video_control : public control_message<4>
@@ -137,18 +116,12 @@ struct video_control : public control_message<4>
   void serialize( Serializer& s ) const
   {
     s.object( name );
-    s.integer( x );
-    s.integer( y );
-    s.integer( width );
-    s.integer( height );
+    s.fixed( x, y, width, height );
   }
 
   void parse( Parser& p )
   {
     p.object( name );
-    p.integer( x );
-    p.integer( y );
-    p.integer( width );
-    p.integer( height );
+    p.fixed( x, y, width, height );
   }
 };
@@ -81,7 +81,24 @@ CryptoSession::CryptoSession( CryptoSession&& other )
 void CryptoSession::encrypt( const string_view associated_data, const Plaintext& plaintext, Ciphertext& ciphertext )
 {
   plaintext.validate();
+  encrypt( associated_data, plaintext.data_ptr(), plaintext.length(), ciphertext );
+}
 
+void CryptoSession::encrypt_in_place( const string_view associated_data, Ciphertext& buffer )
+{
+  if ( buffer.length() > Plaintext::capacity() ) {
+    throw runtime_error( "no room to encrypt in place: " + to_string( buffer.length() ) + " > "
+                         + to_string( Plaintext::capacity() ) );
+  }
+
+  encrypt( associated_data, buffer.data_ptr(), buffer.length(), buffer );
+}
+
+void CryptoSession::encrypt( const string_view associated_data,
+                             const char* plaintext,
+                             const size_t plaintext_len,
+                             Ciphertext& ciphertext )
+{
   if ( randomize_nonce_ ) {
     set_random_nonce();
   } else {
@@ -90,7 +107,7 @@ void CryptoSession::encrypt( const string_view associated_data, const Plaintext&
 
   Nonce nonce { nonce_val_ };
 
-  const int ciphertext_len = plaintext.length() + TAG_LEN;
+  const int ciphertext_len = plaintext_len + TAG_LEN;
 
   ciphertext.resize( ciphertext_len + Nonce::SERIALIZED_LEN + associated_data.size() );
 
@@ -102,8 +119,8 @@ void CryptoSession::encrypt( const string_view associated_data, const Plaintext&
   if ( ciphertext_len
        != ae_encrypt( encrypt_context_.get(),        /* ctx */
                       nonce.data().data(),           /* nonce */
-                      plaintext.data_ptr(),          /* pt */
-                      plaintext.length(),            /* pt_len */
+                      plaintext,                     /* pt */
+                      plaintext_len,                 /* pt_len */
                       associated_data.data(),        /* ad */
                       associated_data.size(),        /* ad_len */
                       ciphertext.mutable_data_ptr(), /* ct */
@@ -113,8 +130,8 @@ void CryptoSession::encrypt( const string_view associated_data, const Plaintext&
   }
 
   /* track use of key per RFC 7253 */
-  blocks_encrypted_ += plaintext.length() >> 4;
-  if ( plaintext.length() & 0xF ) {
+  blocks_encrypted_ += plaintext_len >> 4;
+  if ( plaintext_len & 0xF ) {
     /* partial block */
     blocks_encrypted_++;
   }
@@ -134,29 +151,57 @@ bool CryptoSession::decrypt( const Ciphertext& ciphertext,
     return false;
   }
 
-  const int body_len = ciphertext.length() - Nonce::SERIALIZED_LEN - expected_associated_data.size();
-
-  const int pt_len = body_len - TAG_LEN;
+  const int pt_len = ciphertext.length() - Nonce::SERIALIZED_LEN - expected_associated_data.size() - TAG_LEN;
   plaintext.resize( pt_len );
 
+  return decrypt( ciphertext, pt_len, expected_associated_data, plaintext.mutable_data_ptr() );
+}
+
+bool CryptoSession::decrypt_in_place( Ciphertext& buffer, const string_view expected_associated_data ) const
+{
+  buffer.validate();
+
+  if ( buffer.length() < TAG_LEN + Nonce::SERIALIZED_LEN + expected_associated_data.size() ) {
+    return false;
+  }
+
+  const int pt_len = buffer.length() - Nonce::SERIALIZED_LEN - expected_associated_data.size() - TAG_LEN;
+
+  if ( not decrypt( buffer, pt_len, expected_associated_data, buffer.mutable_data_ptr() ) ) {
+    return false;
+  }
+
+  buffer.resize( pt_len );
+  return true;
+}
+
+bool CryptoSession::decrypt( const Ciphertext& ciphertext,
+                             const size_t plaintext_len,
+                             const string_view expected_associated_data,
+                             char* plaintext ) const
+{
+  const int body_len = plaintext_len + TAG_LEN;
+
+  /* the trailer lies beyond the plaintext, so decrypting in place leaves it intact */
   Nonce nonce { static_cast<string_view>( ciphertext ).substr( body_len, Nonce::SERIALIZED_LEN ) };
 
-  if ( pt_len
+  const string_view actual_associated_data { static_cast<string_view>( ciphertext )
+                                               .substr( body_len + Nonce::SERIALIZED_LEN,
+                                                        expected_associated_data.size() ) };
+
+  if ( int( plaintext_len )
        != ae_decrypt( decrypt_context_.get(),          /* ctx */
                       nonce.data().data(),             /* nonce */
                       ciphertext.data_ptr(),           /* ct */
                       body_len,                        /* ct_len */
                       expected_associated_data.data(), /* ad */
                       expected_associated_data.size(), /* ad_len */
-                      plaintext.mutable_data_ptr(),    /* pt */
+                      plaintext,                       /* pt */
                       nullptr,                         /* tag */
                       AE_FINALIZE ) ) {                /* final */
     return false;
   }
 
-  const string_view actual_associated_data { static_cast<string_view>( ciphertext )
-                                               .substr( body_len + Nonce::SERIALIZED_LEN,
-                                                        expected_associated_data.size() ) };
   if ( actual_associated_data != expected_associated_data ) {
     throw runtime_error( "associated data mismatch" );
   }
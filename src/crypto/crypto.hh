@@ -44,6 +44,16 @@ class CryptoSession
 
   std::unique_ptr<ae_ctx, ae_deleter> encrypt_context_, decrypt_context_;
 
+  /* plaintext may equal ciphertext.data_ptr() (OCB can encrypt and decrypt in place) */
+  void encrypt( const std::string_view associated_data,
+                const char* plaintext,
+                const size_t plaintext_len,
+                Ciphertext& ciphertext );
+  bool decrypt( const Ciphertext& ciphertext,
+                const size_t plaintext_len,
+                const std::string_view expected_associated_data,
+                char* plaintext ) const;
+
 public:
   static constexpr uint8_t TAG_LEN = 16;
 
@@ -55,6 +65,14 @@ public:
                 const std::string_view expected_associated_data,
                 Plaintext& plaintext ) const;
 
+  //! Encrypt the plaintext that fills `buffer`, in place, then append the tag, nonce and associated data
+  //! \details The plaintext may be up to Plaintext::capacity() bytes, leaving room for what's appended.
+  void encrypt_in_place( const std::string_view associated_data, Ciphertext& buffer );
+
+  //! Decrypt `buffer` in place; on success, `buffer` holds just the plaintext
+  //! \details On failure the contents of `buffer` are lost, so only use this when no other key will be tried.
+  bool decrypt_in_place( Ciphertext& buffer, const std::string_view expected_associated_data ) const;
+
   CryptoSession( const CryptoSession& other ) = delete;
   CryptoSession& operator=( const CryptoSession& other ) = delete;
 
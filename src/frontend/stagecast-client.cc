@@ -56,6 +56,7 @@ void program_body( const string& host, const string& service, const string& key_
   /* Network client registers itself in EventLoop */
   const Address stagecast_server { host, service };
   auto network_client = make_shared<NetworkClient>( stagecast_server, key, encoder, uac2, *loop );
+  network_client->set_fec( getenv( "STAGECAST_AUDIO_FEC" ) );
 
   /* Controller registers itself in EventLoop */
   ClientController controller { network_client, uac2, *loop };
@@ -69,9 +70,14 @@ void program_body( const string& host, const string& service, const string& key_
   const uint64_t update_interval = 50'000'000;
   uint64_t next_update = Timer::timestamp_ns() + update_interval;
   NetString update_str;
-  loop->add_rule(
+  loop->add_timed_rule(
     "stats update",
     [&] {
+      next_update = Timer::timestamp_ns() + update_interval;
+      if ( not network_client->has_session() ) {
+        return;
+      }
+
       client_report report;
       report.resets = network_client->cursor().stats().resets;
       report.target_lag
@@ -89,12 +95,11 @@ void program_body( const string& host, const string& service, const string& key_
       update_str.resize( s.bytes_written() );
 
       network_client->queue_update( update_str );
-      next_update = Timer::timestamp_ns() + update_interval;
     },
-    [&] { return network_client->has_session() and ( Timer::timestamp_ns() > next_update ); } );
+    [&] { return next_update; } );
 
   /* Start audio device and event loop */
-  uac2->device().start();
+  uac2->start();
   while ( loop->wait_next_event( -1 ) != EventLoop::Result::Exit ) {
   }
 }
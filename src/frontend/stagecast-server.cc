@@ -21,8 +21,17 @@ void program_body( const vector<string>& keyfiles )
 
   auto loop = make_shared<EventLoop>();
 
+  /* Per-client decode and encode are spread across worker threads (default: one per spare CPU) */
+  const char* worker_threads_env = getenv( "STAGECAST_SERVER_WORKER_THREADS" );
+  const size_t worker_threads = worker_threads_env ? stoul( worker_threads_env )
+                                                   : max( 1U, thread::hardware_concurrency() ) - 1;
+
   /* Network server registeres itself in EventLoop */
-  auto server = make_shared<NetworkMultiServer>( keyfiles.size(), *loop );
+  auto server = make_shared<NetworkMultiServer>( keyfiles.size(), *loop, worker_threads );
+
+  /* XOR parity with each client's audio, so one lost frame in each group of four is rebuilt without waiting
+     for a retransmission */
+  server->set_fec( getenv( "STAGECAST_AUDIO_FEC" ) );
 
   for ( const auto& filename : keyfiles ) {
     ReadOnlyFile file { filename };
@@ -49,10 +58,8 @@ void program_body( const vector<string>& keyfiles )
   uint64_t next_json_update = Timer::timestamp_ns() + json_update_interval;
   Json::Value root;
   ostringstream json_str;
-  loop->add_rule(
+  loop->add_timed_rule(
     "JSON update",
-    json_updates,
-    Direction::Out,
     [&] {
       root.clear();
       json_str.str( "" );
@@ -62,10 +69,10 @@ void program_body( const vector<string>& keyfiles )
       json_updates.sendto_ignore_errors( json_update_address, json_str.str() );
       next_json_update = Timer::timestamp_ns() + json_update_interval;
     },
-    [&] { return Timer::timestamp_ns() > next_json_update; } );
+    [&] { return next_json_update; } );
 
   /* Start audio device and event loop */
-  while ( loop->wait_next_event( 1 ) != EventLoop::Result::Exit ) {
+  while ( loop->wait_next_event( -1 ) != EventLoop::Result::Exit ) {
   }
 }
 
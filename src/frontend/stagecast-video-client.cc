@@ -8,18 +8,16 @@
 #include <unistd.h>
 
 #include "address.hh"
-#include "camera.hh"
 #include "connection.hh"
 #include "crypto.hh"
 #include "eventloop.hh"
 #include "exception.hh"
-#include "h264_encoder.hh"
 #include "keys.hh"
-#include "scale.hh"
 #include "socket.hh"
 #include "stats_printer.hh"
 #include "timer.hh"
 #include "video_source.hh"
+#include "video_pipeline.hh"
 #include "videoclient.hh"
 
 using namespace std;
@@ -30,13 +28,6 @@ void program_body( const string& device, const string& host, const string& servi
 
   FileDescriptor output { CheckSystemCall( "dup STDERR_FILENO", dup( STDOUT_FILENO ) ) };
 
-  Camera camera { 3840, 2160, "/dev/"s + device };
-
-  RasterYUV422 camera_raster { 3840, 2160 };
-  RasterYUV420 output_raster { 1280, 720 };
-  H264Encoder encoder { 1280, 720, 24, "fast", "zerolatency" };
-  Scaler scaler;
-
   /* read key */
   ReadOnlyFile keyfile { key_filename };
   Parser p { keyfile };
@@ -55,34 +46,27 @@ void program_body( const string& device, const string& host, const string& servi
 
   auto client = make_shared<VideoClient>( stagecast_server, key, video_source, *loop );
 
-  unsigned int frames_fetched_ {}, frames_scaled_ {}, frames_encoded_ {};
-  loop->add_rule( "read camera frame", camera.fd(), Direction::In, [&] {
-    camera.get_next_frame( camera_raster );
-    frames_fetched_++;
-  } );
+  /* capture, scale and encode each run on a thread of their own */
+  VideoPipeline pipeline { "/dev/"s + device, 24, video_source, *loop };
 
   loop->add_rule(
-    "scale frame",
+    "zoom",
     [&] {
-      if ( client->has_control() ) {
-        scaler.setup( client->control().x, client->control().y, client->control().width, client->control().height );
-        client->pop_control();
-      }
-
-      scaler.scale( camera_raster, output_raster );
-      frames_scaled_++;
+      const auto& zoom = client->control();
+      pipeline.set_zoom( zoom.x, zoom.y, zoom.width, zoom.height );
+      client->pop_control();
     },
-    [&] { return frames_fetched_ > frames_scaled_; } );
+    [&] { return client->has_control(); } );
 
   loop->add_rule(
-    "encode",
+    "keyframe request",
     [&] {
-      encoder.encode( output_raster );
-      video_source->push( encoder.nal(), Timer::timestamp_ns() );
-      encoder.reset_nal();
-      frames_encoded_++;
+      pipeline.request_keyframe();
+      client->pop_keyframe_request();
     },
-    [&] { return frames_scaled_ > frames_encoded_; } );
+    [&] { return client->keyframe_requested(); } );
+
+  pipeline.start();
 
   /* Print out statistics to terminal */
   StatsPrinterTask stats_printer { loop };
@@ -16,7 +16,9 @@
 using namespace std;
 using namespace std::chrono;
 
-void program_body( const vector<string>& keyfiles )
+void program_body( const vector<string>& keyfiles,
+                   const H264DecoderTask::Mode idle_decode_mode,
+                   const bool passthrough )
 {
   ios::sync_with_stdio( false );
 
@@ -24,6 +26,8 @@ void program_body( const vector<string>& keyfiles )
 
   /* Network server registeres itself in EventLoop */
   auto server = make_shared<VideoServer>( keyfiles.size(), *loop );
+  server->set_idle_decode_mode( idle_decode_mode );
+  server->set_passthrough( passthrough );
 
   for ( const auto& filename : keyfiles ) {
     ReadOnlyFile file { filename };
@@ -45,10 +49,8 @@ void program_body( const vector<string>& keyfiles )
   uint64_t next_json_update = Timer::timestamp_ns() + json_update_interval;
   Json::Value root;
   ostringstream json_str;
-  loop->add_rule(
+  loop->add_timed_rule(
     "JSON update",
-    json_updates,
-    Direction::Out,
     [&] {
       root.clear();
       json_str.str( "" );
@@ -58,10 +60,10 @@ void program_body( const vector<string>& keyfiles )
       json_updates.sendto_ignore_errors( json_update_address, json_str.str() );
       next_json_update = Timer::timestamp_ns() + json_update_interval;
     },
-    [&] { return Timer::timestamp_ns() > next_json_update; } );
+    [&] { return next_json_update; } );
 
   /* Start audio device and event loop */
-  while ( loop->wait_next_event( 1 ) != EventLoop::Result::Exit ) {
+  while ( loop->wait_next_event( -1 ) != EventLoop::Result::Exit ) {
   }
 }
 
@@ -72,16 +74,34 @@ int main( int argc, char* argv[] )
       abort();
     }
 
-    if ( argc <= 1 ) {
-      cerr << "Usage: " << argv[0] << " keyfile...\n";
+    /* how much to decode of the clients that are not live, and whether to forward the live client's video */
+    H264DecoderTask::Mode idle_decode_mode = H264DecoderTask::Mode::All;
+    bool passthrough = false;
+    int first_key = 1;
+    bool bad_option = false;
+    for ( ; first_key < argc and string_view( argv[first_key] ).substr( 0, 2 ) == "--"; first_key++ ) {
+      const string_view option = argv[first_key];
+      if ( option == "--idle-decode=idr" ) {
+        idle_decode_mode = H264DecoderTask::Mode::IDROnly;
+      } else if ( option == "--idle-decode=none" ) {
+        idle_decode_mode = H264DecoderTask::Mode::None;
+      } else if ( option == "--passthrough" ) {
+        passthrough = true;
+      } else {
+        bad_option = true;
+      }
+    }
+
+    if ( bad_option or argc <= first_key ) {
+      cerr << "Usage: " << argv[0] << " [--idle-decode=idr|none] [--passthrough] keyfile...\n";
       return EXIT_FAILURE;
     }
 
     vector<string> keys;
-    for ( int i = 1; i < argc; i++ ) {
+    for ( int i = first_key; i < argc; i++ ) {
       keys.push_back( argv[i] );
     }
-    program_body( keys );
+    program_body( keys, idle_decode_mode, passthrough );
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     global_timer().summary( cerr );
@@ -11,7 +11,7 @@ StatsPrinterTask::StatsPrinterTask( std::shared_ptr<EventLoop> loop )
   , next_stats_print( steady_clock::now() )
   , next_stats_reset( steady_clock::now() )
 {
-  loop_->add_rule(
+  loop_->add_timed_rule(
     "generate+print statistics",
     [&] {
       ss_.str( {} );
@@ -47,7 +47,7 @@ StatsPrinterTask::StatsPrinterTask( std::shared_ptr<EventLoop> loop )
       }
       output_rb_.pop_to_fd( standard_output_ );
     },
-    [&] { return steady_clock::now() > next_stats_print; } );
+    [&] { return uint64_t( duration_cast<nanoseconds>( next_stats_print.time_since_epoch() ).count() ); } );
 
   loop_->add_rule(
     "print statistics",
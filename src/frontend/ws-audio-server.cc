@@ -64,6 +64,14 @@ public:
   }
 
 private:
+  //! The SSL rules are told when their interest may have changed, rather than asked on every wakeup
+  void interest_changed()
+  {
+    for ( auto& rule : rules_ ) {
+      rule.interest_changed();
+    }
+  }
+
   unsigned int updates_since_small_buffer_ {};
   void parse_message( const string_view s )
   {
@@ -100,7 +108,11 @@ public:
 
   const TCPSocket& socket() const { return ssl_session_.socket(); }
 
-  void send_all( const string_view s ) { ws_server_.endpoint().send_all( s, ssl_session_.outbound_plaintext() ); }
+  void send_all( const string_view s )
+  {
+    ws_server_.endpoint().send_all( s, ssl_session_.outbound_plaintext() );
+    interest_changed();
+  }
   bool can_send( const size_t len ) const
   {
     return ssl_session_.outbound_plaintext().writable_region().size() >= len;
@@ -138,6 +150,7 @@ public:
 
     rules_.push_back( loop.add_rule(
       categories.SSL_read,
+      EventLoop::Interest::Reported,
       ssl_session_.socket(),
       Direction::In,
       [this] {
@@ -146,12 +159,14 @@ public:
         } catch ( const exception& e ) {
           cull( e.what() );
         }
+        interest_changed();
       },
       [this] { return good() and ssl_session_.want_read(); },
       [this] { cull( "socket closed" ); } ) );
 
     rules_.push_back( loop.add_rule(
       categories.SSL_write,
+      EventLoop::Interest::Reported,
       ssl_session_.socket(),
       Direction::Out,
       [this] {
@@ -160,13 +175,17 @@ public:
         } catch ( const exception& e ) {
           cull( e.what() );
         }
+        interest_changed();
       },
       [this] { return good() and ssl_session_.want_write(); },
       [this] { cull( "socket closed" ); } ) );
 
     rules_.push_back( loop.add_rule(
       categories.ws_handshake,
-      [this] { ws_server_.do_handshake( ssl_session_.inbound_plaintext(), ssl_session_.outbound_plaintext() ); },
+      [this] {
+        ws_server_.do_handshake( ssl_session_.inbound_plaintext(), ssl_session_.outbound_plaintext() );
+        interest_changed();
+      },
       [this] {
         return good() and ( not ssl_session_.inbound_plaintext().readable_region().empty() )
                and ( not ws_server_.handshake_complete() );
@@ -190,6 +209,7 @@ public:
         Serializer s { ssl_session_.outbound_plaintext().writable_region() };
         s.object( ws_frame_ );
         ssl_session_.outbound_plaintext().push( s.bytes_written() );
+        interest_changed();
       },
       [&] {
         return ssl_session_.outbound_plaintext().writable_region().size() > ( 1 + WebSocketFrame::max_overhead() )
@@ -209,6 +229,7 @@ public:
 
           ws_server_.endpoint().pop_message();
         }
+        interest_changed();
       },
       [this] { return good() and not ssl_session_.inbound_plaintext().readable_region().empty(); } ) );
   }
@@ -293,7 +314,7 @@ void program_body( const string origin, const string cert_filename, const string
   auto clients = make_shared<ClientList>();
 
   /* set up event loop */
-  auto loop = make_shared<EventLoop>();
+  auto loop = make_shared<EventLoop>( EventLoop::Backend::EpollLevelTriggered );
   EventCategories categories { *loop };
 
   auto cull_needed = make_shared<bool>( false );
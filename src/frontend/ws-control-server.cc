@@ -96,6 +96,14 @@ public:
   }
 
 private:
+  //! The SSL rules are told when their interest may have changed, rather than asked on every wakeup
+  void interest_changed()
+  {
+    for ( auto& rule : rules_ ) {
+      rule.interest_changed();
+    }
+  }
+
   vector<string_view> fields_ {};
   void parse_message( const string_view s )
   {
@@ -158,6 +166,7 @@ public:
 
     rules_.push_back( loop.add_rule(
       categories.SSL_read,
+      EventLoop::Interest::Reported,
       ssl_session_.socket(),
       Direction::In,
       [this] {
@@ -166,12 +175,14 @@ public:
         } catch ( const exception& e ) {
           cull( e.what() );
         }
+        interest_changed();
       },
       [this] { return good() and ssl_session_.want_read(); },
       [this] { cull( "socket closed" ); } ) );
 
     rules_.push_back( loop.add_rule(
       categories.SSL_write,
+      EventLoop::Interest::Reported,
       ssl_session_.socket(),
       Direction::Out,
       [this] {
@@ -180,13 +191,17 @@ public:
         } catch ( const exception& e ) {
           cull( e.what() );
         }
+        interest_changed();
       },
       [this] { return good() and ssl_session_.want_write(); },
       [this] { cull( "socket closed" ); } ) );
 
     rules_.push_back( loop.add_rule(
       categories.ws_handshake,
-      [this] { ws_server_.do_handshake( ssl_session_.inbound_plaintext(), ssl_session_.outbound_plaintext() ); },
+      [this] {
+        ws_server_.do_handshake( ssl_session_.inbound_plaintext(), ssl_session_.outbound_plaintext() );
+        interest_changed();
+      },
       [this] {
         return good() and ( not ssl_session_.inbound_plaintext().readable_region().empty() )
                and ( not ws_server_.handshake_complete() );
@@ -204,6 +219,7 @@ public:
 
           ws_server_.endpoint().pop_message();
         }
+        interest_changed();
       },
       [this] { return good() and not ssl_session_.inbound_plaintext().readable_region().empty(); } ) );
   }
@@ -231,6 +247,7 @@ public:
       Serializer s { ssl_session_.outbound_plaintext().writable_region() };
       s.object( ws_frame_ );
       ssl_session_.outbound_plaintext().push( s.bytes_written() );
+      interest_changed();
     }
   }
 
@@ -283,7 +300,7 @@ void program_body( const string origin, const string cert_filename, const string
   auto clients = make_shared<ClientList>();
 
   /* set up event loop */
-  auto loop = make_shared<EventLoop>();
+  auto loop = make_shared<EventLoop>( EventLoop::Backend::EpollLevelTriggered );
   EventCategories categories { *loop };
 
   auto cull_needed = make_shared<bool>( false );
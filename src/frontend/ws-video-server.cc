@@ -103,6 +103,14 @@ public:
   }
 
 private:
+  //! The SSL rules are told when their interest may have changed, rather than asked on every wakeup
+  void interest_changed()
+  {
+    for ( auto& rule : rules_ ) {
+      rule.interest_changed();
+    }
+  }
+
   float mean_buffer_ = 0.0;
   float last_buffer_ = 0.0;
   vector<string_view> fields_ {};
@@ -178,6 +186,7 @@ public:
       Serializer s { ssl_session_.outbound_plaintext().writable_region() };
       s.object( ws_frame_ );
       ssl_session_.outbound_plaintext().push( s.bytes_written() );
+      interest_changed();
     }
   }
 
@@ -220,6 +229,7 @@ public:
 
     rules_.push_back( loop.add_rule(
       categories.SSL_read,
+      EventLoop::Interest::Reported,
       ssl_session_.socket(),
       Direction::In,
       [this] {
@@ -228,12 +238,14 @@ public:
         } catch ( const exception& e ) {
           cull( e.what() );
         }
+        interest_changed();
       },
       [this] { return good() and ssl_session_.want_read(); },
       [this] { cull( "socket closed" ); } ) );
 
     rules_.push_back( loop.add_rule(
       categories.SSL_write,
+      EventLoop::Interest::Reported,
       ssl_session_.socket(),
       Direction::Out,
       [this] {
@@ -242,13 +254,17 @@ public:
         } catch ( const exception& e ) {
           cull( e.what() );
         }
+        interest_changed();
       },
       [this] { return good() and ssl_session_.want_write(); },
       [this] { cull( "socket closed" ); } ) );
 
     rules_.push_back( loop.add_rule(
       categories.ws_handshake,
-      [this] { ws_server_.do_handshake( ssl_session_.inbound_plaintext(), ssl_session_.outbound_plaintext() ); },
+      [this] {
+        ws_server_.do_handshake( ssl_session_.inbound_plaintext(), ssl_session_.outbound_plaintext() );
+        interest_changed();
+      },
       [this] {
         return good() and ( not ssl_session_.inbound_plaintext().readable_region().empty() )
                and ( not ws_server_.handshake_complete() );
@@ -272,6 +288,7 @@ public:
         Serializer s { ssl_session_.outbound_plaintext().writable_region() };
         s.object( ws_frame_ );
         ssl_session_.outbound_plaintext().push( s.bytes_written() );
+        interest_changed();
       },
       [&] {
         return ssl_session_.outbound_plaintext().writable_region().size() > ( 1 + WebSocketFrame::max_overhead() )
@@ -290,6 +307,7 @@ public:
         Serializer s { ssl_session_.outbound_plaintext().writable_region() };
         s.object( ws_frame_ );
         ssl_session_.outbound_plaintext().push( s.bytes_written() );
+        interest_changed();
       },
       [&] {
         return ws_server_.handshake_complete() and Timer::timestamp_ns() > next_status_update_
@@ -307,6 +325,7 @@ public:
         ssl_session_.outbound_plaintext().push( s.bytes_written() );
 
         controls_sent_++;
+        interest_changed();
       },
       [&] {
         return ws_server_.handshake_complete() and ( controls_sent_ < camera_names_->size() )
@@ -330,6 +349,7 @@ public:
 
           ws_server_.endpoint().pop_message();
         }
+        interest_changed();
       },
       [this] { return good() and ssl_session_.inbound_plaintext().readable_region().size(); } ) );
   }
@@ -408,7 +428,7 @@ void program_body( const string origin,
   auto clients = make_shared<ClientList>();
 
   /* set up event loop */
-  auto loop = make_shared<EventLoop>();
+  auto loop = make_shared<EventLoop>( EventLoop::Backend::EpollLevelTriggered );
   EventCategories categories { *loop };
 
   auto cull_needed = make_shared<bool>( false );
@@ -30,33 +30,40 @@ NetworkConnection<FrameType, SourceType>::NetworkConnection( const char node_id,
 
 template<class FrameType, class SourceType>
 void NetworkConnection<FrameType, SourceType>::send_packet( UDPSocket& socket )
+{
+  Ciphertext ciphertext;
+  make_packet( ciphertext );
+  socket.sendto( destination_.value(), ciphertext );
+}
+
+template<class FrameType, class SourceType>
+void NetworkConnection<FrameType, SourceType>::make_packet( Ciphertext& ciphertext )
 {
   if ( not has_destination() ) {
     throw runtime_error( "no destination" );
   }
 
-  /* make packet to send */
-  Packet<FrameType> pack {};
-  sender_.set_sender_section( pack.sender_section );
+  /* make packet to send (its frames stay in the sender's storage) */
+  OutboundPacket<FrameType> pack {};
+  sender_.set_sender_section( pack );
   receiver_.set_receiver_section( pack.receiver_section );
 
   /* do we have room for an unreliable update? */
   if ( pending_outbound_unreliable_data_.has_value() and ( pack.serialized_length() < 1200 ) ) {
-    pack.unreliable_data_ = pending_outbound_unreliable_data_.value();
-    pending_outbound_unreliable_data_.reset();
+    pack.unreliable_data = &pending_outbound_unreliable_data_.value();
   }
 
-  /* serialize */
-  Plaintext plaintext;
-  Serializer s { plaintext.mutable_buffer() };
+  /* serialize straight into the outgoing buffer, leaving room for the tag, nonce and associated data */
+  Serializer s { ciphertext.mutable_buffer().substr( 0, Plaintext::capacity() ) };
   pack.serialize( s );
-  plaintext.resize( s.bytes_written() );
+  ciphertext.resize( s.bytes_written() );
 
-  /* encrypt */
-  Ciphertext ciphertext;
-  crypto_.encrypt( { &node_id_, 1 }, plaintext, ciphertext );
+  if ( pack.unreliable_data ) {
+    pending_outbound_unreliable_data_.reset();
+  }
 
-  socket.sendto( destination_.value(), ciphertext );
+  /* encrypt in place */
+  crypto_.encrypt_in_place( { &node_id_, 1 }, ciphertext );
 }
 
 template<class FrameType, class SourceType>
@@ -90,21 +97,40 @@ bool NetworkConnection<FrameType, SourceType>::receive_packet( const Ciphertext&
     return false;
   }
 
-  /* parse */
+  return receive_plaintext( plaintext );
+}
+
+template<class FrameType, class SourceType>
+bool NetworkConnection<FrameType, SourceType>::receive_packet_in_place( Ciphertext& datagram )
+{
+  /* decrypt */
+  if ( not crypto_.decrypt_in_place( datagram, { &peer_id_, 1 } ) ) {
+    stats_.decryption_failures++;
+    return false;
+  }
+
+  return receive_plaintext( datagram );
+}
+
+template<class FrameType, class SourceType>
+bool NetworkConnection<FrameType, SourceType>::receive_plaintext( const string_view plaintext )
+{
+  /* parse (the receiver takes the frames straight into its store) */
   Parser parser { plaintext };
-  const Packet<FrameType> packet { parser };
+  typename Packet<FrameType>::ReceiverSection receiver_section;
+  NetString unreliable_data;
+  receiver_.receive_packet( parser, receiver_section, unreliable_data );
   if ( parser.error() ) {
     stats_.invalid++;
     parser.clear_error();
     return false;
   }
 
-  /* act on packet contents */
-  sender_.receive_receiver_section( packet.receiver_section );
-  receiver_.receive_sender_section( packet.sender_section );
+  /* act on the rest of the packet */
+  sender_.receive_receiver_section( receiver_section );
 
-  if ( packet.unreliable_data_.length() > 0 ) {
-    inbound_unreliable_data_.emplace( packet.unreliable_data_ );
+  if ( unreliable_data.length() > 0 ) {
+    inbound_unreliable_data_.emplace( unreliable_data );
   }
 
   return true;
@@ -33,6 +33,8 @@ class NetworkConnection : public Summarizable
   std::optional<NetString> pending_outbound_unreliable_data_ {};
   std::optional<NetString> inbound_unreliable_data_ {};
 
+  bool receive_plaintext( const std::string_view plaintext );
+
 public:
   NetworkConnection( const char node_id, const char peer_id, CryptoSession&& crypto );
   NetworkConnection( const char node_id, const char peer_id, CryptoSession&& crypto, const Address& destination );
@@ -41,12 +43,26 @@ public:
   const Address& destination() const { return destination_.value(); }
 
   void push_frame( SourceType& source ) { sender_.push_frame( source ); }
+
+  //! Also send XOR parity over groups of frames (audio only; see NetworkSender::set_fec)
+  template<class F = FrameType>
+  void set_fec( const bool enabled )
+  {
+    sender_.template set_fec<F>( enabled );
+  }
+
   void summary( std::ostream& out ) const override;
 
   void send_packet( UDPSocket& socket );
+
+  //! Build the next outbound packet (for the caller to send to destination())
+  void make_packet( Ciphertext& ciphertext );
   bool receive_packet( const Ciphertext& ciphertext, const Address& source );
   bool receive_packet( const Ciphertext& ciphertext );
 
+  //! Like receive_packet(), but decrypts `datagram` in place (its contents are lost either way)
+  bool receive_packet_in_place( Ciphertext& datagram );
+
   uint32_t next_frame_needed() const { return receiver_.next_frame_needed(); }
   uint32_t unreceived_beyond_this_frame_index() const { return receiver_.unreceived_beyond_this_frame_index(); }
   const PartialFrameStore<FrameType>& frames() const { return receiver_.frames(); }
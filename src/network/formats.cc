@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <array>
+
 #include "formats.hh"
 #include "exception.hh"
 #include "opus.hh"
@@ -45,29 +48,242 @@ void VideoChunk::serialize( Serializer& s ) const
 {
   const uint32_t first_word = ( end_of_nal << 31 ) | ( frame_index & 0x7FFF'FFFF );
 
-  s.integer( first_word );
-  s.integer( nal_index );
+  s.fixed( first_word, nal_index );
   s.object( data );
 }
 
 void VideoChunk::parse( Parser& p )
 {
   uint32_t first_word {};
-  p.integer( first_word );
+  p.fixed( first_word, nal_index );
   frame_index = first_word & 0x7FFF'FFFF;
   end_of_nal = first_word & 0x8000'0000;
 
-  p.integer( nal_index );
-
   p.object( data );
 }
 
+template<class FrameType>
+void ParityFrame<FrameType>::add_bytes( const string_view other, const uint16_t other_length )
+{
+  /* zero-pad to the longer of the two */
+  if ( other.size() > bytes.length() ) {
+    const size_t old_length = bytes.length();
+    bytes.resize( other.size() );
+    fill( bytes.mutable_data_ptr() + old_length, bytes.mutable_data_ptr() + other.size(), 0 );
+  }
+
+  char* out = bytes.mutable_data_ptr();
+  for ( size_t i = 0; i < other.size(); i++ ) {
+    out[i] ^= other[i];
+  }
+
+  length_xor ^= other_length;
+}
+
+template<class FrameType>
+void ParityFrame<FrameType>::add( const FrameType& frame )
+{
+  array<char, FrameType::max_serialized_length> serialized;
+  Serializer s { { serialized.data(), serialized.size() } };
+  s.object( frame );
+  add_bytes( { serialized.data(), s.bytes_written() }, s.bytes_written() );
+}
+
+template<class FrameType>
+void ParityFrame<FrameType>::add( const ParityFrame& other )
+{
+  add_bytes( other.bytes, other.length_xor );
+}
+
+template<class FrameType>
+bool ParityFrame<FrameType>::extract( FrameType& frame ) const
+{
+  if ( length_xor > bytes.length() ) {
+    return false;
+  }
+
+  Parser p { bytes.as_string_view().substr( 0, length_xor ) };
+  p.object( frame );
+  const bool ok = not p.error() and p.input().empty();
+  p.clear_error();
+  return ok;
+}
+
+template<class FrameType>
+uint32_t ParityFrame<FrameType>::serialized_length() const
+{
+  return sizeof( group_index ) + sizeof( length_xor ) + bytes.serialized_length();
+}
+
+template<class FrameType>
+void ParityFrame<FrameType>::serialize( Serializer& s ) const
+{
+  s.fixed( group_index, length_xor );
+  s.object( bytes );
+}
+
+template<class FrameType>
+void ParityFrame<FrameType>::parse( Parser& p )
+{
+  p.fixed( group_index, length_xor );
+  p.object( bytes );
+}
+
+bool SelectiveAcks::add( const uint32_t sequence_number )
+{
+  if ( not greatest.has_value() ) {
+    greatest = sequence_number;
+    return true;
+  }
+
+  if ( sequence_number >= greatest.value() ) {
+    return sequence_number == greatest.value();
+  }
+
+  const uint32_t bit = greatest.value() - 1 - sequence_number;
+  if ( bit >= window ) {
+    return false;
+  }
+
+  bitmap[bit / 8] |= 1 << ( bit % 8 );
+  bitmap_length = max( bitmap_length, uint8_t( bit / 8 + 1 ) );
+  return true;
+}
+
+size_t SelectiveAcks::size() const
+{
+  if ( empty() ) {
+    return 0;
+  }
+
+  size_t ret = 1;
+  for ( uint8_t i = 0; i < bitmap_length; i++ ) {
+    ret += __builtin_popcount( bitmap[i] );
+  }
+  return ret;
+}
+
+SelectiveAcks::const_iterator::const_iterator( const SelectiveAcks* acks, const uint32_t position )
+  : acks_( acks )
+  , position_( position )
+{}
+
+void SelectiveAcks::const_iterator::skip_to_set_bit()
+{
+  while ( position_ < acks_->end_position() ) {
+    const uint32_t bit = position_ - 1;
+    if ( acks_->bitmap[bit / 8] & ( 1 << ( bit % 8 ) ) ) {
+      return;
+    }
+    position_++;
+  }
+}
+
+SelectiveAcks::const_iterator& SelectiveAcks::const_iterator::operator++()
+{
+  position_++;
+  skip_to_set_bit();
+  return *this;
+}
+
+SelectiveAcks::const_iterator SelectiveAcks::begin() const
+{
+  return { this, empty() ? end_position() : 0 };
+}
+
+SelectiveAcks::const_iterator SelectiveAcks::end() const
+{
+  return { this, end_position() };
+}
+
+uint32_t SelectiveAcks::serialized_length() const
+{
+  if ( empty() ) {
+    return sizeof( uint8_t );
+  }
+
+  return sizeof( bitmap_format ) + sizeof( greatest.value() ) + bitmap_length;
+}
+
+void SelectiveAcks::serialize( Serializer& s ) const
+{
+  if ( empty() ) {
+    /* the same in either format: nothing acknowledged */
+    s.integer( uint8_t( 0 ) );
+    return;
+  }
+
+  s.integer( uint8_t( bitmap_format | bitmap_length ) );
+  s.integer( greatest.value() );
+  s.string( { reinterpret_cast<const char*>( bitmap.data() ), bitmap_length } );
+}
+
+void SelectiveAcks::parse( Parser& p )
+{
+  *this = {};
+
+  uint8_t format {};
+  p.integer( format );
+
+  if ( format & bitmap_format ) {
+    bitmap_length = format & ~bitmap_format;
+    if ( bitmap_length > max_bitmap_bytes ) {
+      p.set_error();
+      return;
+    }
+    uint32_t greatest_sequence_number {};
+    p.integer( greatest_sequence_number );
+    p.string( { reinterpret_cast<char*>( bitmap.data() ), bitmap_length } );
+    greatest = greatest_sequence_number;
+    return;
+  }
+
+  if ( format > legacy_capacity ) {
+    p.set_error();
+    return;
+  }
+
+  /* original format: explicit sequence numbers, the greatest usually (but not necessarily) first */
+  array<uint32_t, legacy_capacity> sequence_numbers {};
+  for ( uint8_t i = 0; i < format; i++ ) {
+    p.integer( sequence_numbers[i] );
+  }
+  if ( p.error() or format == 0 ) {
+    return;
+  }
+
+  add( *max_element( sequence_numbers.begin(), sequence_numbers.begin() + format ) );
+  for ( uint8_t i = 0; i < format; i++ ) {
+    add( sequence_numbers[i] );
+  }
+}
+
+template<class FrameType>
+uint32_t Packet<FrameType>::ReceiverSection::serialized_length() const
+{
+  return sizeof( next_frame_needed ) + packets_received.serialized_length();
+}
+
+template<class FrameType>
+void Packet<FrameType>::ReceiverSection::serialize( Serializer& s ) const
+{
+  s.integer( next_frame_needed );
+  s.object( packets_received );
+}
+
+template<class FrameType>
+void Packet<FrameType>::ReceiverSection::parse( Parser& p )
+{
+  p.integer( next_frame_needed );
+  p.object( packets_received );
+}
+
 template<class FrameType>
 uint32_t Packet<FrameType>::serialized_length() const
 {
   return sizeof( sender_section.sequence_number ) + sender_section.frames.serialized_length()
-         + sizeof( receiver_section.next_frame_needed ) + receiver_section.packets_received.serialized_length()
-         + unreliable_data_.serialized_length();
+         + receiver_section.serialized_length() + unreliable_data_.serialized_length()
+         + ( sender_section.parity.length ? sender_section.parity.serialized_length() : 0 );
 }
 
 template<class FrameType>
@@ -75,11 +291,12 @@ void Packet<FrameType>::serialize( Serializer& s ) const
 {
   s.integer( sender_section.sequence_number );
   s.object( sender_section.frames );
-
-  s.integer( receiver_section.next_frame_needed );
-  s.object( receiver_section.packets_received );
-
+  s.object( receiver_section );
   s.object( unreliable_data_ );
+
+  if ( sender_section.parity.length ) {
+    s.object( sender_section.parity );
+  }
 }
 
 template<class FrameType>
@@ -87,11 +304,12 @@ void Packet<FrameType>::parse( Parser& p )
 {
   p.integer( sender_section.sequence_number );
   p.object( sender_section.frames );
-
-  p.integer( receiver_section.next_frame_needed );
-  p.object( receiver_section.packets_received );
-
+  p.object( receiver_section );
   p.object( unreliable_data_ );
+
+  if ( not p.error() and not p.input().empty() ) {
+    p.object( sender_section.parity );
+  }
 }
 
 template<class FrameType>
@@ -108,9 +326,68 @@ typename Packet<FrameType>::Record Packet<FrameType>::SenderSection::to_record()
   return ret;
 }
 
+template<class FrameType>
+typename Packet<FrameType>::Record OutboundPacket<FrameType>::to_record() const
+{
+  typename Packet<FrameType>::Record ret;
+
+  ret.sequence_number = sequence_number;
+  ret.frames.length = num_frames;
+  for ( uint8_t i = 0; i < num_frames; i++ ) {
+    ret.frames.elements[i].value = frames[i]->frame_index;
+  }
+
+  return ret;
+}
+
+static const NetString no_unreliable_data {};
+
+template<class FrameType>
+uint32_t OutboundPacket<FrameType>::serialized_length() const
+{
+  uint32_t ret = sizeof( sequence_number ) + sizeof( num_frames );
+  for ( uint8_t i = 0; i < num_frames; i++ ) {
+    ret += frames[i]->serialized_length();
+  }
+
+  ret += receiver_section.serialized_length();
+  ret += ( unreliable_data ? *unreliable_data : no_unreliable_data ).serialized_length();
+
+  if ( parity ) {
+    ret += sizeof( uint8_t ) + parity->serialized_length();
+  }
+
+  return ret;
+}
+
+template<class FrameType>
+void OutboundPacket<FrameType>::serialize( Serializer& s ) const
+{
+  /* the same layout as Packet::serialize(), with the NetArray lengths written out here */
+  s.integer( sequence_number );
+  s.integer( num_frames );
+  for ( uint8_t i = 0; i < num_frames; i++ ) {
+    s.object( *frames[i] );
+  }
+
+  s.object( receiver_section );
+  s.object( unreliable_data ? *unreliable_data : no_unreliable_data );
+
+  if ( parity ) {
+    s.integer( uint8_t( 1 ) );
+    s.object( *parity );
+  }
+}
+
+template struct ParityFrame<AudioFrame>;
+template struct ParityFrame<VideoChunk>;
+
 template struct Packet<AudioFrame>;
 template struct Packet<VideoChunk>;
 
+template struct OutboundPacket<AudioFrame>;
+template struct OutboundPacket<VideoChunk>;
+
 void KeyMessage::serialize( Serializer& s ) const
 {
   s.object( id );
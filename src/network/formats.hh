@@ -22,6 +22,14 @@ struct AudioFrame
   void parse( Parser& p );
 
   static constexpr uint8_t frames_per_packet = 8;
+
+  static constexpr uint8_t max_serialized_length = sizeof( frame_index ) + 2 * sizeof( opus_frame );
+  static constexpr uint8_t fec_group_size = 4;
+
+  /* retransmission pacing (see NetworkSender): until a delivery rate is measured, the budget refills at this
+     many bytes per second (a 2.5 ms frame is about 40 bytes), and it never holds more than this long's worth */
+  static constexpr float min_retransmit_rate = 16000;
+  static constexpr uint64_t max_retransmit_burst_ns = 10'000'000;
 };
 
 static_assert( sizeof( AudioFrame ) == 128 );
@@ -41,6 +49,14 @@ struct VideoChunk
   void parse( Parser& p );
 
   static constexpr uint8_t frames_per_packet = 2;
+
+  static constexpr uint16_t max_serialized_length
+    = sizeof( frame_index ) + sizeof( nal_index ) + sizeof( uint16_t ) + Buffer::capacity();
+  static constexpr uint8_t fec_group_size = 4;
+
+  /* a packet of chunks is about 1 KB, so the budget holds two of them even before a rate is measured */
+  static constexpr float min_retransmit_rate = 200'000;
+  static constexpr uint64_t max_retransmit_burst_ns = 10'000'000;
 };
 
 template<typename T>
@@ -88,9 +104,10 @@ struct NetArray
 
   void serialize( Serializer& s ) const
   {
+    /* Serializer::object() has already checked the room for the whole array */
     s.integer( length );
     for ( uint8_t i = 0; i < length; i++ ) {
-      s.object( elements[i] );
+      elements[i].serialize( s );
     }
   }
 
@@ -134,6 +151,88 @@ public:
   }
 };
 
+//! XOR of the serialized frames in one FEC group, each zero-padded to the longest
+//! \details A receiver holding all but one frame of the group XORs them out of the parity to rebuild the
+//! missing one. The same structure accumulates that running XOR on both ends.
+template<class FrameType>
+struct ParityFrame
+{
+  static constexpr uint8_t group_size = FrameType::fec_group_size;
+
+  uint32_t group_index {}; /* covers frames [group_index * group_size, (group_index + 1) * group_size) */
+  uint16_t length_xor {};
+  StackBuffer<0, uint16_t, FrameType::max_serialized_length> bytes {};
+
+  static constexpr uint32_t max_serialized_length
+    = sizeof( group_index ) + sizeof( length_xor ) + sizeof( uint16_t ) + FrameType::max_serialized_length;
+
+  void add( const FrameType& frame );
+  void add( const ParityFrame& other );
+
+  //! Parse the accumulated bytes as a frame (meaningful once all but one frame has been XORed out)
+  bool extract( FrameType& frame ) const;
+
+  uint32_t serialized_length() const;
+  void serialize( Serializer& s ) const;
+  void parse( Parser& p );
+
+private:
+  void add_bytes( const std::string_view other, const uint16_t other_length );
+};
+
+//! The packets a receiver acknowledges: the greatest sequence number, plus a bitmap of those before it
+//! \details On the wire, the first byte tells the formats apart. A value of at most 32 is the original format,
+//! that many explicit 32-bit sequence numbers (parsed into the bitmap). With the `bitmap_format` bit set, it is
+//! version 1: the low bits give the bitmap's length in bytes (trailing zero bytes trimmed), which follows the
+//! greatest sequence number.
+struct SelectiveAcks
+{
+  static constexpr uint8_t legacy_capacity = 32;
+  static constexpr uint8_t bitmap_format = 0x80;
+  static constexpr uint8_t max_bitmap_bytes = 32;
+  static constexpr uint32_t window = 8 * max_bitmap_bytes; /* packets acknowledgeable before the greatest */
+  static constexpr uint32_t max_serialized_length
+    = sizeof( bitmap_format ) + sizeof( uint32_t ) + max_bitmap_bytes;
+
+  std::optional<uint32_t> greatest {};
+  std::array<uint8_t, max_bitmap_bytes> bitmap {}; /* bit k (LSB first): greatest - 1 - k was received */
+  uint8_t bitmap_length {};
+
+private:
+  uint32_t end_position() const { return 8 * bitmap_length + 1; }
+
+public:
+  //! Acknowledge a packet; the first one added must be the greatest
+  //! \returns false if it is too far behind the greatest to represent
+  bool add( const uint32_t sequence_number );
+
+  bool empty() const { return not greatest.has_value(); }
+  size_t size() const;
+
+  class const_iterator
+  {
+    const SelectiveAcks* acks_;
+    uint32_t position_; /* 0 is the greatest, k + 1 is bit k */
+
+    void skip_to_set_bit();
+
+  public:
+    const_iterator( const SelectiveAcks* acks, const uint32_t position );
+
+    uint32_t operator*() const { return acks_->greatest.value() - position_; }
+    const_iterator& operator++();
+    bool operator!=( const const_iterator& other ) const { return position_ != other.position_; }
+  };
+
+  //! The acknowledged sequence numbers, greatest first
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  uint32_t serialized_length() const;
+  void serialize( Serializer& s ) const;
+  void parse( Parser& p );
+};
+
 template<class FrameType>
 struct Packet
 {
@@ -148,17 +247,30 @@ struct Packet
     uint32_t sequence_number {};
     NetArray<FrameType, FrameType::frames_per_packet> frames {};
 
+    /* optional, and last on the wire, so that receivers without FEC ignore it */
+    NetArray<ParityFrame<FrameType>, 1> parity {};
+
     Record to_record() const;
   } sender_section {};
 
   struct ReceiverSection
   {
     uint32_t next_frame_needed {};
-    NetArray<NetInteger<uint32_t>, 32> packets_received {};
+    SelectiveAcks packets_received {};
+
+    uint32_t serialized_length() const;
+    void serialize( Serializer& s ) const;
+    void parse( Parser& p );
   } receiver_section {};
 
   NetString unreliable_data_ {};
 
+  //! The longest packet with a full load of frames and parity (unreliable data only goes in if there is room)
+  static constexpr uint32_t max_serialized_length_with_parity
+    = sizeof( uint32_t ) + sizeof( uint8_t ) + FrameType::frames_per_packet * FrameType::max_serialized_length
+      + sizeof( uint32_t ) + SelectiveAcks::max_serialized_length + sizeof( uint8_t ) + sizeof( uint8_t )
+      + ParityFrame<FrameType>::max_serialized_length;
+
   uint32_t serialized_length() const;
   void serialize( Serializer& s ) const;
   void parse( Parser& p );
@@ -167,6 +279,44 @@ struct Packet
   Packet( Parser& p ) { parse( p ); }
 };
 
+//! Read the index of the frame at the start of `input`, so a receiver can choose where to parse it
+//! \details Every frame type begins with a word whose low 31 bits are the frame index.
+template<class FrameType>
+bool peek_frame_index( const std::string_view input, uint32_t& frame_index )
+{
+  uint32_t first_word {};
+  if ( input.size() < sizeof( first_word ) ) {
+    return false;
+  }
+
+  wire::load( input.data(), first_word );
+  frame_index = first_word & 0x7FFF'FFFF;
+  return true;
+}
+
+//! An outbound packet whose frames and parity are serialized from wherever the sender keeps them
+//! \details Produces the same bytes as the equivalent Packet, without first copying every frame into one.
+//! The frames must stay put until serialize() is done.
+template<class FrameType>
+struct OutboundPacket
+{
+  uint32_t sequence_number {};
+  std::array<const FrameType*, FrameType::frames_per_packet> frames {};
+  uint8_t num_frames {};
+  const ParityFrame<FrameType>* parity {};
+
+  typename Packet<FrameType>::ReceiverSection receiver_section {};
+  const NetString* unreliable_data {};
+
+  bool full() const { return num_frames >= frames.size(); }
+  void add_frame( const FrameType& frame ) { frames.at( num_frames++ ) = &frame; }
+
+  typename Packet<FrameType>::Record to_record() const;
+
+  uint32_t serialized_length() const;
+  void serialize( Serializer& s ) const;
+};
+
 struct KeyMessage
 {
   static constexpr char keyreq_id = uint8_t( 254 );
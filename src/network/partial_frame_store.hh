@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//! The frames received so far within a sliding window of frame indices, some of which may be missing
+//! \details Which frames are present is kept in a bitmap, one 64-bit word per 64 consecutive indices, so the
+//! next hole (or the next frame held) is found a word at a time. The frames themselves live in blocks of 64,
+//! one per bitmap word, allocated only while any frame of the block is held, so memory follows how far apart
+//! the held frames are rather than the size of the window.
+template<class FrameType>
+class PartialFrameStore
+{
+  static constexpr size_t FRAMES_PER_WORD = 64;
+  static constexpr size_t MAX_SPARE_BLOCKS = 4;
+
+  using Block = std::array<FrameType, FRAMES_PER_WORD>;
+
+  size_t num_popped_ = 0;
+
+  /* ring of words over the window; the partial words at either end of the window share a word (and block),
+     using disjoint bits */
+  std::vector<uint64_t> present_;
+  std::vector<std::unique_ptr<Block>> blocks_;
+  std::vector<std::unique_ptr<Block>> spare_blocks_ {};
+
+  size_t word_of( const size_t pos ) const { return ( pos / FRAMES_PER_WORD ) % present_.size(); }
+  static uint64_t bit_of( const size_t pos ) { return uint64_t( 1 ) << ( pos % FRAMES_PER_WORD ); }
+
+  /* bits for the n indices from pos on, which must all be in pos's word */
+  static uint64_t bits_of( const size_t pos, const size_t n )
+  {
+    return ( n == FRAMES_PER_WORD ? ~uint64_t( 0 ) : ( uint64_t( 1 ) << n ) - 1 ) << ( pos % FRAMES_PER_WORD );
+  }
+
+  void check_bounds( const size_t pos ) const
+  {
+    if ( pos < range_begin() or pos >= range_end() ) {
+      throw std::out_of_range( "PartialFrameStore: " + std::to_string( pos ) + " outside ["
+                               + std::to_string( range_begin() ) + ", " + std::to_string( range_end() ) + ")" );
+    }
+  }
+
+  void release_block( const size_t word )
+  {
+    if ( spare_blocks_.size() < MAX_SPARE_BLOCKS ) {
+      spare_blocks_.push_back( std::move( blocks_[word] ) );
+    }
+    blocks_[word].reset();
+  }
+
+  //! First index in [pos, range_end()) whose presence is `present`, or range_end() if there is none
+  size_t find( size_t pos, const bool present ) const
+  {
+    while ( pos < range_end() ) {
+      /* bits for indices at or after pos in this word */
+      uint64_t candidates = present_[word_of( pos )] ^ ( present ? 0 : ~uint64_t( 0 ) );
+      candidates &= ~uint64_t( 0 ) << ( pos % FRAMES_PER_WORD );
+
+      if ( candidates ) {
+        return std::min( range_end(), pos - pos % FRAMES_PER_WORD + __builtin_ctzll( candidates ) );
+      }
+
+      pos += FRAMES_PER_WORD - pos % FRAMES_PER_WORD;
+    }
+
+    return range_end();
+  }
+
+public:
+  //! \param capacity width of the window of frame indices (a multiple of 64)
+  explicit PartialFrameStore( const size_t capacity )
+    : present_( capacity / FRAMES_PER_WORD )
+    , blocks_( capacity / FRAMES_PER_WORD )
+  {
+    if ( capacity == 0 or capacity % FRAMES_PER_WORD ) {
+      throw std::runtime_error( "PartialFrameStore capacity must be a positive multiple of 64" );
+    }
+  }
+
+  size_t range_begin() const { return num_popped_; }
+  size_t range_end() const { return num_popped_ + present_.size() * FRAMES_PER_WORD; }
+
+  bool has_value( const size_t pos ) const
+  {
+    if ( pos < range_begin() or pos >= range_end() ) {
+      return false;
+    }
+    return present_[word_of( pos )] & bit_of( pos );
+  }
+
+  const FrameType& at( const size_t pos ) const
+  {
+    if ( not has_value( pos ) ) {
+      throw std::out_of_range( "PartialFrameStore: no frame " + std::to_string( pos ) );
+    }
+    return ( *blocks_[word_of( pos )] )[pos % FRAMES_PER_WORD];
+  }
+
+  //! Mark the frame at `pos` present, and return its (reset) storage for the caller to fill in
+  FrameType& emplace( const size_t pos )
+  {
+    check_bounds( pos );
+
+    const size_t word = word_of( pos );
+    if ( not blocks_[word] ) {
+      if ( spare_blocks_.empty() ) {
+        blocks_[word] = std::make_unique<Block>();
+      } else {
+        blocks_[word] = std::move( spare_blocks_.back() );
+        spare_blocks_.pop_back();
+      }
+    }
+
+    present_[word] |= bit_of( pos );
+
+    FrameType& frame = ( *blocks_[word] )[pos % FRAMES_PER_WORD];
+    frame = {};
+    return frame;
+  }
+
+  void erase( const size_t pos )
+  {
+    check_bounds( pos );
+
+    const size_t word = word_of( pos );
+    present_[word] &= ~bit_of( pos );
+    if ( present_[word] == 0 and blocks_[word] ) {
+      release_block( word );
+    }
+  }
+
+  //! First missing frame at or after `pos` (range_end() if the rest of the window is full)
+  size_t next_missing( const size_t pos ) const { return find( std::max( pos, range_begin() ), false ); }
+
+  //! First frame held at or after `pos` (range_end() if none)
+  size_t next_present( const size_t pos ) const { return find( std::max( pos, range_begin() ), true ); }
+
+  //! Number of frames held in [begin, end)
+  size_t count( size_t begin, size_t end ) const
+  {
+    begin = std::max( begin, range_begin() );
+    end = std::min( end, range_end() );
+
+    size_t ret = 0;
+    while ( begin < end ) {
+      const size_t n = std::min( end - begin, FRAMES_PER_WORD - begin % FRAMES_PER_WORD );
+      ret += __builtin_popcountll( present_[word_of( begin )] & bits_of( begin, n ) );
+      begin += n;
+    }
+
+    return ret;
+  }
+
+  void pop( const size_t num )
+  {
+    size_t pos = range_begin();
+    const size_t end = pos + std::min( num, range_end() - range_begin() );
+
+    while ( pos < end ) {
+      const size_t n = std::min( end - pos, FRAMES_PER_WORD - pos % FRAMES_PER_WORD );
+
+      const size_t word = word_of( pos );
+      present_[word] &= ~bits_of( pos, n );
+      if ( present_[word] == 0 and blocks_[word] ) {
+        release_block( word );
+      }
+
+      pos += n;
+    }
+
+    num_popped_ += num;
+  }
+
+  //! Blocks of frames currently allocated (for the summary)
+  size_t blocks_in_use() const
+  {
+    size_t ret = 0;
+    for ( const auto& block : blocks_ ) {
+      ret += bool( block );
+    }
+    return ret;
+  }
+};
@@ -0,0 +1,107 @@
+#include "rate_controller.hh"
+#include "ewma.hh"
+
+#include <cmath>
+
+using namespace std;
+
+RateController::RateController()
+  : RateController( Config {} )
+{}
+
+RateController::RateController( const Config& config )
+  : config_( config )
+  , bit_rate_( config.max_bit_rate )
+{
+  if ( config_.min_bit_rate <= 0 or config_.min_bit_rate > config_.max_bit_rate ) {
+    throw runtime_error( "RateController: invalid bit-rate range" );
+  }
+}
+
+bool RateController::update( const SenderStatistics& sender, const uint64_t now )
+{
+  if ( not initialized_ ) {
+    /* start from the full rate, and from whatever the sender has already counted */
+    initialized_ = true;
+    next_update_ = now + config_.interval_ns;
+    last_transmissions_ = sender.packet_transmissions;
+    last_losses_ = sender.packet_losses();
+    last_frames_dropped_ = sender.frames_dropped;
+    return false;
+  }
+
+  if ( now < next_update_ ) {
+    return false;
+  }
+  next_update_ = now + config_.interval_ns;
+  intervals_++;
+
+  /* what happened during the last interval (a false positive can make the loss count go backwards) */
+  const unsigned int transmissions = sender.packet_transmissions - last_transmissions_;
+  const unsigned int losses = sender.packet_losses() > last_losses_ ? sender.packet_losses() - last_losses_ : 0;
+  const bool frames_dropped = sender.frames_dropped != last_frames_dropped_;
+
+  last_transmissions_ = sender.packet_transmissions;
+  last_losses_ = sender.packet_losses();
+  last_frames_dropped_ = sender.frames_dropped;
+
+  const float loss = transmissions ? float( losses ) / transmissions : 0;
+  ewma_update( stats_.loss, loss, 0.25 );
+
+  /* queueing delay: the smoothed RTT above the lowest seen in the window (which forgets old minima, in case
+     the route changes) */
+  const float rtt = sender.smoothed_rtt;
+  bool queue_growing = false;
+  if ( intervals_ > config_.rtt_warmup_intervals and rtt > 0 ) {
+    while ( not rtt_minima_.empty() and rtt_minima_.back().second >= rtt ) {
+      rtt_minima_.pop_back();
+    }
+    rtt_minima_.emplace_back( now, rtt );
+    while ( rtt_minima_.front().first + config_.base_rtt_window_ns < now ) {
+      rtt_minima_.pop_front();
+    }
+
+    stats_.queueing_ns = rtt - rtt_minima_.front().second;
+    queue_growing = stats_.queueing_ns > config_.queueing_threshold_ns and rtt > last_rtt_;
+  }
+  last_rtt_ = rtt;
+
+  const int old_bit_rate = bit_rate_, old_expected_loss = expected_loss_percent_;
+
+  if ( now >= hold_until_ ) {
+    if ( frames_dropped or loss > config_.loss_threshold or queue_growing ) {
+      bit_rate_ = max( config_.min_bit_rate, int( bit_rate_ * config_.decrease_factor ) );
+      hold_until_ = now + max( config_.interval_ns, uint64_t( 2 * rtt ) );
+      stats_.decreases += bit_rate_ != old_bit_rate;
+    } else {
+      bit_rate_ = min( config_.max_bit_rate, bit_rate_ + config_.increase_step );
+      stats_.increases += bit_rate_ != old_bit_rate;
+    }
+  }
+
+  expected_loss_percent_ = min( 25L, lrint( 100 * stats_.loss ) );
+
+  return bit_rate_ != old_bit_rate or expected_loss_percent_ != old_expected_loss;
+}
+
+int RateController::complexity() const
+{
+  /* with fewer bits to spend, spend more effort on each */
+  return bit_rate_ < config_.max_bit_rate ? 10 : config_.complexity_at_max_rate;
+}
+
+void RateController::apply( OpusEncoderProcess& encoder ) const
+{
+  encoder.set_bitrate( bit_rate_ );
+  encoder.set_complexity( complexity() );
+  encoder.set_expected_loss( expected_loss_percent_ );
+}
+
+void RateController::summary( ostream& out ) const
+{
+  out << "Rate control: bitrate=" << bit_rate_ / 1000 << "k complexity=" << complexity();
+  out << " expected loss=" << expected_loss_percent_ << "%";
+  out << " queueing=";
+  Timer::pp_ns( out, stats_.queueing_ns );
+  out << " increases=" << stats_.increases << " decreases=" << stats_.decreases << "\n";
+}
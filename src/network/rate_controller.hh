@@ -0,0 +1,75 @@
+#pragma once
+
+#include <deque>
+#include <ostream>
+#include <utility>
+
+#include "encoder_task.hh"
+#include "sender.hh"
+
+//! Chooses an Opus bit rate for one connection from what its NetworkSender has seen of the path
+//! \details Additive increase, multiplicative decrease: the rate is cut when the sender sees loss, queueing
+//! delay that is still growing, or frames dropped for lack of acknowledgment, and creeps back up while the
+//! path stays clean. Below the full rate the encoder works harder per bit, and is told how much loss to expect.
+class RateController
+{
+public:
+  struct Config
+  {
+    int min_bit_rate { 32000 }, max_bit_rate { 96000 };
+    int increase_step { 4000 };  /* per clean interval */
+    float decrease_factor { 0.75 };
+
+    uint64_t interval_ns { 100'000'000 };
+    float loss_threshold { 0.05 };                  /* fraction of packets in an interval */
+    uint64_t queueing_threshold_ns { 10'000'000 };  /* smoothed RTT above the lowest seen */
+    uint64_t base_rtt_window_ns { 10'000'000'000 }; /* how long the lowest RTT is remembered */
+    unsigned int rtt_warmup_intervals { 10 };       /* while the smoothed RTT is still climbing from zero */
+
+    int complexity_at_max_rate { 9 };
+  };
+
+  struct Statistics
+  {
+    unsigned int increases, decreases;
+    float loss, queueing_ns;
+  };
+
+private:
+  using SenderStatistics = NetworkSender<AudioFrame>::Statistics;
+
+  Config config_;
+  int bit_rate_;
+  int expected_loss_percent_ {};
+
+  bool initialized_ {};
+  unsigned int intervals_ {};
+  uint64_t next_update_ {};
+  uint64_t hold_until_ {}; /* after a decrease, wait for the path to show its effect */
+
+  unsigned int last_transmissions_ {}, last_losses_ {}, last_frames_dropped_ {};
+  float last_rtt_ {};
+
+  /* the lowest smoothed RTT over the last base_rtt_window_ns: (time, RTT) samples with increasing RTTs, each
+     the lowest seen since its time, so the front is the window's minimum */
+  std::deque<std::pair<uint64_t, float>> rtt_minima_ {};
+
+  Statistics stats_ {};
+
+public:
+  RateController();
+  explicit RateController( const Config& config );
+
+  //! Look at the sender's statistics (at most once per interval)
+  //! \returns true if the encoder should be retuned with apply() (never before the first full interval)
+  bool update( const SenderStatistics& sender, const uint64_t now );
+
+  void apply( OpusEncoderProcess& encoder ) const;
+
+  int bit_rate() const { return bit_rate_; }
+  int complexity() const;
+  int expected_loss_percent() const { return expected_loss_percent_; }
+
+  void summary( std::ostream& out ) const;
+  const Statistics& stats() const { return stats_; }
+};
@@ -4,51 +4,189 @@
 using namespace std;
 
 template<class FrameType>
-void NetworkReceiver<FrameType>::receive_sender_section(
-  const typename Packet<FrameType>::SenderSection& sender_section )
+void NetworkReceiver<FrameType>::receive_packet( Parser& p,
+                                                 typename Packet<FrameType>::ReceiverSection& receiver_section,
+                                                 NetString& unreliable_data )
 {
+  /* the same layout as Packet::parse() */
+  typename Packet<FrameType>::Record record;
+  receive_frames( p, record );
+
+  p.object( receiver_section );
+  p.object( unreliable_data );
+
+  NetArray<ParityFrame<FrameType>, 1> parity;
+  if ( not p.error() and not p.input().empty() ) {
+    p.object( parity );
+  }
+
+  if ( p.error() ) {
+    return;
+  }
+
   if ( not biggest_seqno_received_.has_value() ) {
-    biggest_seqno_received_ = sender_section.sequence_number;
+    biggest_seqno_received_ = record.sequence_number;
   } else {
-    biggest_seqno_received_ = max( biggest_seqno_received_.value(), sender_section.sequence_number );
+    biggest_seqno_received_ = max( biggest_seqno_received_.value(), record.sequence_number );
   }
 
-  const uint64_t now = Timer::timestamp_ns();
+  const uint64_t now = Timer::clock_ns();
+  for ( const auto& parity_frame : parity ) {
+    fec_add_parity( parity_frame, now );
+  }
 
-  for ( const auto& frame : sender_section.frames ) {
-    unreceived_beyond_this_frame_index_ = max( unreceived_beyond_this_frame_index_, frame.frame_index + 1 );
+  advance_next_frame_needed();
 
-    if ( frame.frame_index < next_frame_needed_ ) {
-      stats_.already_acked++;
-      continue;
+  if ( record.frames.length ) {
+    if ( recent_packets_.num_stored() >= recent_packets_.capacity() ) {
+      recent_packets_.pop( 1 );
     }
 
-    if ( frame.frame_index >= frames_.range_end() ) {
-      discard_frames( frame.frame_index - frames_.range_end() + 1 );
+    recent_packets_.writable_region().at( 0 ) = record;
+    recent_packets_.push( 1 );
+  }
+}
+
+template<class FrameType>
+void NetworkReceiver<FrameType>::receive_frames( Parser& p, typename Packet<FrameType>::Record& record )
+{
+  p.integer( record.sequence_number );
+  p.integer( record.frames.length );
+  if ( record.frames.length > record.frames.capacity ) {
+    p.set_error();
+  }
+
+  const uint64_t now = Timer::clock_ns();
+  const uint32_t frontier = unreceived_beyond_this_frame_index_;
+
+  for ( uint8_t i = 0; i < record.frames.length and not p.error(); i++ ) {
+    /* find the frame's slot before parsing it, then parse it there */
+    uint32_t& frame_index = record.frames.elements[i].value;
+    if ( not peek_frame_index<FrameType>( p.input(), frame_index ) ) {
+      p.set_error();
+      return;
     }
 
-    auto& dest = frames_.at( frame.frame_index );
-    if ( dest.has_value() ) {
-      stats_.redundant++;
+    if ( not claim_slot( frame_index ) ) {
+      FrameType unneeded;
+      p.object( unneeded );
       continue;
     }
 
-    dest = frame;
+    FrameType& frame = frames_.emplace( frame_index );
+    p.object( frame );
+    if ( p.error() ) {
+      frames_.erase( frame_index );
+      return;
+    }
+
     stats_.last_new_frame_received = now;
+    if ( frame_index < frontier ) {
+      stats_.late_fills++;
+    }
+    fec_add_frame( frame, now );
   }
+}
 
-  advance_next_frame_needed();
+template<class FrameType>
+bool NetworkReceiver<FrameType>::claim_slot( const uint32_t frame_index )
+{
+  unreceived_beyond_this_frame_index_ = max( unreceived_beyond_this_frame_index_, frame_index + 1 );
 
-  if ( sender_section.frames.length ) {
-    if ( recent_packets_.num_stored() >= recent_packets_.capacity() ) {
-      recent_packets_.pop( 1 );
-    }
+  if ( frame_index < next_frame_needed_ ) {
+    stats_.already_acked++;
+    return false;
+  }
 
-    recent_packets_.writable_region().at( 0 ) = sender_section.to_record();
-    recent_packets_.push( 1 );
+  if ( frame_index >= frames_.range_end() ) {
+    discard_frames( frame_index - frames_.range_end() + 1 );
+  }
+
+  if ( frames_.has_value( frame_index ) ) {
+    stats_.redundant++;
+    return false;
+  }
+
+  return true;
+}
+
+template<class FrameType>
+bool NetworkReceiver<FrameType>::store_frame( const FrameType& frame, const uint64_t now )
+{
+  if ( not claim_slot( frame.frame_index ) ) {
+    return false;
+  }
+
+  frames_.emplace( frame.frame_index ) = frame;
+  stats_.last_new_frame_received = now;
+  return true;
+}
+
+template<class FrameType>
+typename NetworkReceiver<FrameType>::FecGroup* NetworkReceiver<FrameType>::fec_group( const uint32_t group_index )
+{
+  FecGroup& group = fec_groups_[group_index % FEC_GROUPS_TRACKED];
+  if ( group.in_use and group.accumulator.group_index == group_index ) {
+    return &group;
+  }
+
+  /* the slot belongs to a newer group, so this one is too old to matter */
+  if ( group.in_use and group.accumulator.group_index > group_index ) {
+    return nullptr;
+  }
+
+  group = {};
+  group.accumulator.group_index = group_index;
+  group.in_use = true;
+  return &group;
+}
+
+template<class FrameType>
+void NetworkReceiver<FrameType>::fec_add_frame( const FrameType& frame, const uint64_t now )
+{
+  if ( not fec_active_ ) {
+    return;
+  }
+
+  FecGroup* group = fec_group( frame.frame_index / FrameType::fec_group_size );
+  if ( group ) {
+    group->accumulator.add( frame );
+    group->frames_received++;
+    fec_try_recover( *group, now );
+  }
+}
+
+template<class FrameType>
+void NetworkReceiver<FrameType>::fec_add_parity( const ParityFrame<FrameType>& parity, const uint64_t now )
+{
+  fec_active_ = true;
+
+  FecGroup* group = fec_group( parity.group_index );
+  if ( group and not group->parity_received ) {
+    group->accumulator.add( parity );
+    group->parity_received = true;
+    fec_try_recover( *group, now );
   }
 }
 
+template<class FrameType>
+void NetworkReceiver<FrameType>::fec_try_recover( FecGroup& group, const uint64_t now )
+{
+  if ( not group.parity_received or group.frames_received != FrameType::fec_group_size - 1 ) {
+    return;
+  }
+
+  /* the parity with every other frame XORed out is the missing frame */
+  FrameType frame;
+  if ( group.accumulator.extract( frame )
+       and frame.frame_index / FrameType::fec_group_size == group.accumulator.group_index
+       and store_frame( frame, now ) ) {
+    stats_.fec_recovered++;
+  }
+
+  group.frames_received = FrameType::fec_group_size;
+}
+
 template<class FrameType>
 void NetworkReceiver<FrameType>::discard_frames( const unsigned int num )
 {
@@ -61,9 +199,7 @@ void NetworkReceiver<FrameType>::discard_frames( const unsigned int num )
 template<class FrameType>
 void NetworkReceiver<FrameType>::advance_next_frame_needed()
 {
-  while ( next_frame_needed_ < frames_.range_end() and frames_.at( next_frame_needed_ ).has_value() ) {
-    next_frame_needed_++;
-  }
+  next_frame_needed_ = frames_.next_missing( next_frame_needed_ );
 }
 
 template<class FrameType>
@@ -72,10 +208,14 @@ void NetworkReceiver<FrameType>::set_receiver_section(
 {
   receiver_section.next_frame_needed = next_frame_needed_;
 
-  if ( biggest_seqno_received_.has_value() ) {
-    receiver_section.packets_received.push_back( biggest_seqno_received_.value() );
+  if ( not biggest_seqno_received_.has_value() ) {
+    return;
   }
 
+  auto& acks = receiver_section.packets_received;
+  acks.add( biggest_seqno_received_.value() );
+
+  /* newest first; arrival order is only roughly sequence order, so stop a little past the bitmap's reach */
   const span_view<typename Packet<FrameType>::Record> recent = recent_packets_.readable_region();
   for ( auto it = recent.end() - 1; it >= recent.begin(); --it ) {
     const auto& p = *it;
@@ -83,6 +223,10 @@ void NetworkReceiver<FrameType>::set_receiver_section(
       continue;
     }
 
+    if ( p.sequence_number + SelectiveAcks::window + SACK_REORDER_SLACK < biggest_seqno_received_.value() ) {
+      break;
+    }
+
     // does the packet acknowledge a frame that isn't otherwise acknowledged?
     bool sack_the_packet = false;
     for ( const auto frame_index : p.frames ) {
@@ -95,10 +239,7 @@ void NetworkReceiver<FrameType>::set_receiver_section(
       }
     }
     if ( sack_the_packet ) {
-      receiver_section.packets_received.push_back( p.sequence_number );
-      if ( receiver_section.packets_received.length >= receiver_section.packets_received.capacity ) {
-        break;
-      }
+      acks.add( p.sequence_number );
     }
   }
 }
@@ -110,7 +251,7 @@ void NetworkReceiver<FrameType>::summary( ostream& out ) const
 
   if ( stats_.last_new_frame_received.has_value() ) {
     out << " last_new_frame=";
-    Timer::pp_ns( out, Timer::timestamp_ns() - stats_.last_new_frame_received.value() );
+    Timer::pp_ns( out, Timer::clock_ns() - stats_.last_new_frame_received.value() );
   }
 
   if ( stats_.already_acked ) {
@@ -122,19 +263,19 @@ void NetworkReceiver<FrameType>::summary( ostream& out ) const
   if ( stats_.dropped ) {
     out << " dropped=" << stats_.dropped << "!";
   }
+  if ( stats_.fec_recovered ) {
+    out << " fec_recovered=" << stats_.fec_recovered;
+  }
+  if ( stats_.late_fills ) {
+    out << " late_fills=" << stats_.late_fills;
+  }
 
   const uint32_t contiguous_count = next_frame_needed_ - frames_.range_begin();
-  uint32_t other_count = 0;
+  const uint32_t held_end = min( uint32_t( frames_.range_end() ), unreceived_beyond_this_frame_index_ );
+  const uint32_t other_count = frames_.count( next_frame_needed_, held_end );
   optional<uint32_t> first_other_held;
-  for ( uint32_t i = next_frame_needed_;
-        i < min( uint32_t( frames_.range_end() ), unreceived_beyond_this_frame_index_ );
-        i++ ) {
-    if ( frames_[i].has_value() ) {
-      other_count++;
-      if ( not first_other_held.has_value() ) {
-        first_other_held = i;
-      }
-    }
+  if ( other_count ) {
+    first_other_held = frames_.next_present( next_frame_needed_ );
   }
 
   if ( stats_.popped ) {
@@ -152,6 +293,8 @@ void NetworkReceiver<FrameType>::summary( ostream& out ) const
         << unreceived_beyond_this_frame_index_ - 1 << ")";
   }
 
+  out << " blocks=" << frames_.blocks_in_use();
+
   out << "\n";
 }
 
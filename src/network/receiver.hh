@@ -1,27 +1,13 @@
 #pragma once
 
+#include <array>
+
 #include "eventloop.hh"
 #include "formats.hh"
+#include "partial_frame_store.hh"
 #include "socket.hh"
 #include "typed_ring_buffer.hh"
 
-template<class FrameType>
-class PartialFrameStore : public EndlessBuffer<std::optional<FrameType>>
-{
-  using parent = EndlessBuffer<std::optional<FrameType>>;
-
-public:
-  using parent::parent;
-
-  bool has_value( const size_t pos ) const
-  {
-    if ( pos < parent::range_begin() or pos >= parent::range_end() ) {
-      return false;
-    }
-    return parent::at( pos ).has_value();
-  }
-};
-
 template<class FrameType>
 class NetworkReceiver
 {
@@ -32,7 +18,30 @@ class NetworkReceiver
   std::optional<uint32_t> biggest_seqno_received_ {};
 
   TypedRingBuffer<typename Packet<FrameType>::Record> recent_packets_ { 512 };
+  static constexpr uint32_t SACK_REORDER_SLACK = 64;
+
+  /* forward error correction: a running XOR of each recent group's frames and parity (once the sender has
+     sent any parity), so a group missing one frame can be completed even after its other frames are popped */
+  struct FecGroup
+  {
+    ParityFrame<FrameType> accumulator {};
+    uint8_t frames_received {};
+    bool parity_received {};
+    bool in_use {};
+  };
+
+  static constexpr size_t FEC_GROUPS_TRACKED = 64;
+  std::array<FecGroup, FEC_GROUPS_TRACKED> fec_groups_ {};
+  bool fec_active_ {};
+
+  FecGroup* fec_group( const uint32_t group_index );
+  void fec_add_frame( const FrameType& frame, const uint64_t now );
+  void fec_add_parity( const ParityFrame<FrameType>& parity, const uint64_t now );
+  void fec_try_recover( FecGroup& group, const uint64_t now );
 
+  bool claim_slot( const uint32_t frame_index );
+  bool store_frame( const FrameType& frame, const uint64_t now );
+  void receive_frames( Parser& p, typename Packet<FrameType>::Record& record );
   void discard_frames( const unsigned int num );
   void advance_next_frame_needed();
 
@@ -40,6 +49,7 @@ public:
   struct Statistics
   {
     unsigned int already_acked, redundant, dropped, popped;
+    unsigned int fec_recovered, late_fills; /* holes filled by parity, or by a late (retransmitted) copy */
     std::optional<uint64_t> last_new_frame_received;
   };
 
@@ -47,7 +57,12 @@ private:
   Statistics stats_ {};
 
 public:
-  void receive_sender_section( const typename Packet<FrameType>::SenderSection& sender_section );
+  //! Parse a packet, with each new frame parsed straight into its slot in the frame store
+  //! \details The sections meant for this side's NetworkSender are handed back. If the packet turns out to be
+  //! malformed (p.error() is set), frames already parsed are kept, but the packet is not acknowledged.
+  void receive_packet( Parser& p,
+                       typename Packet<FrameType>::ReceiverSection& receiver_section,
+                       NetString& unreliable_data );
   void set_receiver_section( typename Packet<FrameType>::ReceiverSection& receiver_section );
 
   void summary( std::ostream& out ) const;
@@ -28,6 +28,28 @@ void NetworkSender<FrameType>::summary( ostream& out ) const
         << setw( 2 ) << 100.0 * stats_.packet_losses() / float( stats_.packet_transmissions ) << "%";
   }
 
+  if ( stats_.frame_retransmissions ) {
+    out << " retransmitted frames=" << stats_.frame_retransmissions;
+
+    out << " (per packet";
+    for ( size_t i = 1; i < stats_.retransmit_burst_sizes.size(); i++ ) {
+      if ( stats_.retransmit_burst_sizes[i] ) {
+        out << " " << i << ":" << stats_.retransmit_burst_sizes[i];
+      }
+    }
+    out << ")";
+  }
+
+  if ( stats_.paced_packets ) {
+    out << " paced packets=" << stats_.paced_packets;
+  }
+
+  out << " delivery rate=" << int( stats_.delivery_rate * 8 / 1000 ) << " kbit/s";
+
+  if ( stats_.parity_frames_sent ) {
+    out << " parity frames=" << stats_.parity_frames_sent;
+  }
+
   if ( stats_.packet_loss_false_positives ) {
     out << " loss false positives=" << stats_.packet_loss_false_positives << "!";
   }
@@ -80,7 +102,7 @@ void NetworkSender<FrameType>::summary( ostream& out ) const
 }
 
 template<class FrameType>
-void NetworkSender<FrameType>::set_sender_section( typename Packet<FrameType>::SenderSection& p )
+void NetworkSender<FrameType>::set_sender_section( OutboundPacket<FrameType>& p )
 {
   if ( frames_.range_begin() != frame_status_.range_begin() ) {
     throw runtime_error( "NetworkSender internal error" );
@@ -88,6 +110,24 @@ void NetworkSender<FrameType>::set_sender_section( typename Packet<FrameType>::S
 
   p.sequence_number = next_sequence_number_++;
 
+  const uint64_t now = Timer::clock_ns();
+  refill_retransmit_budget( now );
+
+  uint16_t bytes = 0;
+  unsigned int retransmitted = 0;
+  bool paced = false;
+
+  auto add_frame = [&]( const FrameType& frame, FrameStatus& status ) {
+    p.add_frame( frame );
+    bytes += frame.serialized_length();
+    if ( status.transmitted ) {
+      stats_.frame_retransmissions++;
+      retransmit_budget_ -= frame.serialized_length();
+      retransmitted++;
+    }
+    status.in_flight = status.transmitted = true;
+  };
+
   /* send some frames! */
   if ( frames_.range_begin() == next_frame_index_ ) { // nothing to send
     stats_.empty_packets++;
@@ -96,8 +136,7 @@ void NetworkSender<FrameType>::set_sender_section( typename Packet<FrameType>::S
     const auto& most_recent_frame = frames_.at( next_frame_index_ - 1 );
     auto& most_recent_status = frame_status_.at( next_frame_index_ - 1 );
     if ( most_recent_status.needs_send() ) {
-      p.frames.push_back( most_recent_frame );
-      most_recent_status.in_flight = true;
+      add_frame( most_recent_frame, most_recent_status );
       need_immediate_send_ = false;
     }
 
@@ -110,16 +149,32 @@ void NetworkSender<FrameType>::set_sender_section( typename Packet<FrameType>::S
       auto& status = statuses[i];
 
       if ( status.needs_send() ) {
-        p.frames.push_back( frames[i] );
-        status.in_flight = true;
+        /* a retransmission waits for a later packet once the budget runs out */
+        if ( status.transmitted and retransmit_budget_ <= 0 ) {
+          paced = true;
+          continue;
+        }
 
-        if ( p.frames.length >= p.frames.capacity ) {
+        add_frame( frames[i], status );
+
+        if ( p.full() ) {
           break;
         }
       }
     }
   }
 
+  stats_.paced_packets += paced;
+  stats_.retransmit_burst_sizes.at( retransmitted )++;
+
+  /* parity for a group goes out once the group's last frame has had a packet of its own */
+  if ( ready_parity_.has_value() and not ready_parity_sent_ and next_frame_index_ > 0
+       and ready_parity_->group_index < ( next_frame_index_ - 1 ) / FrameType::fec_group_size ) {
+    p.parity = &ready_parity_.value();
+    ready_parity_sent_ = true;
+    stats_.parity_frames_sent++;
+  }
+
   /* make room to store the packet in flight */
   if ( p.sequence_number >= packets_in_flight_.range_end() ) {
     const size_t num_packets_to_drop = p.sequence_number - packets_in_flight_.range_end() + 1;
@@ -138,10 +193,58 @@ void NetworkSender<FrameType>::set_sender_section( typename Packet<FrameType>::S
   pack.record = p.to_record();
   pack.assumed_lost = false;
   pack.acked = false;
-  pack.sent_timestamp = Timer::timestamp_ns();
+  pack.sent_timestamp = now;
+  pack.delivered_at_send = bytes_delivered_;
+  pack.bytes = bytes;
   stats_.packet_transmissions++;
 }
 
+template<class FrameType>
+void NetworkSender<FrameType>::refill_retransmit_budget( const uint64_t now )
+{
+  const float rate = max( MIN_RETRANSMIT_RATE, RETRANSMIT_GAIN * stats_.delivery_rate );
+  const float max_budget = rate * MAX_BURST_NS / BILLION;
+
+  if ( budget_refilled_at_ == 0 ) {
+    retransmit_budget_ = max_budget;
+  } else if ( now > budget_refilled_at_ ) {
+    const float refill = rate * ( now - budget_refilled_at_ ) / BILLION;
+    retransmit_budget_ = min( max_budget, retransmit_budget_ + refill );
+  }
+
+  budget_refilled_at_ = now;
+}
+
+template<class FrameType>
+void NetworkSender<FrameType>::enable_fec( const bool enabled )
+{
+  fec_enabled_ = enabled;
+  building_parity_ = {};
+  frames_in_building_parity_ = 0;
+  ready_parity_.reset();
+  ready_parity_sent_ = false;
+}
+
+template<class FrameType>
+void NetworkSender<FrameType>::add_to_parity( const FrameType& frame )
+{
+  const uint32_t group_index = frame.frame_index / FrameType::fec_group_size;
+
+  /* a group only gets parity if FEC was on for the whole group */
+  if ( frames_in_building_parity_ == 0 or building_parity_.group_index != group_index ) {
+    building_parity_ = {};
+    building_parity_.group_index = group_index;
+    frames_in_building_parity_ = 0;
+  }
+
+  building_parity_.add( frame );
+  if ( ++frames_in_building_parity_ == FrameType::fec_group_size ) {
+    ready_parity_ = building_parity_;
+    ready_parity_sent_ = false;
+    frames_in_building_parity_ = 0;
+  }
+}
+
 template<class FrameType>
 void NetworkSender<FrameType>::assume_departed( const PacketSentRecord& pack, const bool is_loss )
 {
@@ -189,7 +292,7 @@ void NetworkSender<FrameType>::receive_receiver_section(
 
   optional<uint32_t> greatest_new_sack;
 
-  const uint64_t now = Timer::timestamp_ns();
+  const uint64_t now = Timer::clock_ns();
 
   /* For each selectively ACKed packet, mark its Frames as no longer outstanding */
   for ( const uint32_t sack : receiver_section.packets_received ) {
@@ -220,12 +323,17 @@ void NetworkSender<FrameType>::receive_receiver_section(
       }
 
       pack.acked = true;
+      bytes_delivered_ += pack.bytes;
 
       const int64_t time_diff = now - pack.sent_timestamp;
       if ( time_diff <= 0 ) {
         stats_.invalid_timestamp++;
       } else {
         ewma_update( stats_.smoothed_rtt, float( time_diff ), stats_.SRTT_ALPHA );
+
+        /* everything delivered while this packet was in flight */
+        const float delivery_rate = ( bytes_delivered_ - pack.delivered_at_send ) * float( BILLION ) / time_diff;
+        ewma_update( stats_.delivery_rate, delivery_rate, stats_.SRTT_ALPHA );
       }
 
       for ( const uint32_t frame_index : pack.record.frames ) {
@@ -234,7 +342,7 @@ void NetworkSender<FrameType>::receive_receiver_section(
         }
 
         if ( frame_index >= frame_status_.range_begin() ) {
-          frame_status_.at( frame_index ) = { false, false };
+          frame_status_.at( frame_index ) = { false, false, true };
         }
       }
     }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <ostream>
 
 #include "encoder_task.hh"
@@ -13,6 +14,7 @@ class NetworkSender
   {
     bool outstanding : 1;
     bool in_flight : 1;
+    bool transmitted : 1; /* sent at least once, so the next send is a retransmission */
 
     bool needs_send() const { return outstanding and not in_flight; }
   };
@@ -29,6 +31,8 @@ class NetworkSender
   {
     typename Packet<FrameType>::Record record;
     uint64_t sent_timestamp;
+    uint64_t delivered_at_send; /* bytes_delivered_ when sent, for a delivery-rate sample when acked */
+    uint16_t bytes;
     bool acked : 1;
     bool assumed_lost : 1;
   };
@@ -38,6 +42,33 @@ class NetworkSender
 
   bool need_immediate_send_ {};
 
+  /* forward error correction: parity over each group of FrameType::fec_group_size consecutive frames,
+     sent in the packet after the one that first carries the group's last frame */
+  bool fec_enabled_ {};
+  ParityFrame<FrameType> building_parity_ {};
+  uint8_t frames_in_building_parity_ {};
+  std::optional<ParityFrame<FrameType>> ready_parity_ {};
+  bool ready_parity_sent_ {}; /* kept until the next group is ready, since the packet refers to it */
+
+  void add_to_parity( const FrameType& frame );
+  void enable_fec( const bool enabled );
+
+  /* pacing: retransmissions draw on a byte budget that refills in proportion to the measured delivery rate,
+     so the repair of a loss burst is spread over several packets instead of arriving as full packets (the
+     floor on the rate, and the most the budget holds, depend on the size of the frames) */
+  static constexpr float RETRANSMIT_GAIN = 1.0; /* retransmissions add at most this multiple of the delivery rate */
+  static constexpr float MIN_RETRANSMIT_RATE = FrameType::min_retransmit_rate; /* bytes per second */
+  static constexpr uint64_t MAX_BURST_NS = FrameType::max_retransmit_burst_ns;
+
+  static_assert( MIN_RETRANSMIT_RATE * MAX_BURST_NS / BILLION >= FrameType::max_serialized_length,
+                 "a full retransmit budget must hold at least one frame" );
+
+  float retransmit_budget_ {};
+  uint64_t budget_refilled_at_ {};
+  uint64_t bytes_delivered_ {};
+
+  void refill_retransmit_budget( const uint64_t now );
+
   void assume_departed( const PacketSentRecord& pack, const bool is_loss );
 
 public:
@@ -47,13 +78,17 @@ public:
 
     unsigned int frames_dropped {}, empty_packets {}, bad_acks {}, packet_transmissions {},
       packet_losses_detected {}, packet_loss_false_positives {}, frames_departed_by_expiration {},
-      invalid_timestamp {};
+      invalid_timestamp {}, frame_retransmissions {}, parity_frames_sent {}, paced_packets {};
 
     float smoothed_rtt {};
+    float delivery_rate {}; /* bytes of frames per second */
+
+    /* how many packets carried each number of retransmitted frames */
+    std::array<unsigned int, FrameType::frames_per_packet + 1> retransmit_burst_sizes {};
 
     unsigned int packet_losses() const { return packet_losses_detected - packet_loss_false_positives; }
 
-    uint64_t last_good_ack_ts = Timer::timestamp_ns();
+    uint64_t last_good_ack_ts = Timer::clock_ns();
   };
 
 private:
@@ -82,8 +117,12 @@ public:
       stats_.frames_dropped += frames_to_drop;
     }
 
-    frames_.at( next_frame_index_ ) = encoder.front( next_frame_index_ );
-    frame_status_.at( next_frame_index_ ) = { true, false };
+    /* the source writes the frame into its slot, which outbound packets then serialize from */
+    encoder.front( next_frame_index_, frames_.at( next_frame_index_ ) );
+    frame_status_.at( next_frame_index_ ) = { true, false, false };
+    if ( fec_enabled_ ) {
+      add_to_parity( frames_.at( next_frame_index_ ) );
+    }
     next_frame_index_++;
 
     need_immediate_send_ = true;
@@ -91,7 +130,20 @@ public:
     encoder.pop_frame();
   }
 
-  void set_sender_section( typename Packet<FrameType>::SenderSection& p );
+  //! Choose the frames (and parity) for the next packet
+  //! \details `p` refers to them in place, so serialize it before the next push_frame() or acknowledgment
+  void set_sender_section( OutboundPacket<FrameType>& p );
+
+  //! Send XOR parity for each group of frames, so the receiver can rebuild one lost frame per group
+  //! \details Only for frames small enough that the parity fits in a packet full of them (audio, not video).
+  template<class F = FrameType>
+  void set_fec( const bool enabled )
+  {
+    static_assert( Packet<F>::max_serialized_length_with_parity <= Plaintext::capacity(),
+                   "parity would not fit in a packet with a full load of frames" );
+    enable_fec( enabled );
+  }
+
   void receive_receiver_section( const typename Packet<FrameType>::ReceiverSection& receiver_section );
 
   void summary( std::ostream& out ) const;
@@ -108,21 +108,22 @@ void Cursor::sample( const PartialFrameStore<AudioFrame>& frames,
 
   /* Do we have an Opus frame ready to decode? */
   if ( not frames.has_value( frame_cursor ) ) {
-    /* no, so leave it as silence */
+    /* no, so conceal it (which also keeps the decoder's state continuous, so the next real frame doesn't click) */
     miss();
-    fill( ch1_decoded.begin(), ch1_decoded.end(), 0 );
-    fill( ch2_decoded.begin(), ch2_decoded.end(), 0 );
+
+    decoder.decode_missing( ch1_decoded, ch2_decoded );
+    stats_.concealments++;
   } else {
     /* decode a frame! */
     hit();
 
-    if ( frames.at( frame_cursor ).value().separate_channels ) {
-      decoder.decode( frames.at( frame_cursor ).value().frame1,
-                      frames.at( frame_cursor ).value().frame2,
+    if ( frames.at( frame_cursor ).separate_channels ) {
+      decoder.decode( frames.at( frame_cursor ).frame1,
+                      frames.at( frame_cursor ).frame2,
                       ch1_decoded,
                       ch2_decoded );
     } else {
-      decoder.decode_stereo( frames.at( frame_cursor ).value().frame1, ch1_decoded, ch2_decoded );
+      decoder.decode_stereo( frames.at( frame_cursor ).frame1, ch1_decoded, ch2_decoded );
     }
   }
 
@@ -173,6 +174,7 @@ void Cursor::summary( ostream& out ) const
   out << " rate=" << int( rate_ );
   out << " resets=" << stats_.resets;
   out << " fades=" << stats_.fades_in;
+  out << " concealed=" << stats_.concealments;
   out << "\n";
 }
 
@@ -28,6 +28,7 @@ class Cursor
     unsigned int compress_starts, compress_stops;
     unsigned int expand_starts, expand_stops;
     unsigned int fades_in;
+    unsigned int concealments;
   } stats_ {};
 
   std::optional<size_t> num_samples_output_ {};
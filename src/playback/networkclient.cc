@@ -17,11 +17,16 @@ void NetworkClient::NetworkSession::transmit_frame( OpusEncoderProcess& source,
 {
   connection.push_frame( source );
   connection.send_packet( socket );
+
+  /* retune the (shared) encoder to this session's uplink */
+  if ( rate_controller.update( connection.sender_stats(), Timer::clock_ns() ) ) {
+    rate_controller.apply( source );
+  }
 }
 
-void NetworkClient::NetworkSession::network_receive( const Ciphertext& ciphertext )
+void NetworkClient::NetworkSession::network_receive( Ciphertext& ciphertext )
 {
-  connection.receive_packet( ciphertext );
+  connection.receive_packet_in_place( ciphertext );
 }
 
 void NetworkClient::NetworkSession::decode( const size_t decode_cursor,
@@ -55,6 +60,7 @@ void NetworkClient::NetworkSession::summary( std::ostream& out ) const
 {
   cursor.summary( out );
   connection.summary( out );
+  rate_controller.summary( out );
 }
 
 void NetworkClient::process_keyreply( const Ciphertext& ciphertext )
@@ -71,6 +77,7 @@ void NetworkClient::process_keyreply( const Ciphertext& ciphertext )
       return;
     }
     session_.emplace( keys.id, keys.key_pair, server_ );
+    session_->connection.set_fec( fec_ );
     stats_.new_sessions++;
   } else {
     stats_.bad_packets++;
@@ -137,9 +144,10 @@ NetworkClient::NetworkClient( const Address& server,
     "decode",
     [&] {
       session_->decode( decode_cursor_, decoder_, stretcher_, dest_->playback() );
+      dest_->commit_playback( decode_cursor_ );
       decode_cursor_ += opus_frame::NUM_SAMPLES_MINLATENCY;
 
-      if ( session_->connection.sender_stats().last_good_ack_ts + 4'000'000'000 < Timer::timestamp_ns() ) {
+      if ( session_->connection.sender_stats().last_good_ack_ts + 4'000'000'000 < Timer::clock_ns() ) {
         stats_.timeouts++;
         session_.reset();
       }
@@ -151,7 +159,10 @@ NetworkClient::NetworkClient( const Address& server,
 
   loop.add_rule(
     "play silence",
-    [&] { decode_cursor_ += opus_frame::NUM_SAMPLES_MINLATENCY; },
+    [&] {
+      decode_cursor_ += opus_frame::NUM_SAMPLES_MINLATENCY;
+      dest_->commit_playback( decode_cursor_ );
+    },
     [&] {
       return ( !session_.has_value() )
              and ( dest_->cursor() + opus_frame::NUM_SAMPLES_MINLATENCY + 60 >= decode_cursor_ );
@@ -200,3 +211,11 @@ void NetworkClient::set_cursor_lag( const uint16_t target_samples,
     session_->cursor.set_target_lag( target_samples, min_samples, max_samples );
   }
 }
+
+void NetworkClient::set_fec( const bool enabled )
+{
+  fec_ = enabled;
+  if ( session_.has_value() ) {
+    session_->connection.set_fec( enabled );
+  }
+}
@@ -6,6 +6,7 @@
 #include "cursor.hh"
 #include "encoder_task.hh"
 #include "keys.hh"
+#include "rate_controller.hh"
 
 #include <rubberband/RubberBandStretcher.h>
 
@@ -15,11 +16,12 @@ class NetworkClient : public Summarizable
   {
     AudioNetworkConnection connection;
     Cursor cursor;
+    RateController rate_controller {};
 
     NetworkSession( const uint8_t node_id, const KeyPair& session_key, const Address& destination );
 
     void transmit_frame( OpusEncoderProcess& source, UDPSocket& socket );
-    void network_receive( const Ciphertext& ciphertext );
+    void network_receive( Ciphertext& ciphertext );
     void decode( const size_t decode_cursor,
                  OpusDecoderProcess& decoder,
                  RubberBand::RubberBandStretcher& stretcher,
@@ -35,6 +37,7 @@ class NetworkClient : public Summarizable
   CryptoSession long_lived_crypto_;
 
   std::optional<NetworkSession> session_ {};
+  bool fec_ {};
   OpusDecoderProcess decoder_ { false };
   RubberBand::RubberBandStretcher stretcher_;
 
@@ -63,6 +66,9 @@ public:
 
   void set_cursor_lag( const uint16_t target_samples, const uint16_t min_samples, const uint16_t max_samples );
 
+  //! Send XOR parity with the audio, in this session and every later one (see NetworkSender::set_fec)
+  void set_fec( const bool enabled );
+
   bool has_session() const { return session_.has_value(); }
   const Cursor& cursor() const { return session_->cursor; }
 
@@ -36,6 +36,32 @@ void AudioBoard::pop_samples_until( const uint64_t sample )
 
     channel.pop_before( sample );
   }
+
+  bus_.pop_before( sample );
+}
+
+void AudioBoard::mix_bus_until( const uint64_t sample )
+{
+  bus_cursor_ = max( bus_cursor_, uint64_t( bus_.range_begin() ) );
+
+  if ( sample <= bus_cursor_ ) {
+    return;
+  }
+
+  const size_t length = sample - bus_cursor_;
+
+  mix_inputs_.clear();
+  for ( uint8_t channel_i = 0; channel_i < num_channels(); channel_i++ ) {
+    const span_view<float> samples = channel( channel_i ).region( bus_cursor_, length );
+    const auto [gain_into_1, gain_into_2] = gain( channel_i );
+    mix_inputs_.push_back( { samples.data(), gain_into_1, gain_into_2 } );
+  }
+
+  MixKernel::best().mix( { mix_inputs_.data(), mix_inputs_.size() },
+                         bus_.ch1().region( bus_cursor_, length ),
+                         bus_.ch2().region( bus_cursor_, length ) );
+
+  bus_cursor_ = sample;
 }
 
 void AudioBoard::json_summary( Json::Value& root, const bool include_second_channels ) const
@@ -54,31 +80,15 @@ void AudioBoard::json_summary( Json::Value& root, const bool include_second_chan
 
 void AudioWriter::mix_and_write( const AudioBoard& board, const uint64_t cursor_sample )
 {
-  while ( mix_cursor_ + opus_frame::NUM_SAMPLES_MINLATENCY <= cursor_sample ) {
-    span<float> ch1_target = mixed_audio_.ch1().region( mix_cursor_, opus_frame::NUM_SAMPLES_MINLATENCY );
-    span<float> ch2_target = mixed_audio_.ch2().region( mix_cursor_, opus_frame::NUM_SAMPLES_MINLATENCY );
-
-    for ( uint8_t channel_i = 0; channel_i < board.num_channels(); channel_i++ ) {
-      const span_view<float> other_channel
-        = board.channel( channel_i ).region( mix_cursor_, opus_frame::NUM_SAMPLES_MINLATENCY );
-
-      const auto [gain_into_1, gain_into_2] = board.gain( channel_i );
-      for ( uint8_t sample_i = 0; sample_i < opus_frame::NUM_SAMPLES_MINLATENCY; sample_i++ ) {
-        const float value = other_channel[sample_i];
-        const float orig_1 = ch1_target[sample_i];
-        const float orig_2 = ch2_target[sample_i];
-
-        ch1_target[sample_i] = orig_1 + gain_into_1 * value;
-        ch2_target[sample_i] = orig_2 + gain_into_2 * value;
-      }
-    }
+  if ( board.bus_cursor() < cursor_sample ) {
+    throw runtime_error( "AudioWriter::mix_and_write: board has not been mixed up to cursor" );
+  }
 
-    encoder_.encode_one_frame( mixed_audio_.ch1(), mixed_audio_.ch2() );
+  while ( encoder_.min_encode_cursor() + opus_frame::NUM_SAMPLES_MINLATENCY <= cursor_sample ) {
+    encoder_.encode_one_frame( board.bus().ch1(), board.bus().ch2() );
     auto frame_mutable = encoder_.front( 0 );
     socket_.sendto_ignore_errors( destination_, frame_mutable.frame1 );
     encoder_.pop_frame();
-    mix_cursor_ += opus_frame::NUM_SAMPLES_MINLATENCY;
-    mixed_audio_.pop_before( mix_cursor_ );
   }
 }
 
@@ -4,6 +4,7 @@
 
 #include "audio_buffer.hh"
 #include "encoder_task.hh"
+#include "mix_kernel.hh"
 #include "socket.hh"
 
 #include <json/json.h>
@@ -15,6 +16,10 @@ class AudioBoard
   std::vector<std::pair<float, float>> gains_ {};
   std::vector<float> power_ {};
 
+  ChannelPair bus_ { 8192 };
+  uint64_t bus_cursor_ {};
+  std::vector<MixInput> mix_inputs_ {};
+
 public:
   AudioBoard( const std::string_view name, const uint8_t num_channels );
 
@@ -32,6 +37,11 @@ public:
 
   void pop_samples_until( const uint64_t sample );
 
+  //! Sum every channel (with its gains) into the bus, up to but not including `sample`
+  void mix_bus_until( const uint64_t sample );
+  const ChannelPair& bus() const { return bus_; }
+  uint64_t bus_cursor() const { return bus_cursor_; }
+
   uint8_t num_channels() const { return channels_.size(); }
   const std::string& channel_name( const uint8_t num ) const { return channels_.at( num ).first; }
 
@@ -42,10 +52,6 @@ public:
 
 class AudioWriter
 {
-  ChannelPair mixed_audio_ { 8192 };
-
-  uint64_t mix_cursor_ {};
-
   OpusEncoderProcess encoder_ { 96000, 48000 };
 
   Address destination_;
@@ -134,32 +134,38 @@ void Client::mix_and_encode( const AudioBoard& board, const uint64_t cursor_samp
     return;
   }
 
+  if ( board.bus_cursor() < cursor_sample ) {
+    throw runtime_error( "Client::mix_and_encode: board has not been mixed up to cursor" );
+  }
+
   while ( server_mix_cursor() + opus_frame::NUM_SAMPLES_MINLATENCY <= cursor_sample ) {
     span<float> ch1_target = mixed_audio_.ch1().region( client_mix_cursor(), opus_frame::NUM_SAMPLES_MINLATENCY );
     span<float> ch2_target = mixed_audio_.ch2().region( client_mix_cursor(), opus_frame::NUM_SAMPLES_MINLATENCY );
 
-    for ( uint8_t channel_i = 0; channel_i < board.num_channels(); channel_i++ ) {
-      if ( channel_i == ch1_num_ or channel_i == ch2_num_ ) {
-        continue;
-      }
+    /* the client hears everyone but itself: start from the whole board's mix and subtract its own channels */
+    ch1_target.copy( board.bus().ch1().region( server_mix_cursor(), opus_frame::NUM_SAMPLES_MINLATENCY ) );
+    ch2_target.copy( board.bus().ch2().region( server_mix_cursor(), opus_frame::NUM_SAMPLES_MINLATENCY ) );
 
-      const span_view<float> other_channel
+    array<MixInput, 2> own_channels;
+    for ( uint8_t i = 0; i < own_channels.size(); i++ ) {
+      const uint8_t channel_i = i ? ch2_num_ : ch1_num_;
+      const span_view<float> own_channel
         = board.channel( channel_i ).region( server_mix_cursor(), opus_frame::NUM_SAMPLES_MINLATENCY );
 
       const auto [gain_into_1, gain_into_2] = board.gain( channel_i );
-      for ( uint8_t sample_i = 0; sample_i < opus_frame::NUM_SAMPLES_MINLATENCY; sample_i++ ) {
-        const float value = other_channel[sample_i];
-        const float orig_1 = ch1_target[sample_i];
-        const float orig_2 = ch2_target[sample_i];
-
-        ch1_target[sample_i] = orig_1 + gain_into_1 * value;
-        ch2_target[sample_i] = orig_2 + gain_into_2 * value;
-      }
+      own_channels[i] = { own_channel.data(), -gain_into_1, -gain_into_2 };
     }
 
+    MixKernel::best().mix( { own_channels.data(), own_channels.size() }, ch1_target, ch2_target );
+
     mix_cursor_ += opus_frame::NUM_SAMPLES_MINLATENCY;
   }
 
+  /* retune the encoder to this client's downlink */
+  if ( rate_controller_.update( connection_.sender_stats(), Timer::clock_ns() ) ) {
+    rate_controller_.apply( encoder_ );
+  }
+
   /* encode audio */
   while ( encoder_.min_encode_cursor() + opus_frame::NUM_SAMPLES_MINLATENCY <= client_mix_cursor() ) {
     encoder_.encode_one_frame( mixed_audio_.ch1(), mixed_audio_.ch2() );
@@ -170,11 +176,14 @@ void Client::mix_and_encode( const AudioBoard& board, const uint64_t cursor_samp
   mixed_audio_.pop_before( encoder_.min_encode_cursor() );
 }
 
-void Client::send_packet( UDPSocket& socket )
+bool Client::make_packet( Ciphertext& ciphertext )
 {
-  if ( connection_.has_destination() ) {
-    connection_.send_packet( socket );
+  if ( not connection_.has_destination() ) {
+    return false;
   }
+
+  connection_.make_packet( ciphertext );
+  return true;
 }
 
 void Client::summary( ostream& out ) const
@@ -184,6 +193,7 @@ void Client::summary( ostream& out ) const
   }
   internal_feed_.summary( out );
   quality_feed_.summary( out );
+  rate_controller_.summary( out );
   //  connection_.summary( out );
 }
 
@@ -277,6 +287,7 @@ void KnownClient::receive_packet( const Address& src, const Ciphertext& cipherte
   if ( next_session_.value().decrypt( ciphertext, { &id_, 1 }, throwaway_plaintext ) ) {
     /* new session established */
     current_session_.emplace( id_, ch1_num_, ch2_num_, move( next_session_.value() ) );
+    current_session_->set_fec( fec_ );
 
     next_keys_ = KeyPair {};
     next_session_.emplace( next_keys_.downlink, next_keys_.uplink );
@@ -287,6 +298,14 @@ void KnownClient::receive_packet( const Address& src, const Ciphertext& cipherte
   }
 }
 
+void KnownClient::set_fec( const bool enabled )
+{
+  fec_ = enabled;
+  if ( current_session_.has_value() ) {
+    current_session_->set_fec( enabled );
+  }
+}
+
 void Client::set_cursor_lag( const string_view feed,
                              const uint16_t target_samples,
                              const uint16_t min_samples,
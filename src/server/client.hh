@@ -9,6 +9,7 @@
 #include "control_messages.hh"
 #include "cursor.hh"
 #include "keys.hh"
+#include "rate_controller.hh"
 
 #include <rubberband/RubberBandStretcher.h>
 
@@ -64,6 +65,7 @@ class Client
   uint64_t client_mix_cursor() const;
 
   OpusEncoderProcess encoder_ { 96000, 48000 };
+  RateController rate_controller_ {};
 
   uint8_t ch1_num_, ch2_num_;
 
@@ -78,7 +80,8 @@ public:
                      AudioBoard& quality_board,
                      AudioBoard& quality_board2 );
   void mix_and_encode( const AudioBoard& board, const uint64_t cursor_sample );
-  void send_packet( UDPSocket& socket );
+  //! Build the next packet for this client; returns false if it has no destination yet
+  bool make_packet( Ciphertext& ciphertext );
 
   void summary( std::ostream& out ) const;
   void json_summary( Json::Value& root ) const;
@@ -89,6 +92,9 @@ public:
 
   const AudioNetworkConnection& connection() const { return connection_; }
 
+  //! Send XOR parity with the client's audio (see NetworkSender::set_fec)
+  void set_fec( const bool enabled ) { connection_.set_fec( enabled ); }
+
   void set_cursor_lag( const std::string_view feed,
                        const uint16_t target_samples,
                        const uint16_t min_samples,
@@ -114,6 +120,7 @@ class KnownClient
   } stats_ {};
 
   uint8_t ch1_num_, ch2_num_;
+  bool fec_ {};
 
 public:
   KnownClient( const uint8_t node_id, const uint8_t ch1_num, const uint8_t ch2_num, const LongLivedKey& key );
@@ -128,5 +135,8 @@ public:
 
   void clear_current_session() { current_session_.reset(); }
 
+  //! Send parity in this session and every later one
+  void set_fec( const bool enabled );
+
   void summary( std::ostream& out ) const;
 };
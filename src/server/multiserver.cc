@@ -8,7 +8,13 @@ using namespace std::chrono;
 
 uint64_t NetworkMultiServer::server_clock() const
 {
-  return ( Timer::timestamp_ns() - global_ns_timestamp_at_creation_ ) * 48 / 1000000;
+  return ( Timer::clock_ns() - global_ns_timestamp_at_creation_ ) * 48 / 1000000;
+}
+
+uint64_t NetworkMultiServer::timestamp_of_sample( const uint64_t sample ) const
+{
+  /* the first timestamp at which server_clock() >= sample */
+  return global_ns_timestamp_at_creation_ + ( sample * 1000000 + 47 ) / 48;
 }
 
 void NetworkMultiServer::receive_keyrequest( const Address& src, const Ciphertext& ciphertext )
@@ -22,12 +28,29 @@ void NetworkMultiServer::receive_keyrequest( const Address& src, const Ciphertex
   stats_.bad_packets++;
 }
 
+void NetworkMultiServer::receive_datagram( const Address& src, const Ciphertext& ciphertext )
+{
+  if ( ciphertext.length() > 24 ) {
+    const uint8_t node_id = ciphertext.as_string_view().back();
+    if ( node_id == uint8_t( KeyMessage::keyreq_id ) ) {
+      receive_keyrequest( src, ciphertext );
+    } else if ( node_id > 0 and node_id <= clients_.size() ) {
+      clients_.at( node_id - 1 ).receive_packet( src, ciphertext, server_clock() );
+    } else {
+      stats_.bad_packets++;
+    }
+  } else {
+    stats_.bad_packets++;
+  }
+}
+
 void NetworkMultiServer::add_key( const LongLivedKey& key )
 {
   const uint8_t next_id = clients_.size() + 1;
   const uint8_t ch1 = 2 * clients_.size();
   const uint8_t ch2 = ch1 + 1;
   clients_.emplace_back( next_id, ch1, ch2, key );
+  clients_.back().set_fec( fec_ );
   cerr << "Added key #" << int( next_id ) << " for: " << key.name() << " on channels " << int( ch1 ) << ":"
        << int( ch2 ) << "\n";
 
@@ -41,73 +64,120 @@ void NetworkMultiServer::add_key( const LongLivedKey& key )
   program_board_.set_channel_name( ch2, string( key.name() ) + "-CH2" );
 }
 
+void NetworkMultiServer::find_active_clients()
+{
+  active_clients_.clear();
+  for ( auto& client : clients_ ) {
+    if ( client ) {
+      active_clients_.push_back( &client.client() );
+    }
+  }
+}
+
 void NetworkMultiServer::initialize_clock()
 {
   next_cursor_sample_ = server_clock() + opus_frame::NUM_SAMPLES_MINLATENCY;
 }
 
-NetworkMultiServer::NetworkMultiServer( const uint8_t num_clients, EventLoop& loop )
+NetworkMultiServer::NetworkMultiServer( const uint8_t num_clients,
+                                        EventLoop& loop,
+                                        const size_t num_worker_threads,
+                                        const uint16_t port )
   : socket_()
-  , global_ns_timestamp_at_creation_( Timer::timestamp_ns() )
+  , global_ns_timestamp_at_creation_( Timer::clock_ns() )
   , next_cursor_sample_( server_clock() + opus_frame::NUM_SAMPLES_MINLATENCY )
   , num_clients_( num_clients )
   , internal_board_( "internal", 2 * num_clients )
   , preview_board_( "preview", 2 * num_clients )
   , program_board_( "program", 2 * num_clients )
+  , workers_( num_worker_threads )
 {
   socket_.set_blocking( false );
-  socket_.bind( { "0", 9101 } );
+  socket_.bind( { "0", port } );
 
   loop.add_rule( "network receive", socket_, Direction::In, [&] {
-    Address src { nullptr, 0 };
-    Ciphertext ciphertext;
-    ciphertext.resize( socket_.recv( src, ciphertext.mutable_buffer() ) );
-    if ( ciphertext.length() > 24 ) {
-      const uint8_t node_id = ciphertext.as_string_view().back();
-      if ( node_id == uint8_t( KeyMessage::keyreq_id ) ) {
-        receive_keyrequest( src, ciphertext );
-      } else if ( node_id > 0 and node_id <= clients_.size() ) {
-        clients_.at( node_id - 1 ).receive_packet( src, ciphertext, server_clock() );
-      } else {
-        stats_.bad_packets++;
-      }
-    } else {
-      stats_.bad_packets++;
+    inbound_payloads_.clear();
+    for ( auto& ciphertext : inbound_ciphertexts_ ) {
+      inbound_payloads_.push_back( ciphertext.mutable_buffer() );
+    }
+
+    const size_t num_received = socket_.recv_batch( { inbound_sources_.data(), inbound_sources_.size() },
+                                                    { inbound_payloads_.data(), inbound_payloads_.size() } );
+    for ( size_t i = 0; i < num_received; i++ ) {
+      inbound_ciphertexts_[i].resize( inbound_payloads_[i].size() );
+      receive_datagram( inbound_sources_[i], inbound_ciphertexts_[i] );
     }
   } );
 
-  loop.add_rule(
+  loop.add_timed_rule(
     "mix+encode+send",
     [&] {
+      const uint64_t now = Timer::clock_ns();
       const uint64_t ts_now = Timer::timestamp_ns();
 
-      /* decode all audio */
-      for ( auto& client : clients_ ) {
-        if ( client ) {
-          client.client().decode_audio( next_cursor_sample_, internal_board_, preview_board_, program_board_ );
-          if ( client.client().connection().sender_stats().last_good_ack_ts + CLIENT_TIMEOUT_NS < ts_now ) {
-            client.clear_current_session();
-          }
-        }
+      /* a tick that starts a whole tick late has eaten into the clients' jitter margin */
+      const uint64_t deadline = timestamp_of_sample( next_cursor_sample_ );
+      const uint64_t lateness = now > deadline ? now - deadline : 0;
+      tick_lateness_.log( lateness );
+      if ( lateness >= opus_frame::NUM_SAMPLES_MINLATENCY * 1'000'000 / 48 ) {
+        ticks_missed_++;
       }
 
-      /* mix all audio */
+      /* decode all audio (each client writes only its own channels on each board) */
+      find_active_clients();
+      workers_.run( active_clients_.size(), [&]( const size_t i ) {
+        active_clients_[i]->decode_audio( next_cursor_sample_, internal_board_, preview_board_, program_board_ );
+      } );
+
       for ( auto& client : clients_ ) {
-        if ( client ) {
-          client.client().mix_and_encode( internal_board_, next_cursor_sample_ );
+        if ( client
+             and client.client().connection().sender_stats().last_good_ack_ts + CLIENT_TIMEOUT_NS < now ) {
+          client.clear_current_session();
         }
       }
+      find_active_clients();
+
+      const uint64_t ts_decoded = Timer::timestamp_ns();
+      phase_times_.decode.log( ts_decoded - ts_now );
 
-      internal_audio_.mix_and_write( internal_board_, next_cursor_sample_ );
-      preview_audio_.mix_and_write( preview_board_, next_cursor_sample_ );
-      program_audio_.mix_and_write( program_board_, next_cursor_sample_ );
+      /* mix each board once; clients subtract their own channels from it */
+      internal_board_.mix_bus_until( next_cursor_sample_ );
+      preview_board_.mix_bus_until( next_cursor_sample_ );
+      program_board_.mix_bus_until( next_cursor_sample_ );
+
+      const uint64_t ts_mixed = Timer::timestamp_ns();
+      phase_times_.mix.log( ts_mixed - ts_decoded );
+
+      /* mix-minus and encode for each client, plus the three board outputs */
+      workers_.run( active_clients_.size() + 3, [&]( const size_t i ) {
+        if ( i < active_clients_.size() ) {
+          active_clients_[i]->mix_and_encode( internal_board_, next_cursor_sample_ );
+        } else if ( i == active_clients_.size() ) {
+          internal_audio_.mix_and_write( internal_board_, next_cursor_sample_ );
+        } else if ( i == active_clients_.size() + 1 ) {
+          preview_audio_.mix_and_write( preview_board_, next_cursor_sample_ );
+        } else {
+          program_audio_.mix_and_write( program_board_, next_cursor_sample_ );
+        }
+      } );
+
+      const uint64_t ts_encoded = Timer::timestamp_ns();
+      phase_times_.encode.log( ts_encoded - ts_mixed );
 
       /* send audio to clients */
-      for ( auto& client : clients_ ) {
-        if ( client ) {
-          client.client().send_packet( socket_ );
+      outbound_ciphertexts_.resize( max( outbound_ciphertexts_.size(), active_clients_.size() ) );
+      outbound_destinations_.clear();
+      outbound_payloads_.clear();
+      for ( size_t i = 0; i < active_clients_.size(); i++ ) {
+        if ( active_clients_[i]->make_packet( outbound_ciphertexts_[i] ) ) {
+          outbound_destinations_.push_back( active_clients_[i]->connection().destination() );
+          outbound_payloads_.push_back( outbound_ciphertexts_[i] );
         }
       }
+      socket_.sendto_batch( { outbound_destinations_.data(), outbound_destinations_.size() },
+                            { outbound_payloads_.data(), outbound_payloads_.size() } );
+
+      phase_times_.send.log( Timer::timestamp_ns() - ts_encoded );
 
       if ( next_cursor_sample_ > 240 ) {
         internal_board_.pop_samples_until( next_cursor_sample_ - 240 );
@@ -117,12 +187,37 @@ NetworkMultiServer::NetworkMultiServer( const uint8_t num_clients, EventLoop& lo
 
       next_cursor_sample_ += opus_frame::NUM_SAMPLES_MINLATENCY;
     },
-    [&] { return server_clock() >= next_cursor_sample_; } );
+    [&] { return timestamp_of_sample( next_cursor_sample_ ); } );
 }
 
 void NetworkMultiServer::summary( ostream& out ) const
 {
   out << "bad packets: " << stats_.bad_packets << "\n";
+
+  auto print_phase = [&]( const string_view name, const Timer::Record& timer ) {
+    if ( timer.count == 0 ) {
+      return;
+    }
+
+    out << "   " << name << ": " << string( 8 - name.size(), ' ' ) << "mean ";
+    Timer::pp_ns( out, timer.total_ns / timer.count );
+    out << "  ";
+    timer.print_percentiles( out );
+    out << "  max ";
+    Timer::pp_ns( out, timer.max_ns );
+    out << "\n";
+  };
+
+  print_phase( "late", tick_lateness_ );
+  if ( ticks_missed_ ) {
+    out << "   missed ticks: " << ticks_missed_ << "!\n";
+  }
+  print_phase( "decode", phase_times_.decode );
+  print_phase( "mix", phase_times_.mix );
+  print_phase( "encode", phase_times_.encode );
+  print_phase( "send", phase_times_.send );
+  workers_.summary( out );
+
   for ( const auto& client : clients_ ) {
     if ( client ) {
       out << "#" << int( client.client().peer_id() ) << ": ";
@@ -131,12 +226,40 @@ void NetworkMultiServer::summary( ostream& out ) const
   }
 }
 
+void NetworkMultiServer::reset_summary()
+{
+  phase_times_.decode.reset();
+  phase_times_.mix.reset();
+  phase_times_.encode.reset();
+  phase_times_.send.reset();
+  tick_lateness_.reset();
+  ticks_missed_ = 0;
+  workers_.reset_summary();
+}
+
+static void json_latency( Json::Value& root, const Timer::Record& timer )
+{
+  root["count"] = Json::UInt64( timer.count );
+  root["p50_us"] = timer.percentile_ns( 0.5 ) / THOUSAND;
+  root["p99_us"] = timer.percentile_ns( 0.99 ) / THOUSAND;
+  root["p999_us"] = timer.percentile_ns( 0.999 ) / THOUSAND;
+  root["max_us"] = timer.max_ns / THOUSAND;
+}
+
 void NetworkMultiServer::json_summary( Json::Value& root, const bool include_second_channels ) const
 {
   internal_board_.json_summary( root["board"][internal_board_.name()], include_second_channels );
   preview_board_.json_summary( root["board"][preview_board_.name()], include_second_channels );
   program_board_.json_summary( root["board"][program_board_.name()], include_second_channels );
 
+  Json::Value& tick = root["server"]["tick"];
+  json_latency( tick["lateness"], tick_lateness_ );
+  tick["missed"] = ticks_missed_;
+  json_latency( tick["decode"], phase_times_.decode );
+  json_latency( tick["mix"], phase_times_.mix );
+  json_latency( tick["encode"], phase_times_.encode );
+  json_latency( tick["send"], phase_times_.send );
+
   for ( const auto& client : clients_ ) {
     if ( client ) {
       client.client().json_summary( root["client"][client.name()] );
@@ -146,6 +269,14 @@ void NetworkMultiServer::json_summary( Json::Value& root, const bool include_sec
   }
 }
 
+void NetworkMultiServer::set_fec( const bool enabled )
+{
+  fec_ = enabled;
+  for ( auto& client : clients_ ) {
+    client.set_fec( enabled );
+  }
+}
+
 void NetworkMultiServer::set_cursor_lag( const string_view name,
                                          const string_view feed,
                                          const uint16_t target_samples,
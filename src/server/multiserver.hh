@@ -6,6 +6,7 @@
 
 #include "client.hh"
 #include "summarize.hh"
+#include "worker_pool.hh"
 
 class NetworkMultiServer : public Summarizable
 {
@@ -15,27 +16,64 @@ class NetworkMultiServer : public Summarizable
   uint64_t global_ns_timestamp_at_creation_;
   uint64_t next_cursor_sample_;
   uint64_t server_clock() const;
+  uint64_t timestamp_of_sample( const uint64_t sample ) const;
 
   void receive_keyrequest( const Address& src, const Ciphertext& ciphertext );
+  void receive_datagram( const Address& src, const Ciphertext& ciphertext );
 
   uint8_t num_clients_;
 
   AudioBoard internal_board_, preview_board_, program_board_;
   std::vector<KnownClient> clients_ {};
+  bool fec_ {};
 
   struct Stats
   {
     unsigned int bad_packets;
   } stats_ {};
 
+  /* per-client decode and encode run in parallel; everything else stays on the event-loop thread */
+  WorkerPool workers_;
+  std::vector<Client*> active_clients_ {};
+  void find_active_clients();
+
+  /* datagrams are received and sent in batches, one system call per batch */
+  static constexpr size_t RECEIVE_BATCH = UDPSocket::max_batch;
+  std::vector<Ciphertext> inbound_ciphertexts_ = std::vector<Ciphertext>( RECEIVE_BATCH );
+  std::vector<Address> inbound_sources_ = std::vector<Address>( RECEIVE_BATCH );
+  std::vector<string_span> inbound_payloads_ {};
+
+  std::vector<Ciphertext> outbound_ciphertexts_ {};
+  std::vector<Address> outbound_destinations_ {};
+  std::vector<std::string_view> outbound_payloads_ {};
+
+public:
+  struct PhaseTimes
+  {
+    Timer::Record decode, mix, encode, send;
+  };
+
+private:
+  PhaseTimes phase_times_ {};
+
+  /* how long after its deadline each tick actually started */
+  Timer::Record tick_lateness_ {};
+  unsigned int ticks_missed_ {};
+
   AudioWriter internal_audio_ { "stagecast-internal-audio" };
   AudioWriter preview_audio_ { "stagecast-preview-audio" };
   AudioWriter program_audio_ { "stagecast-program-audio" };
 
 public:
-  NetworkMultiServer( const uint8_t num_clients, EventLoop& loop );
+  NetworkMultiServer( const uint8_t num_clients,
+                      EventLoop& loop,
+                      const size_t num_worker_threads = 0,
+                      const uint16_t port = 9101 );
   void add_key( const LongLivedKey& key );
 
+  //! Send XOR parity with the audio to every client (see NetworkSender::set_fec)
+  void set_fec( const bool enabled );
+
   void set_cursor_lag( const std::string_view name,
                        const std::string_view feed,
                        const uint16_t target_samples,
@@ -48,6 +86,13 @@ public:
 
   void initialize_clock();
 
+  Address local_address() const { return socket_.local_address(); }
+
+  const PhaseTimes& phase_times() const { return phase_times_; }
+  const Timer::Record& tick_lateness() const { return tick_lateness_; }
+  unsigned int ticks_missed() const { return ticks_missed_; }
+
   void summary( std::ostream& out ) const override;
+  void reset_summary() override;
   void json_summary( Json::Value& root, const bool include_second_channels ) const;
 };
@@ -0,0 +1,105 @@
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "conversion_kernel.hh"
+#include "timer.hh"
+
+using namespace std;
+
+static constexpr unsigned int ITERATIONS = 200000;
+
+/* interleaved S24-in-S32 frames, as the device delivers them */
+vector<int32_t> make_frames( const size_t num_frames )
+{
+  default_random_engine gen { 1 };
+  uniform_int_distribution<int32_t> sample { -( 1 << 23 ), ( 1 << 23 ) - 1 };
+
+  vector<int32_t> frames( 2 * num_frames );
+  for ( auto& x : frames ) {
+    x = sample( gen ) * 256;
+  }
+  return frames;
+}
+
+struct Result
+{
+  uint64_t ns_per_block;
+  vector<float> ch1, ch2;
+  vector<int32_t> output;
+  BlockLevels levels;
+};
+
+/* one device wakeup: capture a block, then loop it back with playback mixed in */
+Result time_one_configuration( const ConversionKernel& kernel, const size_t num_frames )
+{
+  const vector<int32_t> input = make_frames( num_frames );
+  const vector<float> playback1( num_frames, 0.25 ), playback2( num_frames, -0.25 );
+  const LoopbackGains gains { { 2.0, 2.0 }, { 2.0, 2.0 } };
+
+  Result ret { 0, vector<float>( num_frames ), vector<float>( num_frames ), vector<int32_t>( 2 * num_frames ), {} };
+
+  const uint64_t start = Timer::timestamp_ns();
+
+  for ( unsigned int iter = 0; iter < ITERATIONS; iter++ ) {
+    if ( not kernel.capture( input.data(), ret.ch1.data(), ret.ch2.data(), num_frames, ret.levels ) ) {
+      throw runtime_error( "invalid sample" );
+    }
+    kernel.playback( ret.ch1.data(),
+                     ret.ch2.data(),
+                     playback1.data(),
+                     playback2.data(),
+                     gains,
+                     ret.output.data(),
+                     num_frames );
+  }
+
+  ret.ns_per_block = ( Timer::timestamp_ns() - start ) / ITERATIONS;
+  return ret;
+}
+
+void program_body()
+{
+  const ConversionKernel& portable = ConversionKernel::portable();
+  const ConversionKernel& best = ConversionKernel::best();
+
+  cout << "capture + loopback cost per device wakeup (" << best.name() << " vs. " << portable.name() << ")\n";
+
+  for ( const size_t num_frames : { 6, 12, 24, 48, 96, 192 } ) {
+    const Result p = time_one_configuration( portable, num_frames );
+    const Result b = time_one_configuration( best, num_frames );
+
+    /* capture is exact; loopback may differ in the last bit of a 24-bit sample from fused multiply-add */
+    if ( p.ch1 != b.ch1 or p.ch2 != b.ch2 or p.levels.max_ch1_amplitude != b.levels.max_ch1_amplitude
+         or p.levels.max_ch2_amplitude != b.levels.max_ch2_amplitude
+         or abs( p.levels.ssa_ch1 - b.levels.ssa_ch1 ) > 1e-4 * p.levels.ssa_ch1 ) {
+      throw runtime_error( "capture mismatch with " + to_string( num_frames ) + " frames" );
+    }
+    for ( size_t i = 0; i < p.output.size(); i++ ) {
+      if ( abs( int64_t( p.output[i] ) - int64_t( b.output[i] ) ) > 256 ) {
+        throw runtime_error( "loopback mismatch at sample " + to_string( i ) + " with " + to_string( num_frames )
+                             + " frames" );
+      }
+    }
+
+    cout << "   " << setw( 3 ) << num_frames << " frames: " << best.name() << " ";
+    Timer::pp_ns( cout, b.ns_per_block );
+    cout << "   " << portable.name() << " ";
+    Timer::pp_ns( cout, p.ns_per_block );
+    cout << "   speedup " << setprecision( 2 ) << double( p.ns_per_block ) / double( b.ns_per_block ) << "x\n";
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
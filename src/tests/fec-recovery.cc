@@ -0,0 +1,115 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "frame_source.hh"
+#include "receiver.hh"
+#include "sender.hh"
+
+using namespace std;
+
+bool same_frame( const AudioFrame& a, const AudioFrame& b )
+{
+  return a.frame_index == b.frame_index and a.separate_channels == b.separate_channels
+         and a.frame1.as_string_view() == b.frame1.as_string_view()
+         and ( not a.separate_channels or a.frame2.as_string_view() == b.frame2.as_string_view() );
+}
+
+/* the receiver only starts to accumulate parity once it has seen some, which is with the first frame of the
+   second group, so losses start with the third group */
+static constexpr unsigned int FIRST_LOSSY_GROUP = 2;
+
+/* Each packet carries the newest frame (nothing is acknowledged, and the run is too short for any packet to
+   be given up on, so nothing is retransmitted), and the packet carrying one frame of each group is lost. That
+   is never the group's first frame, whose packet also carries the previous group's parity. Returns the number
+   of frames the receiver ended up with. */
+unsigned int run( const bool fec, const unsigned int num_groups, unsigned int& recovered )
+{
+  constexpr uint8_t group_size = AudioFrame::fec_group_size;
+
+  NetworkSender<AudioFrame> sender;
+  NetworkReceiver<AudioFrame> receiver;
+  FrameSource source { FrameSource::Contents::Varied };
+  sender.set_fec( fec );
+
+  string datagram( Plaintext::capacity(), 0 );
+  const unsigned int num_frames = num_groups * group_size + 1; /* the extra frame carries the last parity */
+
+  for ( unsigned int i = 0; i < num_frames; i++ ) {
+    sender.push_frame( source );
+    OutboundPacket<AudioFrame> packet;
+    sender.set_sender_section( packet );
+
+    const uint32_t group = i / group_size;
+    if ( group >= FIRST_LOSSY_GROUP and i % group_size == 1 + group % ( group_size - 1 ) ) {
+      continue;
+    }
+
+    Serializer s { { datagram.data(), datagram.size() } };
+    s.object( packet );
+
+    Packet<AudioFrame>::ReceiverSection unused_acks;
+    NetString unused_data;
+    Parser p { { datagram.data(), s.bytes_written() } };
+    receiver.receive_packet( p, unused_acks, unused_data );
+    if ( p.error() ) {
+      throw runtime_error( "parse error" );
+    }
+  }
+
+  unsigned int present = 0;
+  AudioFrame expected;
+  for ( uint32_t i = 0; i < num_frames; i++ ) {
+    if ( receiver.frames().has_value( i ) ) {
+      source.front( i, expected );
+      if ( not same_frame( receiver.frames().at( i ), expected ) ) {
+        throw runtime_error( "frame " + to_string( i ) + " was rebuilt wrong" );
+      }
+      present++;
+    }
+  }
+
+  recovered = receiver.stats().fec_recovered;
+  return present;
+}
+
+void program_body()
+{
+  const unsigned int num_groups = 120; /* 481 packets, within the sender's record of 512 packets in flight */
+  const unsigned int num_frames = num_groups * AudioFrame::fec_group_size + 1;
+  const unsigned int num_lost = num_groups - FIRST_LOSSY_GROUP;
+
+  unsigned int recovered = 0;
+  const unsigned int with_fec = run( true, num_groups, recovered );
+  cout << "with parity: " << with_fec << "/" << num_frames << " frames, " << recovered << " rebuilt\n";
+  if ( with_fec != num_frames or recovered != num_lost ) {
+    throw runtime_error( "parity did not rebuild every lost frame" );
+  }
+
+  const unsigned int without_fec = run( false, num_groups, recovered );
+  cout << "without parity: " << without_fec << "/" << num_frames << " frames, " << recovered << " rebuilt\n";
+  if ( without_fec != num_frames - num_lost or recovered != 0 ) {
+    throw runtime_error( "frames appeared without parity" );
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 1 ) {
+      cerr << "Usage: " << argv[0] << "\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
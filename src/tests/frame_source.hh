@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+#include "formats.hh"
+
+//! Stands in for an OpusEncoderProcess as the source of NetworkSender<AudioFrame>::push_frame()
+//! \details A frame is ready every time the sender asks, and front() is a pure function of the index, so a
+//! test can also use it to work out what the receiver should have ended up with.
+class FrameSource
+{
+public:
+  enum class Contents
+  {
+    Fixed, //!< a 40-byte mono frame every time, like a steady Opus stream
+    Varied //!< lengths, channel layout and bytes that all follow from the index, so corruption shows
+  };
+
+  explicit FrameSource( const Contents contents = Contents::Fixed )
+    : contents_( contents )
+  {}
+
+  void front( const uint32_t frame_index, AudioFrame& frame ) const
+  {
+    frame.frame_index = frame_index;
+
+    if ( contents_ == Contents::Fixed ) {
+      frame.separate_channels = false;
+      frame.frame1.resize( 40 );
+      return;
+    }
+
+    frame.separate_channels = frame_index % 3 == 0;
+    fill( frame.frame1, frame_index, 20 + frame_index % 41 );
+    if ( frame.separate_channels ) {
+      fill( frame.frame2, frame_index * 7, 10 + frame_index % 23 );
+    }
+  }
+
+  void pop_frame() {}
+
+private:
+  Contents contents_;
+
+  static void fill( opus_frame& frame, const uint32_t seed, const uint8_t length )
+  {
+    frame.resize( length );
+    for ( uint8_t i = 0; i < length; i++ ) {
+      frame.mutable_data_ptr()[i] = char( seed * 31 + i * 17 );
+    }
+  }
+};
@@ -0,0 +1,235 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "connection.hh"
+#include "encoder_task.hh"
+#include "keys.hh"
+#include "lossy_link.hh"
+#include "rate_controller.hh"
+#include "timer.hh"
+
+using namespace std;
+
+static constexpr uint64_t TICK_NS = opus_frame::NUM_SAMPLES_MINLATENCY * 1'000'000 / 48; /* 2.5 ms */
+
+/* frames pushed in the last second are not counted; they may still be in flight when the run ends */
+static constexpr unsigned int TAIL_TICKS = 400;
+
+/* one side of a session: a frame of audio (a tone) and a packet every tick, like a client or the server */
+struct Endpoint
+{
+  AudioNetworkConnection connection;
+  OpusEncoderProcess encoder { 96000, 600, 48000 };
+  ChannelPair audio { 8192 };
+  size_t samples_generated {};
+  optional<RateController> rate_control {};
+
+  Endpoint( const char node_id, const char peer_id, CryptoSession&& crypto )
+    : connection( node_id, peer_id, move( crypto ), Address { "127.0.0.1", 9 } )
+  {}
+
+  void transmit( LossyLink& link, const uint64_t now )
+  {
+    span<float> ch1 = audio.ch1().region( samples_generated, opus_frame::NUM_SAMPLES_MINLATENCY );
+    for ( size_t i = 0; i < ch1.size(); i++ ) {
+      ch1[i] = 0.2 * sin( 2 * M_PI * 440 * ( samples_generated + i ) / 48000.0 );
+    }
+    samples_generated += opus_frame::NUM_SAMPLES_MINLATENCY;
+
+    encoder.encode_one_frame( audio.ch1(), audio.ch2() );
+    audio.pop_before( encoder.min_encode_cursor() );
+
+    connection.push_frame( encoder );
+
+    Ciphertext ciphertext;
+    connection.make_packet( ciphertext );
+    link.send( ciphertext, now );
+
+    if ( rate_control.has_value() and rate_control->update( connection.sender_stats(), now ) ) {
+      rate_control->apply( encoder );
+    }
+  }
+
+  void receive( const string& datagram )
+  {
+    Ciphertext ciphertext;
+    ciphertext.resize( datagram.size() );
+    memcpy( ciphertext.mutable_data_ptr(), datagram.data(), datagram.size() );
+    connection.receive_packet_in_place( ciphertext );
+  }
+};
+
+struct Scenario
+{
+  string name;
+  LossyLink::Config link;
+};
+
+void run_scenario( const Scenario& scenario, const unsigned int num_ticks, const bool fec, const bool adaptive )
+{
+  const uint64_t start = Timer::timestamp_ns();
+  Timer::set_virtual_clock( start );
+
+  const KeyPair keys;
+  Endpoint client { 1, 0, CryptoSession( keys.uplink, keys.downlink ) };
+  Endpoint server { 0, 1, CryptoSession( keys.downlink, keys.uplink ) };
+  LossyLink uplink { scenario.link, 1 }, downlink { scenario.link, 2 };
+
+  client.connection.set_fec( fec );
+  server.connection.set_fec( fec );
+  if ( adaptive ) {
+    client.rate_control.emplace();
+  }
+
+  /* when each of the client's frames first reached the server */
+  vector<bool> delivered( num_ticks + TAIL_TICKS );
+  Timer::Record latency {};
+  uint64_t frames_delivered = 0;
+
+  auto record_deliveries = [&]( const uint64_t now ) {
+    const auto& frames = server.connection.frames();
+    const uint32_t end
+      = min( server.connection.unreceived_beyond_this_frame_index(), uint32_t( delivered.size() ) );
+    for ( uint32_t i = frames.range_begin(); i < end; i++ ) {
+      if ( frames.has_value( i ) and not delivered[i] ) {
+        delivered[i] = true;
+        frames_delivered++;
+        if ( i < num_ticks ) {
+          latency.log( now - ( start + i * TICK_NS ) );
+        }
+      }
+    }
+    server.connection.pop_frames( server.connection.next_frame_needed() - frames.range_begin() );
+  };
+
+  string datagram;
+  for ( unsigned int tick = 0; tick < num_ticks + TAIL_TICKS; tick++ ) {
+    const uint64_t now = start + tick * TICK_NS;
+
+    /* deliver everything that arrives before this tick, in order of arrival */
+    while ( min( uplink.next_arrival(), downlink.next_arrival() ) <= now ) {
+      if ( uplink.next_arrival() <= downlink.next_arrival() ) {
+        const uint64_t arrival = uplink.next_arrival();
+        Timer::set_virtual_clock( arrival );
+        uplink.receive( arrival, datagram );
+        server.receive( datagram );
+        record_deliveries( arrival );
+      } else {
+        const uint64_t arrival = downlink.next_arrival();
+        Timer::set_virtual_clock( arrival );
+        downlink.receive( arrival, datagram );
+        client.receive( datagram );
+      }
+    }
+
+    Timer::set_virtual_clock( now );
+    client.transmit( uplink, now );
+    server.transmit( downlink, now );
+  }
+
+  Timer::clear_virtual_clock();
+
+  unsigned int undelivered = 0;
+  for ( unsigned int i = 0; i < num_ticks; i++ ) {
+    undelivered += not delivered[i];
+  }
+
+  const auto& sender = client.connection.sender_stats();
+  const auto& receiver = server.connection.receiver_stats();
+  const unsigned int redundant_arrivals = receiver.already_acked + receiver.redundant;
+  const auto& link = uplink.stats();
+
+  cout << scenario.name << ( fec ? " [FEC]" : "" ) << ( adaptive ? " [adaptive bit rate]" : "" ) << "\n";
+  cout << "   link: " << link.datagrams_sent << " datagrams, " << link.random_losses << " lost, "
+       << link.queue_drops << " queue drops, " << link.reordered << " reordered, " << link.duplicates
+       << " duplicated\n";
+  cout << "   frame latency: ";
+  latency.print_percentiles( cout );
+  cout << " max=";
+  Timer::pp_ns( cout, latency.max_ns );
+  cout << "   undelivered " << undelivered << "/" << num_ticks << "\n";
+  cout << "   retransmitted frames " << sender.frame_retransmissions << ", redundant arrivals "
+       << redundant_arrivals << " (" << setprecision( 1 )
+       << ( sender.frame_retransmissions ? 100.0 * redundant_arrivals / sender.frame_retransmissions : 0.0 )
+       << "%)";
+  cout << "   wire bytes/frame " << setprecision( 0 )
+       << double( link.bytes_sent ) / max( uint64_t( 1 ), frames_delivered ) << "\n";
+  cout << "   holes filled by FEC " << receiver.fec_recovered << ", by a late copy " << receiver.late_fills << "\n";
+  if ( client.rate_control.has_value() ) {
+    cout << "   ";
+    client.rate_control->summary( cout );
+  }
+}
+
+void program_body( const double seconds )
+{
+  const unsigned int num_ticks = lrint( seconds * BILLION / TICK_NS );
+
+  vector<Scenario> scenarios;
+
+  scenarios.push_back( { "clean, 20 ms", {} } );
+  scenarios.back().link.delay_ns = 20'000'000;
+
+  scenarios.push_back( { "2% independent loss, 20 ms", scenarios.front().link } );
+  scenarios.back().link.loss_in_good = scenarios.back().link.loss_in_bad = 0.02;
+
+  /* in the bad state about 4% of the time, for 4 datagrams on average, losing half of them there */
+  scenarios.push_back( { "bursty loss (Gilbert-Elliott), 20 ms", scenarios.front().link } );
+  scenarios.back().link.good_to_bad = 0.01;
+  scenarios.back().link.bad_to_good = 0.25;
+  scenarios.back().link.loss_in_bad = 0.5;
+
+  scenarios.push_back( { "20 ms + exponential jitter (mean 5 ms), 5% held back 10 ms", scenarios.front().link } );
+  scenarios.back().link.jitter = LossyLink::Jitter::Exponential;
+  scenarios.back().link.jitter_ns = 5'000'000;
+  scenarios.back().link.reorder = 0.05;
+  scenarios.back().link.reorder_delay_ns = 10'000'000;
+
+  scenarios.push_back( { "20 ms, 2% duplicated", scenarios.front().link } );
+  scenarios.back().link.duplicate = 0.02;
+
+  scenarios.push_back( { "20 ms, 200 kbit/s cap with 30 ms queue", scenarios.front().link } );
+  scenarios.back().link.bits_per_second = 200'000;
+  scenarios.back().link.max_queue_ns = 30'000'000;
+
+  cout << "NetworkConnection over a simulated link: " << num_ticks << " frames each way, virtual clock\n\n";
+
+  for ( const auto& scenario : scenarios ) {
+    run_scenario( scenario, num_ticks, false, false );
+    run_scenario( scenario, num_ticks, true, false );
+  }
+
+  /* the capped link again, with the uplink's bit rate following what the sender sees */
+  run_scenario( scenarios.back(), num_ticks, false, true );
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc > 2 ) {
+      cerr << "Usage: " << argv[0] << " [seconds=10]\n";
+      return EXIT_FAILURE;
+    }
+
+    const double seconds = argc > 1 ? stod( argv[1] ) : 10;
+    if ( seconds <= 0 ) {
+      cerr << "seconds must be positive\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body( seconds );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
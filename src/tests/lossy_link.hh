@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! One direction of a simulated network path, for driving two NetworkConnections without sockets
+//! \details Times are in ns on whatever clock the caller uses (normally the virtual Timer::clock_ns()), and
+//! the same seed always produces the same losses, delays and reorderings.
+class LossyLink
+{
+public:
+  enum class Jitter
+  {
+    None,
+    Uniform,    //!< uniform on [0, 2 * jitter_ns)
+    Exponential //!< exponential with mean jitter_ns (a long tail, like a busy Wi-Fi hop)
+  };
+
+  struct Config
+  {
+    /* Gilbert-Elliott loss: a two-state Markov chain, moving between states once per datagram.
+       Equal loss rates in both states (the default) give independent Bernoulli loss. */
+    double good_to_bad {}, bad_to_good { 1 };
+    double loss_in_good {}, loss_in_bad {};
+
+    uint64_t delay_ns {};
+    Jitter jitter { Jitter::None };
+    uint64_t jitter_ns {};
+
+    /* a reordered datagram is held back by an extra reorder_delay_ns */
+    double reorder {};
+    uint64_t reorder_delay_ns {};
+
+    double duplicate {};
+
+    /* zero for an unlimited rate; otherwise datagrams queue behind each other, and tail-drop once the
+       queue would take longer than max_queue_ns to drain */
+    uint64_t bits_per_second {};
+    uint64_t max_queue_ns { 50'000'000 };
+  };
+
+  struct Statistics
+  {
+    uint64_t datagrams_sent, bytes_sent, random_losses, queue_drops, duplicates, reordered, delivered;
+  };
+
+  //! IPv4 + UDP headers, counted toward the bit rate and bytes on the wire
+  static constexpr size_t HEADER_BYTES = 28;
+
+private:
+  struct InFlight
+  {
+    uint64_t delivery_time;
+    uint64_t sequence; /* keeps datagrams due at the same time in FIFO order */
+    std::string payload;
+
+    bool operator>( const InFlight& other ) const
+    {
+      return delivery_time != other.delivery_time ? delivery_time > other.delivery_time
+                                                  : sequence > other.sequence;
+    }
+  };
+
+  Config config_;
+  std::mt19937_64 rng_;
+  std::uniform_real_distribution<double> uniform_ { 0.0, 1.0 };
+
+  bool bad_state_ {};
+  uint64_t link_free_at_ {};
+  uint64_t next_sequence_ {};
+  std::priority_queue<InFlight, std::vector<InFlight>, std::greater<InFlight>> in_flight_ {};
+
+  Statistics stats_ {};
+
+  bool chance( const double probability ) { return probability > 0 and uniform_( rng_ ) < probability; }
+
+  uint64_t jitter()
+  {
+    if ( config_.jitter_ns == 0 ) {
+      return 0;
+    }
+
+    switch ( config_.jitter ) {
+      case Jitter::Uniform:
+        return 2 * config_.jitter_ns * uniform_( rng_ );
+      case Jitter::Exponential:
+        return std::exponential_distribution<double> { 1.0 / config_.jitter_ns }( rng_ );
+      case Jitter::None:
+        break;
+    }
+    return 0;
+  }
+
+public:
+  LossyLink( const Config& config, const uint64_t seed )
+    : config_( config )
+    , rng_( seed )
+  {}
+
+  //! Offer a datagram to the link at time `now`
+  void send( const std::string_view datagram, const uint64_t now )
+  {
+    stats_.datagrams_sent++;
+    stats_.bytes_sent += datagram.size() + HEADER_BYTES;
+
+    /* the loss state moves once per datagram */
+    bad_state_ = bad_state_ ? not chance( config_.bad_to_good ) : chance( config_.good_to_bad );
+    if ( chance( bad_state_ ? config_.loss_in_bad : config_.loss_in_good ) ) {
+      stats_.random_losses++;
+      return;
+    }
+
+    /* serialization behind earlier datagrams */
+    uint64_t departure = now;
+    if ( config_.bits_per_second ) {
+      const uint64_t start = std::max( now, link_free_at_ );
+      if ( start - now > config_.max_queue_ns ) {
+        stats_.queue_drops++;
+        return;
+      }
+      link_free_at_ = start + ( datagram.size() + HEADER_BYTES ) * 8 * 1'000'000'000 / config_.bits_per_second;
+      departure = link_free_at_;
+    }
+
+    uint64_t arrival = departure + config_.delay_ns + jitter();
+    if ( chance( config_.reorder ) ) {
+      arrival += config_.reorder_delay_ns;
+      stats_.reordered++;
+    }
+    in_flight_.push( { arrival, next_sequence_++, std::string( datagram ) } );
+
+    if ( chance( config_.duplicate ) ) {
+      in_flight_.push( { arrival + jitter(), next_sequence_++, std::string( datagram ) } );
+      stats_.duplicates++;
+    }
+  }
+
+  //! Time at which the next datagram arrives (or UINT64_MAX if none is in flight)
+  uint64_t next_arrival() const
+  {
+    return in_flight_.empty() ? std::numeric_limits<uint64_t>::max() : in_flight_.top().delivery_time;
+  }
+
+  //! Take the next datagram due by `now`
+  //! \returns false if none is due
+  bool receive( const uint64_t now, std::string& datagram )
+  {
+    if ( next_arrival() > now ) {
+      return false;
+    }
+
+    datagram = in_flight_.top().payload;
+    in_flight_.pop();
+    stats_.delivered++;
+    return true;
+  }
+
+  const Statistics& stats() const { return stats_; }
+};
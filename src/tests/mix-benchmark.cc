@@ -0,0 +1,155 @@
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "audio_buffer.hh"
+#include "mix_kernel.hh"
+#include "timer.hh"
+
+using namespace std;
+
+static constexpr size_t SAMPLES_PER_TICK = 120; /* 2.5 ms at 48 kHz */
+static constexpr unsigned int TICKS = 2000;
+
+/* a board with two channels per client, like NetworkMultiServer's */
+vector<AudioChannel> make_board( const unsigned int num_clients )
+{
+  default_random_engine gen { 1 };
+  uniform_real_distribution<float> sample { -0.5, 0.5 };
+
+  const unsigned int num_channels = 2 * num_clients;
+  vector<AudioChannel> board;
+  board.reserve( num_channels );
+  for ( unsigned int i = 0; i < num_channels; i++ ) {
+    board.emplace_back( 8192 );
+    for ( size_t s = 0; s < SAMPLES_PER_TICK; s++ ) {
+      board.back().at( s ) = sample( gen );
+    }
+  }
+
+  return board;
+}
+
+/* mix-minus for every client by re-summing everyone else's channels */
+uint64_t time_one_configuration( const MixKernel& kernel, const unsigned int num_clients, ChannelPair& output )
+{
+  const unsigned int num_channels = 2 * num_clients;
+  const vector<AudioChannel> board = make_board( num_clients );
+
+  vector<MixInput> inputs;
+  inputs.reserve( num_channels );
+
+  const uint64_t start = Timer::timestamp_ns();
+
+  for ( unsigned int tick = 0; tick < TICKS; tick++ ) {
+    for ( unsigned int client = 0; client < num_clients; client++ ) {
+      span<float> ch1 = output.ch1().region( 0, SAMPLES_PER_TICK );
+      span<float> ch2 = output.ch2().region( 0, SAMPLES_PER_TICK );
+      fill( ch1.begin(), ch1.end(), 0 );
+      fill( ch2.begin(), ch2.end(), 0 );
+
+      inputs.clear();
+      for ( unsigned int channel_i = 0; channel_i < num_channels; channel_i++ ) {
+        if ( channel_i / 2 == client ) {
+          continue;
+        }
+        inputs.push_back( { board.at( channel_i ).region( 0, SAMPLES_PER_TICK ).data(), 0.7, 1.3 } );
+      }
+
+      kernel.mix( { inputs.data(), inputs.size() }, ch1, ch2 );
+    }
+  }
+
+  return ( Timer::timestamp_ns() - start ) / TICKS;
+}
+
+/* mix-minus for every client by summing the board once and subtracting each client's own channels */
+uint64_t time_shared_bus( const MixKernel& kernel, const unsigned int num_clients, ChannelPair& output )
+{
+  const unsigned int num_channels = 2 * num_clients;
+  const vector<AudioChannel> board = make_board( num_clients );
+  ChannelPair bus { 8192 };
+
+  vector<MixInput> inputs;
+  inputs.reserve( num_channels );
+
+  const uint64_t start = Timer::timestamp_ns();
+
+  for ( unsigned int tick = 0; tick < TICKS; tick++ ) {
+    span<float> bus1 = bus.ch1().region( 0, SAMPLES_PER_TICK );
+    span<float> bus2 = bus.ch2().region( 0, SAMPLES_PER_TICK );
+    fill( bus1.begin(), bus1.end(), 0 );
+    fill( bus2.begin(), bus2.end(), 0 );
+
+    inputs.clear();
+    for ( unsigned int channel_i = 0; channel_i < num_channels; channel_i++ ) {
+      inputs.push_back( { board.at( channel_i ).region( 0, SAMPLES_PER_TICK ).data(), 0.7, 1.3 } );
+    }
+    kernel.mix( { inputs.data(), inputs.size() }, bus1, bus2 );
+
+    for ( unsigned int client = 0; client < num_clients; client++ ) {
+      span<float> ch1 = output.ch1().region( 0, SAMPLES_PER_TICK );
+      span<float> ch2 = output.ch2().region( 0, SAMPLES_PER_TICK );
+      ch1.copy( bus1 );
+      ch2.copy( bus2 );
+
+      const array<MixInput, 2> own_channels {
+        { { board.at( 2 * client ).region( 0, SAMPLES_PER_TICK ).data(), -0.7, -1.3 },
+          { board.at( 2 * client + 1 ).region( 0, SAMPLES_PER_TICK ).data(), -0.7, -1.3 } }
+      };
+      kernel.mix( { own_channels.data(), own_channels.size() }, ch1, ch2 );
+    }
+  }
+
+  return ( Timer::timestamp_ns() - start ) / TICKS;
+}
+
+void program_body()
+{
+  const MixKernel& portable = MixKernel::portable();
+  const MixKernel& best = MixKernel::best();
+
+  ChannelPair portable_output { 8192 }, best_output { 8192 }, bus_output { 8192 };
+
+  cout << "mix-minus cost per 2.5 ms tick (" << best.name() << " vs. " << portable.name() << ")\n";
+
+  for ( const unsigned int num_clients : { 8, 16, 24, 32, 48, 64 } ) {
+    const uint64_t portable_ns = time_one_configuration( portable, num_clients, portable_output );
+    const uint64_t best_ns = time_one_configuration( best, num_clients, best_output );
+    const uint64_t bus_ns = time_shared_bus( best, num_clients, bus_output );
+
+    /* the last client's mix should agree up to rounding */
+    for ( size_t s = 0; s < SAMPLES_PER_TICK; s++ ) {
+      const auto [p1, p2] = portable_output.safe_get( s );
+      const auto [b1, b2] = best_output.safe_get( s );
+      const auto [s1, s2] = bus_output.safe_get( s );
+      if ( abs( p1 - b1 ) > 1e-4 or abs( p2 - b2 ) > 1e-4 or abs( p1 - s1 ) > 1e-4 or abs( p2 - s2 ) > 1e-4 ) {
+        throw runtime_error( "mix mismatch at sample " + to_string( s ) + " with " + to_string( num_clients )
+                             + " clients" );
+      }
+    }
+
+    cout << "   " << setw( 2 ) << num_clients << " clients: " << best.name() << " ";
+    Timer::pp_ns( cout, best_ns );
+    cout << "   " << portable.name() << " ";
+    Timer::pp_ns( cout, portable_ns );
+    cout << "   speedup " << setprecision( 2 ) << double( portable_ns ) / double( best_ns ) << "x";
+    cout << "   shared bus ";
+    Timer::pp_ns( cout, bus_ns );
+    cout << "\n";
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
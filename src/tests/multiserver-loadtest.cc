@@ -0,0 +1,335 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "connection.hh"
+#include "encoder_task.hh"
+#include "eventloop.hh"
+#include "keys.hh"
+#include "multiserver.hh"
+#include "timer.hh"
+
+using namespace std;
+using namespace std::chrono;
+
+static constexpr uint64_t TICK_NS = opus_frame::NUM_SAMPLES_MINLATENCY * 1'000'000 / 48; /* 2.5 ms */
+
+/* one stagecast-client's network behavior: key exchange, then one Opus frame of synthetic audio per tick */
+class SimulatedPeer
+{
+  UDPSocket socket_ {};
+  Address server_;
+  CryptoSession long_lived_crypto_;
+  optional<AudioNetworkConnection> connection_ {};
+
+  OpusEncoderProcess encoder_ { 96000, 600, 48000 };
+  ChannelPair audio_ { 8192 };
+  size_t samples_generated_ {};
+  float frequency_;
+
+  unsigned int ticks_until_key_request_ {};
+
+public:
+  struct Statistics
+  {
+    unsigned int key_requests, packets_sent, packets_received, bad_packets;
+  } stats {};
+
+  SimulatedPeer( const Address& server, const LongLivedKey& key, const unsigned int index )
+    : server_( server )
+    , long_lived_crypto_( key.key_pair().uplink, key.key_pair().downlink, true )
+    , frequency_( 220.0 * ( index + 1 ) )
+  {
+    socket_.set_blocking( false );
+  }
+
+  bool has_session() const { return connection_.has_value(); }
+
+  /* synthesize and encode one frame, then send it (or ask for a session) */
+  void tick()
+  {
+    span<float> ch1 = audio_.ch1().region( samples_generated_, opus_frame::NUM_SAMPLES_MINLATENCY );
+    span<float> ch2 = audio_.ch2().region( samples_generated_, opus_frame::NUM_SAMPLES_MINLATENCY );
+    for ( size_t i = 0; i < ch1.size(); i++ ) {
+      ch1[i] = 0.2 * sin( 2 * M_PI * frequency_ * ( samples_generated_ + i ) / 48000.0 );
+      ch2[i] = 0.5 * ch1[i];
+    }
+    samples_generated_ += opus_frame::NUM_SAMPLES_MINLATENCY;
+
+    encoder_.encode_one_frame( audio_.ch1(), audio_.ch2() );
+    audio_.pop_before( encoder_.min_encode_cursor() );
+
+    if ( connection_.has_value() ) {
+      connection_->push_frame( encoder_ );
+      connection_->send_packet( socket_ );
+      stats.packets_sent++;
+      return;
+    }
+
+    encoder_.pop_frame();
+    if ( ticks_until_key_request_-- == 0 ) {
+      ticks_until_key_request_ = 100;
+      Plaintext empty;
+      empty.resize( 0 );
+      Ciphertext keyreq;
+      long_lived_crypto_.encrypt( { &KeyMessage::keyreq_id, 1 }, empty, keyreq );
+      socket_.sendto( server_, keyreq );
+      stats.key_requests++;
+    }
+  }
+
+  /* take everything the server has sent, as NetworkClient would (without decoding the audio) */
+  void receive()
+  {
+    Address src { nullptr, 0 };
+    Ciphertext ciphertext;
+
+    while ( true ) {
+      string_span payload = ciphertext.mutable_buffer();
+      if ( socket_.recv_batch( { &src, 1 }, { &payload, 1 } ) == 0 ) {
+        return;
+      }
+      ciphertext.resize( payload.size() );
+
+      if ( ciphertext.length() <= 24 ) {
+        stats.bad_packets++;
+        continue;
+      }
+
+      const uint8_t node_id = ciphertext.as_string_view().back();
+      if ( node_id == uint8_t( KeyMessage::keyreq_server_id ) and not connection_.has_value() ) {
+        Plaintext plaintext;
+        if ( not long_lived_crypto_.decrypt( ciphertext, { &KeyMessage::keyreq_server_id, 1 }, plaintext ) ) {
+          stats.bad_packets++;
+          continue;
+        }
+        Parser p { plaintext };
+        KeyMessage keys;
+        p.object( keys );
+        if ( p.error() ) {
+          stats.bad_packets++;
+          continue;
+        }
+        connection_.emplace(
+          keys.id, 0, CryptoSession( keys.key_pair.uplink, keys.key_pair.downlink ), server_ );
+      } else if ( node_id == 0 and connection_.has_value() ) {
+        if ( connection_->receive_packet_in_place( ciphertext ) ) {
+          stats.packets_received++;
+          connection_->pop_frames( connection_->next_frame_needed() - connection_->frames().range_begin() );
+        } else {
+          stats.bad_packets++;
+        }
+      } else {
+        stats.bad_packets++;
+      }
+    }
+  }
+};
+
+struct LoadResult
+{
+  unsigned int ticks, overruns;
+  Timer::Record server_work {};
+  NetworkMultiServer::PhaseTimes phases {};
+  uint64_t packets_to_server, packets_from_server;
+  unsigned int peers_without_session;
+};
+
+/* Virtual clock: time stands still while the server works, so every run sends and receives the same packets.
+   Each tick's work (everything the server's EventLoop does before it goes idle) is timed on the real clock. */
+LoadResult run_virtual( const unsigned int num_clients, const unsigned int num_ticks )
+{
+  const uint64_t start = Timer::timestamp_ns();
+  Timer::set_virtual_clock( start );
+
+  LoadResult result {};
+
+  {
+    EventLoop loop;
+    NetworkMultiServer server { uint8_t( num_clients ), loop, 0, 0 };
+    const Address server_address { "127.0.0.1", server.local_address().port() };
+
+    vector<unique_ptr<SimulatedPeer>> peers;
+    for ( unsigned int i = 0; i < num_clients; i++ ) {
+      const LongLivedKey key { "peer" + to_string( i ) };
+      server.add_key( key );
+      peers.push_back( make_unique<SimulatedPeer>( server_address, key, i ) );
+    }
+
+    for ( unsigned int tick = 1; tick <= num_ticks; tick++ ) {
+      /* just past the server's next deadline */
+      Timer::set_virtual_clock( start + tick * TICK_NS + 1000 );
+
+      for ( auto& peer : peers ) {
+        peer->receive();
+        peer->tick();
+      }
+
+      const uint64_t work_start = Timer::timestamp_ns();
+      while ( loop.wait_next_event( 0 ) != EventLoop::Result::Timeout ) {
+      }
+      const uint64_t work_ns = Timer::timestamp_ns() - work_start;
+
+      result.server_work.log( work_ns );
+      if ( work_ns > TICK_NS ) {
+        result.overruns++;
+      }
+    }
+
+    result.ticks = server.tick_lateness().count;
+    result.phases = server.phase_times();
+    for ( const auto& peer : peers ) {
+      result.packets_to_server += peer->stats.packets_sent + peer->stats.key_requests;
+      result.packets_from_server += peer->stats.packets_received;
+      result.peers_without_session += not peer->has_session();
+    }
+  }
+
+  Timer::clear_virtual_clock();
+  return result;
+}
+
+/* Real clock: the peers run on their own thread, and an overrun is a tick that started a whole tick late */
+LoadResult run_realtime( const unsigned int num_clients, const unsigned int num_ticks )
+{
+  LoadResult result {};
+
+  EventLoop loop;
+  NetworkMultiServer server { uint8_t( num_clients ), loop, 0, 0 };
+  const Address server_address { "127.0.0.1", server.local_address().port() };
+
+  vector<unique_ptr<SimulatedPeer>> peers;
+  for ( unsigned int i = 0; i < num_clients; i++ ) {
+    const LongLivedKey key { "peer" + to_string( i ) };
+    server.add_key( key );
+    peers.push_back( make_unique<SimulatedPeer>( server_address, key, i ) );
+  }
+
+  server.initialize_clock();
+  const auto start = steady_clock::now();
+  const auto end = start + nanoseconds( num_ticks * TICK_NS );
+
+  thread peer_thread { [&] {
+    for ( unsigned int tick = 1; tick <= num_ticks; tick++ ) {
+      this_thread::sleep_until( start + nanoseconds( tick * TICK_NS ) );
+      for ( auto& peer : peers ) {
+        peer->receive();
+        peer->tick();
+      }
+    }
+  } };
+
+  while ( steady_clock::now() < end ) {
+    loop.wait_next_event( 10 );
+  }
+  peer_thread.join();
+
+  result.ticks = server.tick_lateness().count;
+  result.overruns = server.ticks_missed();
+  result.server_work = server.tick_lateness();
+  result.phases = server.phase_times();
+  for ( const auto& peer : peers ) {
+    result.packets_to_server += peer->stats.packets_sent + peer->stats.key_requests;
+    result.packets_from_server += peer->stats.packets_received;
+    result.peers_without_session += not peer->has_session();
+  }
+
+  return result;
+}
+
+void print_phase( const string_view name, const Timer::Record& record )
+{
+  cout << " " << name << "=";
+  Timer::pp_ns( cout, record.count ? record.total_ns / record.count : 0 );
+}
+
+void program_body( const bool realtime, const unsigned int max_clients, const double seconds )
+{
+  const unsigned int num_ticks = lrint( seconds * BILLION / TICK_NS );
+
+  cout << "NetworkMultiServer load test: " << num_ticks << " ticks on the " << ( realtime ? "real" : "virtual" )
+       << " clock\n";
+  cout << ( realtime ? "   (work = lateness of each tick's start; overrun = started a whole tick late)\n"
+                     : "   (work = server time per tick; overrun = work longer than one tick)\n" );
+
+  bool ok = true;
+
+  for ( unsigned int num_clients = 1; num_clients <= max_clients; num_clients *= 2 ) {
+    const LoadResult r = realtime ? run_realtime( num_clients, num_ticks ) : run_virtual( num_clients, num_ticks );
+
+    cout << "   " << setw( 3 ) << num_clients << " clients: work mean ";
+    Timer::pp_ns( cout, r.server_work.count ? r.server_work.total_ns / r.server_work.count : 0 );
+    cout << " ";
+    r.server_work.print_percentiles( cout );
+    cout << " max ";
+    Timer::pp_ns( cout, r.server_work.max_ns );
+    cout << "   overruns " << r.overruns << "/" << r.ticks << " (" << setprecision( 2 )
+         << 100.0 * r.overruns / max( 1U, r.ticks ) << "%)\n";
+
+    cout << "                ";
+    print_phase( "decode", r.phases.decode );
+    print_phase( "mix", r.phases.mix );
+    print_phase( "encode", r.phases.encode );
+    print_phase( "send", r.phases.send );
+    cout << "   packets/s in=" << setprecision( 0 ) << r.packets_to_server / seconds
+         << " out=" << r.packets_from_server / seconds << "\n";
+
+    /* on the virtual clock, every tick runs and (after the key exchange) every peer hears from the server */
+    if ( r.peers_without_session > 0 ) {
+      cout << "      ERROR: " << r.peers_without_session << " peers never got a session\n";
+      ok = false;
+    }
+    if ( not realtime and r.ticks != num_ticks ) {
+      cout << "      ERROR: server ran " << r.ticks << " ticks\n";
+      ok = false;
+    }
+    const uint64_t expected_packets = num_ticks > 10 ? uint64_t( num_clients ) * ( num_ticks - 10 ) : 0;
+    if ( not realtime and r.packets_from_server < expected_packets ) {
+      cout << "      ERROR: only " << r.packets_from_server << " packets reached the peers\n";
+      ok = false;
+    }
+  }
+
+  if ( not ok ) {
+    throw runtime_error( "load test failed" );
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    vector<string> args { argv + 1, argv + argc };
+    const bool realtime = not args.empty() and args.front() == "--realtime";
+    if ( realtime ) {
+      args.erase( args.begin() );
+    }
+
+    if ( args.size() > 2 ) {
+      cerr << "Usage: " << argv[0] << " [--realtime] [max_clients=32] [seconds=2]\n";
+      return EXIT_FAILURE;
+    }
+
+    const unsigned int max_clients = args.size() > 0 ? stoul( args.at( 0 ) ) : 32;
+    const double seconds = args.size() > 1 ? stod( args.at( 1 ) ) : 2;
+    if ( max_clients == 0 or max_clients > 127 or seconds <= 0 ) {
+      cerr << "max_clients must be 1-127, and seconds positive\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body( realtime, max_clients, seconds );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+
+#include "partial_frame_store.hh"
+
+using namespace std;
+
+/* a frame that remembers what was written into it, and starts out blank */
+struct TestFrame
+{
+  uint64_t value {};
+};
+
+/* Applies random operations to a PartialFrameStore and to a std::map holding the same frames, and checks
+   that every query agrees. Positions cluster around both ends of the window (where the store's first and
+   last partial words share a word and a block) and pops mostly move the window by less than a word, so
+   the window spends most of its time unaligned. */
+class Checker
+{
+  PartialFrameStore<TestFrame> store_;
+  map<size_t, uint64_t> model_ {};
+  size_t begin_ {}, capacity_;
+
+  mt19937_64 rng_;
+  uint64_t next_value_ = 1;
+  unsigned int operations_ {};
+
+  size_t end() const { return begin_ + capacity_; }
+
+  size_t random_below( const size_t n ) { return uniform_int_distribution<size_t>( 0, n - 1 )( rng_ ); }
+
+  /* somewhere in (or just outside) the window, often near one of its ends */
+  size_t random_position()
+  {
+    const size_t slack = 70;
+    switch ( random_below( 4 ) ) {
+      case 0:
+        return begin_ + random_below( capacity_ );
+      case 1:
+        return begin_ + random_below( slack );
+      case 2:
+        return end() - min( end(), slack ) + random_below( 2 * slack );
+      default:
+        return begin_ - min( begin_, slack ) + random_below( capacity_ + 2 * slack );
+    }
+  }
+
+  void fail( const string& what ) const
+  {
+    throw runtime_error( "capacity " + to_string( capacity_ ) + ", window [" + to_string( begin_ ) + ", "
+                         + to_string( end() ) + "), after " + to_string( operations_ ) + " operations: " + what );
+  }
+
+  void expect( const bool condition, const string& what ) const
+  {
+    if ( not condition ) {
+      fail( what );
+    }
+  }
+
+  void emplace( const size_t pos )
+  {
+    if ( pos < begin_ or pos >= end() ) {
+      try {
+        store_.emplace( pos );
+      } catch ( const out_of_range& ) {
+        return;
+      }
+      fail( "emplace outside the window at " + to_string( pos ) + " did not throw" );
+    }
+
+    TestFrame& frame = store_.emplace( pos );
+    expect( frame.value == 0, "emplace at " + to_string( pos ) + " returned a frame that was not reset" );
+    frame.value = model_[pos] = next_value_++;
+  }
+
+  void erase( const size_t pos )
+  {
+    if ( pos < begin_ or pos >= end() ) {
+      try {
+        store_.erase( pos );
+      } catch ( const out_of_range& ) {
+        return;
+      }
+      fail( "erase outside the window at " + to_string( pos ) + " did not throw" );
+    }
+
+    store_.erase( pos );
+    model_.erase( pos );
+  }
+
+  void pop( const size_t num )
+  {
+    store_.pop( num );
+    begin_ += num;
+    model_.erase( model_.begin(), model_.lower_bound( begin_ ) );
+  }
+
+  size_t expected_next( const size_t pos, const bool present ) const
+  {
+    size_t i = max( pos, begin_ );
+    auto it = model_.lower_bound( i );
+    if ( present ) {
+      return it == model_.end() ? end() : min( it->first, end() );
+    }
+
+    /* walk the run of frames held from i on */
+    for ( ; it != model_.end() and it->first == i; ++it ) {
+      i++;
+    }
+    return min( i, end() );
+  }
+
+  void check_queries( const size_t pos )
+  {
+    expect( store_.next_missing( pos ) == expected_next( pos, false ), "next_missing( " + to_string( pos ) + " )" );
+    expect( store_.next_present( pos ) == expected_next( pos, true ), "next_present( " + to_string( pos ) + " )" );
+
+    const size_t last = random_position();
+    const size_t first = min( pos, last ), second = max( pos, last ) + 1;
+    const size_t expected_count = distance( model_.lower_bound( first ), model_.lower_bound( second ) );
+    expect( store_.count( first, second ) == expected_count,
+            "count( " + to_string( first ) + ", " + to_string( second ) + " )" );
+  }
+
+  /* everything in and around the window, and the blocks held */
+  void check_all()
+  {
+    expect( store_.range_begin() == begin_ and store_.range_end() == end(), "range" );
+
+    for ( size_t pos = begin_ - min( begin_, size_t( 64 ) ); pos < end() + 64; pos++ ) {
+      const auto it = model_.find( pos );
+      expect( store_.has_value( pos ) == ( it != model_.end() ), "has_value( " + to_string( pos ) + " )" );
+      if ( it != model_.end() ) {
+        expect( store_.at( pos ).value == it->second, "at( " + to_string( pos ) + " )" );
+      }
+    }
+
+    /* a block is held exactly while some frame of its word is */
+    set<size_t> words;
+    for ( const auto& [pos, value] : model_ ) {
+      words.insert( ( pos / 64 ) % ( capacity_ / 64 ) );
+    }
+    expect( store_.blocks_in_use() == words.size(), "blocks_in_use" );
+  }
+
+public:
+  Checker( const size_t capacity, const uint64_t seed )
+    : store_( capacity )
+    , capacity_( capacity )
+    , rng_( seed )
+  {}
+
+  void run( const unsigned int num_operations )
+  {
+    for ( operations_ = 0; operations_ < num_operations; operations_++ ) {
+      const unsigned int op = random_below( 100 );
+      if ( op < 40 ) {
+        emplace( random_position() );
+      } else if ( op < 55 ) {
+        erase( random_position() );
+      } else if ( op < 60 ) {
+        /* fill a run, so some words fill up completely */
+        const size_t pos = random_position(), n = random_below( 130 );
+        for ( size_t i = pos; i < pos + n; i++ ) {
+          emplace( i );
+        }
+      } else if ( op < 70 ) {
+        /* mostly less than a word; sometimes several, or more than the whole window */
+        const unsigned int kind = random_below( 10 );
+        pop( kind < 7 ? random_below( 64 ) : kind < 9 ? random_below( 3 * 64 ) : random_below( 2 * capacity_ ) );
+      } else {
+        check_queries( random_position() );
+      }
+
+      if ( operations_ % 64 == 0 ) {
+        check_all();
+      }
+    }
+
+    check_all();
+  }
+};
+
+void program_body()
+{
+  unsigned int runs = 0;
+  for ( const size_t capacity : { 64, 128, 256, 1024 } ) {
+    for ( uint64_t seed = 1; seed <= 10; seed++ ) {
+      Checker( capacity, seed ).run( 4000 );
+      runs++;
+    }
+  }
+
+  cout << runs << " randomized runs matched the reference\n";
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 1 ) {
+      cerr << "Usage: " << argv[0] << "\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "rate_controller.hh"
+
+using namespace std;
+
+using SenderStatistics = NetworkSender<AudioFrame>::Statistics;
+
+static constexpr uint64_t INTERVAL_NS = RateController::Config {}.interval_ns;
+static constexpr uint64_t MS = 1'000'000;
+
+void check( const bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "failed: " + what );
+  }
+}
+
+/* drives a RateController one interval at a time with made-up sender statistics */
+class Path
+{
+  RateController controller_ {};
+  SenderStatistics sender_ {};
+  uint64_t now_ = 1'000'000'000;
+
+public:
+  Path()
+  {
+    check( not controller_.update( sender_, now_ ), "retune on the first call" );
+    check( controller_.bit_rate() == RateController::Config {}.max_bit_rate, "start at the full rate" );
+  }
+
+  /* one interval of 400 packets with the given losses, dropped frames and smoothed RTT */
+  bool interval( const unsigned int losses, const unsigned int frames_dropped, const float rtt_ms )
+  {
+    now_ += INTERVAL_NS / 2;
+    check( not controller_.update( sender_, now_ ), "retune before the interval is over" );
+
+    sender_.packet_transmissions += 400;
+    sender_.packet_losses_detected += losses;
+    sender_.frames_dropped += frames_dropped;
+    sender_.smoothed_rtt = rtt_ms * MS;
+
+    now_ += INTERVAL_NS / 2;
+    return controller_.update( sender_, now_ );
+  }
+
+  const RateController& controller() const { return controller_; }
+};
+
+void test_aimd()
+{
+  Path path;
+
+  /* already at the full rate, so clean intervals change nothing */
+  check( not path.interval( 0, 0, 0 ), "retune on a clean interval at the full rate" );
+  check( path.controller().bit_rate() == 96000, "full rate held" );
+  check( path.controller().complexity() == 9, "complexity at the full rate" );
+
+  /* loss above the threshold: multiplicative decrease, and more effort per bit */
+  check( path.interval( 40, 0, 0 ), "retune after a lossy interval" );
+  check( path.controller().bit_rate() == 72000, "decrease by a quarter after loss" );
+  check( path.controller().complexity() == 10, "complexity below the full rate" );
+  check( path.controller().expected_loss_percent() > 0, "loss hint after loss" );
+
+  /* loss below the threshold counts as clean: additive increase */
+  check( path.interval( 10, 0, 0 ), "retune after a clean interval" );
+  check( path.controller().bit_rate() == 76000, "increase by one step" );
+
+  /* dropped frames: decrease */
+  check( path.interval( 0, 1, 0 ), "retune after dropped frames" );
+  check( path.controller().bit_rate() == 57000, "decrease after dropped frames" );
+
+  /* repeated losses bottom out at the floor */
+  for ( unsigned int i = 0; i < 10; i++ ) {
+    path.interval( 400, 0, 0 );
+  }
+  check( path.controller().bit_rate() == 32000, "floor at the minimum rate" );
+  const unsigned int decreases = path.controller().stats().decreases;
+  path.interval( 400, 0, 0 );
+  check( path.controller().stats().decreases == decreases, "no decrease counted at the floor" );
+
+  /* clean again: climb one step per interval, and the loss hint decays */
+  for ( unsigned int i = 0; i < 16; i++ ) {
+    check( path.interval( 0, 0, 0 ), "retune while climbing" );
+  }
+  check( path.controller().bit_rate() == 96000, "climb back to the full rate" );
+  path.interval( 0, 0, 0 );
+  check( path.controller().bit_rate() == 96000, "ceiling at the full rate" );
+  for ( unsigned int i = 0; i < 50; i++ ) {
+    path.interval( 0, 0, 0 );
+  }
+  check( path.controller().expected_loss_percent() == 0, "loss hint decays on a clean path" );
+}
+
+void test_hold_after_decrease()
+{
+  Path path;
+
+  /* with a long RTT, a decrease holds the rate for two RTTs, so the next interval's loss (sent before the
+     decrease took effect) doesn't cut it again */
+  check( path.interval( 40, 0, 150 ), "retune after a lossy interval" );
+  check( path.controller().bit_rate() == 72000, "decrease after loss" );
+  path.interval( 40, 0, 150 );
+  path.interval( 40, 0, 150 );
+  check( path.controller().bit_rate() == 72000, "rate held within two RTTs of a decrease" );
+  path.interval( 40, 0, 150 );
+  check( path.controller().bit_rate() == 54000, "decrease again once the hold is over" );
+}
+
+void test_queueing()
+{
+  Path path;
+
+  /* ride out the warmup with a clean 20 ms path, then let the RTT flap between 20 and 30 ms */
+  for ( unsigned int i = 0; i < RateController::Config {}.rtt_warmup_intervals; i++ ) {
+    path.interval( 0, 0, 20 );
+  }
+  for ( unsigned int i = 0; i < 500; i++ ) {
+    path.interval( 0, 0, i % 2 ? 30 : 20 );
+    check( path.controller().bit_rate() == 96000, "no decrease while queueing stays under the threshold" );
+  }
+
+  /* the base RTT is the window's minimum, not an average pulled up by the larger samples */
+  path.interval( 0, 0, 29 );
+  check( path.controller().stats().queueing_ns == 9 * MS, "queueing measured from the lowest RTT" );
+
+  /* growing delay past the threshold: decrease */
+  path.interval( 0, 0, 25 );
+  check( path.interval( 0, 0, 35 ), "retune when the queue grows" );
+  check( path.controller().bit_rate() == 72000, "decrease when the queue grows" );
+
+  /* a standing queue, not growing: no decrease, and the rate climbs back */
+  for ( unsigned int i = 0; i < 6; i++ ) {
+    path.interval( 0, 0, 35 );
+  }
+  check( path.controller().bit_rate() == 96000, "a standing queue is not cut" );
+
+  /* once the 20 ms samples leave the window, the new path's RTT becomes the base */
+  const uint64_t window_intervals = RateController::Config {}.base_rtt_window_ns / INTERVAL_NS;
+  for ( unsigned int i = 0; i < window_intervals; i++ ) {
+    path.interval( 0, 0, 35 );
+  }
+  check( path.controller().stats().queueing_ns == 0, "old minimum forgotten after the window" );
+}
+
+void program_body()
+{
+  test_aimd();
+  test_hold_after_decrease();
+  test_queueing();
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 1 ) {
+      cerr << "Usage: " << argv[0] << "\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
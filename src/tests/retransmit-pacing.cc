@@ -0,0 +1,143 @@
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "frame_source.hh"
+#include "receiver.hh"
+#include "sender.hh"
+#include "timer.hh"
+
+using namespace std;
+
+static constexpr uint64_t TICK_NS = opus_frame::NUM_SAMPLES_MINLATENCY * 1'000'000 / 48; /* 2.5 ms */
+static constexpr uint64_t ONE_WAY_DELAY_NS = 10'000'000;
+
+struct Result
+{
+  vector<unsigned int> retransmitted_per_packet; /* from the end of the burst on */
+  unsigned int paced_packets;
+  uint32_t frames_sent, frames_delivered;
+};
+
+/* one packet per tick over a 20 ms RTT; the packets of ticks [burst_start, burst_start + burst_length) are lost */
+Result run( const unsigned int burst_start, const unsigned int burst_length, const unsigned int num_ticks )
+{
+  NetworkSender<AudioFrame> sender;
+  NetworkReceiver<AudioFrame> receiver;
+  FrameSource source;
+
+  deque<pair<uint64_t, string>> uplink; /* serialized packets */
+  deque<pair<uint64_t, Packet<AudioFrame>::ReceiverSection>> downlink;
+
+  Result result {};
+  array<char, 1500> datagram;
+
+  uint64_t now = Timer::timestamp_ns();
+  for ( unsigned int tick = 0; tick < num_ticks; tick++ ) {
+    now += TICK_NS;
+    Timer::set_virtual_clock( now );
+
+    while ( not uplink.empty() and uplink.front().first <= now ) {
+      Packet<AudioFrame>::ReceiverSection unused_acks;
+      NetString unused_data;
+      Parser p { uplink.front().second };
+      receiver.receive_packet( p, unused_acks, unused_data );
+      if ( p.error() ) {
+        p.clear_error();
+        throw runtime_error( "parse error" );
+      }
+      uplink.pop_front();
+    }
+    while ( not downlink.empty() and downlink.front().first <= now ) {
+      sender.receive_receiver_section( downlink.front().second );
+      downlink.pop_front();
+    }
+
+    sender.push_frame( source );
+    const unsigned int retransmissions_before = sender.stats().frame_retransmissions;
+    OutboundPacket<AudioFrame> packet;
+    sender.set_sender_section( packet );
+
+    if ( tick >= burst_start + burst_length ) {
+      result.retransmitted_per_packet.push_back( sender.stats().frame_retransmissions - retransmissions_before );
+    }
+
+    if ( tick < burst_start or tick >= burst_start + burst_length ) {
+      Serializer s { { datagram.data(), datagram.size() } };
+      s.object( packet );
+      uplink.emplace_back( now + ONE_WAY_DELAY_NS, string( datagram.data(), s.bytes_written() ) );
+    }
+
+    Packet<AudioFrame>::ReceiverSection receiver_section;
+    receiver.set_receiver_section( receiver_section );
+    receiver.pop_frames( receiver.next_frame_needed() - receiver.frames().range_begin() );
+    downlink.emplace_back( now + ONE_WAY_DELAY_NS, receiver_section );
+  }
+
+  Timer::clear_virtual_clock();
+
+  result.paced_packets = sender.stats().paced_packets;
+  result.frames_sent = num_ticks;
+  result.frames_delivered = receiver.next_frame_needed();
+  return result;
+}
+
+void program_body()
+{
+  /* a burst of 20 lost packets (50 ms) after the delivery rate has settled, then a second's worth of ticks */
+  const unsigned int burst_start = 400, burst_length = 20, num_ticks = 800;
+  const Result result = run( burst_start, burst_length, num_ticks );
+
+  cout << "Retransmitted frames per packet after a " << burst_length << "-packet loss burst:";
+  unsigned int total = 0, largest = 0, packets_with_retransmissions = 0;
+  for ( const unsigned int n : result.retransmitted_per_packet ) {
+    if ( n ) {
+      cout << " " << n;
+      packets_with_retransmissions++;
+    }
+    total += n;
+    largest = max( largest, n );
+  }
+  cout << "\n";
+  cout << "paced packets: " << result.paced_packets << ", frames delivered: " << result.frames_delivered << "/"
+       << result.frames_sent << "\n";
+
+  if ( total < burst_length ) {
+    throw runtime_error( "the lost frames were not retransmitted" );
+  }
+
+  /* unpaced, the whole burst goes out in the first couple of packets after the loss is detected, each full */
+  if ( largest >= AudioFrame::frames_per_packet - 1 or packets_with_retransmissions < 3
+       or result.paced_packets == 0 ) {
+    throw runtime_error( "the repair of the burst was not spread over packets" );
+  }
+
+  /* every frame but those still in flight at the end reaches the receiver */
+  const uint32_t in_flight = 2 * ONE_WAY_DELAY_NS / TICK_NS + 1;
+  if ( result.frames_delivered + in_flight < result.frames_sent ) {
+    throw runtime_error( "frames were not delivered" );
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc != 1 ) {
+      cerr << "Usage: " << argv[0] << "\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_source.hh"
+#include "receiver.hh"
+#include "sender.hh"
+#include "timer.hh"
+
+using namespace std;
+
+static constexpr uint64_t TICK_NS = opus_frame::NUM_SAMPLES_MINLATENCY * 1'000'000 / 48; /* 2.5 ms */
+static constexpr uint64_t ONE_WAY_DELAY_NS = 10'000'000;
+
+/* the original encoding: the first 32 acknowledgments, as explicit sequence numbers */
+void serialize_legacy( const SelectiveAcks& acks, Serializer& s )
+{
+  const uint8_t count = min( acks.size(), size_t( SelectiveAcks::legacy_capacity ) );
+  s.integer( count );
+
+  uint8_t written = 0;
+  for ( auto it = acks.begin(); written < count; ++it, ++written ) {
+    s.integer( *it );
+  }
+}
+
+uint32_t legacy_length( const SelectiveAcks& acks )
+{
+  return 1 + 4 * min( acks.size(), size_t( SelectiveAcks::legacy_capacity ) );
+}
+
+/* how far back (in packets) the oldest acknowledgment reaches, with at most `limit` acknowledgments */
+uint32_t reach( const SelectiveAcks& acks, const size_t limit )
+{
+  uint32_t oldest = acks.greatest.value();
+  size_t n = 0;
+  for ( auto it = acks.begin(); it != acks.end() and n < limit; ++it, ++n ) {
+    oldest = *it;
+  }
+  return acks.greatest.value() - oldest;
+}
+
+struct Scenario
+{
+  string name;
+  double loss;
+  unsigned int burst_every, burst_length; /* in packets; zero for none */
+};
+
+struct Totals
+{
+  uint64_t sections, bytes_new, bytes_legacy, reach_new, reach_legacy;
+  uint64_t encode_decode_new_ns, encode_decode_legacy_ns;
+  unsigned int mismatches;
+};
+
+bool same_acks( const SelectiveAcks& a, const SelectiveAcks& b, const size_t limit )
+{
+  auto ia = a.begin(), ib = b.begin();
+  for ( size_t n = 0; n < limit; n++, ++ia, ++ib ) {
+    const bool a_done = not( ia != a.end() ), b_done = not( ib != b.end() );
+    if ( a_done or b_done ) {
+      return a_done and b_done;
+    }
+    if ( *ia != *ib ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Totals run_scenario( const Scenario& scenario, const unsigned int num_ticks )
+{
+  NetworkSender<AudioFrame> sender;
+  NetworkReceiver<AudioFrame> receiver;
+  FrameSource source;
+
+  mt19937 rng { 1 };
+  bernoulli_distribution random_loss { scenario.loss };
+
+  deque<pair<uint64_t, string>> uplink; /* serialized packets */
+  deque<pair<uint64_t, Packet<AudioFrame>::ReceiverSection>> downlink;
+
+  Totals totals {};
+  array<char, 256> buffer;
+  array<char, 1500> datagram;
+
+  uint64_t now = Timer::timestamp_ns();
+  for ( unsigned int tick = 0; tick < num_ticks; tick++ ) {
+    now += TICK_NS;
+    Timer::set_virtual_clock( now );
+
+    while ( not uplink.empty() and uplink.front().first <= now ) {
+      Packet<AudioFrame>::ReceiverSection unused_acks;
+      NetString unused_data;
+      Parser p { uplink.front().second };
+      receiver.receive_packet( p, unused_acks, unused_data );
+      if ( p.error() ) {
+        p.clear_error();
+        throw runtime_error( "parse error" );
+      }
+      uplink.pop_front();
+    }
+    while ( not downlink.empty() and downlink.front().first <= now ) {
+      sender.receive_receiver_section( downlink.front().second );
+      downlink.pop_front();
+    }
+
+    sender.push_frame( source );
+    OutboundPacket<AudioFrame> packet;
+    sender.set_sender_section( packet );
+
+    const bool in_burst = scenario.burst_every and tick % scenario.burst_every < scenario.burst_length;
+    if ( not in_burst and not random_loss( rng ) ) {
+      Serializer s { { datagram.data(), datagram.size() } };
+      s.object( packet );
+      uplink.emplace_back( now + ONE_WAY_DELAY_NS, string( datagram.data(), s.bytes_written() ) );
+    }
+
+    Packet<AudioFrame>::ReceiverSection receiver_section;
+    receiver.set_receiver_section( receiver_section );
+    receiver.pop_frames( receiver.next_frame_needed() - receiver.frames().range_begin() );
+    downlink.emplace_back( now + ONE_WAY_DELAY_NS, receiver_section );
+
+    const SelectiveAcks& acks = receiver_section.packets_received;
+    if ( acks.empty() ) {
+      continue;
+    }
+
+    totals.sections++;
+    totals.bytes_new += acks.serialized_length();
+    totals.bytes_legacy += legacy_length( acks );
+    totals.reach_new += reach( acks, SIZE_MAX );
+    totals.reach_legacy += reach( acks, SelectiveAcks::legacy_capacity );
+
+    /* round trip through each encoding */
+    SelectiveAcks parsed;
+
+    uint64_t start = Timer::timestamp_ns();
+    {
+      Serializer s { { buffer.data(), buffer.size() } };
+      acks.serialize( s );
+      Parser p { { buffer.data(), s.bytes_written() } };
+      parsed.parse( p );
+      totals.mismatches += p.error() or not same_acks( acks, parsed, SIZE_MAX );
+    }
+    totals.encode_decode_new_ns += Timer::timestamp_ns() - start;
+
+    start = Timer::timestamp_ns();
+    {
+      Serializer s { { buffer.data(), buffer.size() } };
+      serialize_legacy( acks, s );
+      Parser p { { buffer.data(), s.bytes_written() } };
+      parsed.parse( p );
+      totals.mismatches += p.error() or not same_acks( acks, parsed, SelectiveAcks::legacy_capacity );
+    }
+    totals.encode_decode_legacy_ns += Timer::timestamp_ns() - start;
+  }
+
+  Timer::clear_virtual_clock();
+  return totals;
+}
+
+void program_body( const unsigned int num_ticks )
+{
+  const vector<Scenario> scenarios = { { "no loss", 0, 0, 0 },
+                                       { "1% loss", 0.01, 0, 0 },
+                                       { "5% loss", 0.05, 0, 0 },
+                                       { "20-packet bursts every 1.25 s", 0, 500, 20 },
+                                       { "5% loss + 100-packet bursts every 2.5 s", 0.05, 1000, 100 } };
+
+  cout << "Receiver-section acknowledgments, " << num_ticks << " packets at 20 ms RTT (bytes and reach per packet)\n";
+
+  bool ok = true;
+  for ( const auto& scenario : scenarios ) {
+    const Totals t = run_scenario( scenario, num_ticks );
+    const double n = max( uint64_t( 1 ), t.sections );
+
+    cout << "   " << scenario.name << ":\n";
+    cout << fixed << setprecision( 1 );
+    cout << "      explicit list: " << t.bytes_legacy / n << " B, back " << t.reach_legacy / n << " packets, "
+         << t.encode_decode_legacy_ns / n << " ns to encode+decode\n";
+    cout << "      bitmap:        " << t.bytes_new / n << " B, back " << t.reach_new / n << " packets, "
+         << t.encode_decode_new_ns / n << " ns to encode+decode\n";
+
+    if ( t.mismatches ) {
+      cout << "      ERROR: " << t.mismatches << " acknowledgment sets changed in a round trip\n";
+      ok = false;
+    }
+  }
+
+  if ( not ok ) {
+    throw runtime_error( "round trip failed" );
+  }
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc > 2 ) {
+      cerr << "Usage: " << argv[0] << " [packets=40000]\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body( argc > 1 ? stoul( argv[1] ) : 40000 );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "control_messages.hh"
+#include "formats.hh"
+#include "timer.hh"
+
+using namespace std;
+
+/* a full audio packet: eight two-channel frames, parity, a busy ack section and a client report */
+Packet<AudioFrame> make_packet()
+{
+  default_random_engine gen { 1 };
+  uniform_int_distribution<int> byte { 0, 255 };
+
+  Packet<AudioFrame> packet;
+  packet.sender_section.sequence_number = 123456;
+
+  for ( uint32_t i = 0; i < AudioFrame::frames_per_packet; i++ ) {
+    AudioFrame frame;
+    frame.frame_index = 1000 + i;
+    frame.separate_channels = true;
+    frame.frame1.resize( 40 );
+    frame.frame2.resize( 12 );
+    for ( auto* opus : { &frame.frame1, &frame.frame2 } ) {
+      for ( size_t j = 0; j < opus->length(); j++ ) {
+        opus->mutable_data_ptr()[j] = byte( gen );
+      }
+    }
+    packet.sender_section.frames.push_back( frame );
+  }
+
+  ParityFrame<AudioFrame> parity;
+  for ( uint32_t i = 0; i < AudioFrame::fec_group_size; i++ ) {
+    parity.add( packet.sender_section.frames.elements[i] );
+  }
+  packet.sender_section.parity.push_back( parity );
+
+  packet.receiver_section.next_frame_needed = 990;
+  for ( uint32_t seqno = 123450; seqno > 123450 - 100; seqno -= 3 ) {
+    packet.receiver_section.packets_received.add( seqno );
+  }
+
+  client_report report {};
+  report.resets = 3;
+  report.target_lag = 960;
+  report.actual_lag = 1000.5;
+  Serializer s { packet.unreliable_data_.mutable_buffer() };
+  s.object( report );
+  packet.unreliable_data_.resize( s.bytes_written() );
+
+  return packet;
+}
+
+void program_body( const unsigned int iterations )
+{
+  const Packet<AudioFrame> packet = make_packet();
+  const uint32_t length = packet.serialized_length();
+
+  array<char, 1500> buffer;
+  string_view wire;
+
+  /* serialize */
+  uint64_t start = Timer::timestamp_ns();
+  for ( unsigned int i = 0; i < iterations; i++ ) {
+    Serializer s { { buffer.data(), buffer.size() } };
+    s.object( packet );
+    wire = { buffer.data(), s.bytes_written() };
+  }
+  const uint64_t serialize_ns = Timer::timestamp_ns() - start;
+
+  if ( wire.size() != length ) {
+    throw runtime_error( "serialized length mismatch" );
+  }
+
+  /* the same packet assembled in place, as NetworkConnection does from its sender's frames */
+  OutboundPacket<AudioFrame> outbound;
+  outbound.sequence_number = packet.sender_section.sequence_number;
+  for ( const auto& frame : packet.sender_section.frames ) {
+    outbound.add_frame( frame );
+  }
+  outbound.parity = &packet.sender_section.parity.elements[0];
+  outbound.receiver_section = packet.receiver_section;
+  outbound.unreliable_data = &packet.unreliable_data_;
+
+  array<char, 1500> assembled;
+  string_view assembled_wire;
+  start = Timer::timestamp_ns();
+  for ( unsigned int i = 0; i < iterations; i++ ) {
+    Serializer s { { assembled.data(), assembled.size() } };
+    s.object( outbound );
+    assembled_wire = { assembled.data(), s.bytes_written() };
+  }
+  const uint64_t assemble_ns = Timer::timestamp_ns() - start;
+
+  if ( assembled_wire != wire ) {
+    throw runtime_error( "packet assembled in place differs from Packet" );
+  }
+
+  /* parse */
+  Packet<AudioFrame> parsed;
+  start = Timer::timestamp_ns();
+  for ( unsigned int i = 0; i < iterations; i++ ) {
+    Parser p { wire };
+    p.object( parsed );
+    if ( p.error() ) {
+      p.clear_error();
+      throw runtime_error( "parse error" );
+    }
+  }
+  const uint64_t parse_ns = Timer::timestamp_ns() - start;
+
+  /* round trip */
+  array<char, 1500> reserialized;
+  Serializer s { { reserialized.data(), reserialized.size() } };
+  s.object( parsed );
+  if ( string_view( reserialized.data(), s.bytes_written() ) != wire ) {
+    throw runtime_error( "round trip changed the packet" );
+  }
+
+  cout << "Packet<AudioFrame> of " << length << " bytes, " << iterations << " iterations\n";
+  cout << fixed << setprecision( 0 );
+  cout << "   serialize: " << double( serialize_ns ) / iterations << " ns/packet = "
+       << iterations * BILLION / serialize_ns << " packets/s\n";
+  cout << "   assemble:  " << double( assemble_ns ) / iterations << " ns/packet = "
+       << iterations * BILLION / assemble_ns << " packets/s (frames serialized in place)\n";
+  cout << "   parse:     " << double( parse_ns ) / iterations << " ns/packet = " << iterations * BILLION / parse_ns
+       << " packets/s\n";
+}
+
+int main( int argc, char* argv[] )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort();
+    }
+
+    if ( argc > 2 ) {
+      cerr << "Usage: " << argv[0] << " [iterations=1000000]\n";
+      return EXIT_FAILURE;
+    }
+
+    program_body( argc > 1 ? stoul( argv[1] ) : 1000000 );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
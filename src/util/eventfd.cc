@@ -0,0 +1,22 @@
+#include <sys/eventfd.h>
+
+#include "eventfd.hh"
+#include "exception.hh"
+
+using namespace std;
+
+EventFD::EventFD()
+  : FileDescriptor( ::CheckSystemCall( "eventfd", eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) )
+{}
+
+void EventFD::notify()
+{
+  const uint64_t one = 1;
+  write( { reinterpret_cast<const char*>( &one ), sizeof( one ) } );
+}
+
+void EventFD::drain()
+{
+  uint64_t count;
+  read( { reinterpret_cast<char*>( &count ), sizeof( count ) } );
+}
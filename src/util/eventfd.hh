@@ -0,0 +1,16 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+//! A non-blocking Linux eventfd, used by one thread to wake up another thread's EventLoop
+class EventFD : public FileDescriptor
+{
+public:
+  EventFD();
+
+  //! Make the descriptor readable (safe to call from any thread)
+  void notify();
+
+  //! Consume all pending notifications
+  void drain();
+};
@@ -3,17 +3,33 @@
 #include "socket.hh"
 #include "timer.hh"
 
+#include <array>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 using namespace std;
 
-EventLoop::EventLoop()
-  : _rule_categories()
+EventLoop::EventLoop( const Backend backend )
+  : _backend( backend )
+  , _rule_categories()
+  , _timerfd( CheckSystemCall( "timerfd_create", timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC ) ) )
 {
   _rule_categories.reserve( 64 );
   // prevent _rule_categories from being reallocated in middle of wait_next_event
   // (if a rule adds a new category)
+
+  if ( _backend != Backend::Poll ) {
+    _epoll.emplace( CheckSystemCall( "epoll_create1", epoll_create1( EPOLL_CLOEXEC ) ) );
+
+    /* the timerfd is the one registration without a rule behind it */
+    epoll_event ev {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    CheckSystemCall( "epoll_ctl", epoll_ctl( _epoll->fd_num(), EPOLL_CTL_ADD, _timerfd.fd_num(), &ev ) );
+  }
 }
 
 unsigned int EventLoop::FDRule::service_count() const
@@ -52,6 +68,11 @@ EventLoop::FDRule::FDRule( BasicRule&& base,
   , recover( s_recover )
 {}
 
+EventLoop::TimedRule::TimedRule( BasicRule&& base, const DeadlineT& s_deadline )
+  : BasicRule( base )
+  , deadline( s_deadline )
+{}
+
 EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
                                            const FileDescriptor& fd,
                                            const Direction direction,
@@ -59,15 +80,45 @@ EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
                                            const InterestT& interest,
                                            const CallbackT& cancel,
                                            const InterestT& recover )
+{
+  return add_rule( category_id, Interest::Polled, fd, direction, callback, interest, cancel, recover );
+}
+
+EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
+                                           const Interest interest_mode,
+                                           const FileDescriptor& fd,
+                                           const Direction direction,
+                                           const CallbackT& callback,
+                                           const InterestT& interest,
+                                           const CallbackT& cancel,
+                                           const InterestT& recover )
 {
   if ( category_id >= _rule_categories.size() ) {
     throw out_of_range( "bad category_id" );
   }
 
-  _fd_rules.emplace_back( make_shared<FDRule>(
-    BasicRule { category_id, interest, callback }, fd.duplicate(), direction, cancel, recover ) );
+  auto rule = make_shared<FDRule>(
+    BasicRule { category_id, interest, callback }, fd.duplicate(), direction, cancel, recover );
+
+  /* poll(2) is given every rule on every call anyway */
+  if ( interest_mode == Interest::Polled or _backend == Backend::Poll ) {
+    _fd_rules.push_back( rule );
+    return rule;
+  }
+
+  _reported_fd_rules.push_back( rule );
+  rule->reported_position = prev( _reported_fd_rules.end() );
+  rule->interest_reported = true;
+  rule->report_change = [changed_rules = weak_ptr( _changed_rules ), &this_rule = *rule] {
+    const auto changed = changed_rules.lock();
+    if ( changed and not this_rule.change_queued ) {
+      this_rule.change_queued = true;
+      changed->push_back( &this_rule );
+    }
+  };
+  rule->report_change(); /* registered before the next wait */
 
-  return _fd_rules.back();
+  return rule;
 }
 
 EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
@@ -83,51 +134,155 @@ EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
   return _non_fd_rules.back();
 }
 
+EventLoop::RuleHandle EventLoop::add_timed_rule( const size_t category_id,
+                                                 const CallbackT& callback,
+                                                 const DeadlineT& deadline )
+{
+  if ( category_id >= _rule_categories.size() ) {
+    throw out_of_range( "bad category_id" );
+  }
+
+  _timed_rules.emplace_back(
+    make_shared<TimedRule>( BasicRule { category_id, [] { return true; }, callback }, deadline ) );
+
+  return _timed_rules.back();
+}
+
 void EventLoop::RuleHandle::cancel()
 {
   const shared_ptr<BasicRule> rule_shared_ptr = rule_weak_ptr_.lock();
   if ( rule_shared_ptr ) {
     rule_shared_ptr->cancel_requested = true;
+    if ( rule_shared_ptr->report_change ) {
+      rule_shared_ptr->report_change();
+    }
+  }
+}
+
+void EventLoop::RuleHandle::interest_changed()
+{
+  const shared_ptr<BasicRule> rule_shared_ptr = rule_weak_ptr_.lock();
+  if ( rule_shared_ptr and rule_shared_ptr->report_change ) {
+    rule_shared_ptr->report_change();
   }
 }
 
 EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
 {
-  // first, handle the non-file-descriptor-related rules
-  {
-    for ( auto it = _non_fd_rules.begin(); it != _non_fd_rules.end(); ) {
-      auto& this_rule = **it;
-      bool rule_fired = false;
+  if ( run_timed_rules() ) {
+    return Result::Success;
+  }
 
-      if ( this_rule.cancel_requested ) {
-        it = _non_fd_rules.erase( it );
-        continue;
-      }
+  if ( run_non_fd_rules() ) {
+    return Result::Success;
+  }
 
-      uint8_t iterations = 0;
-      while ( this_rule.interest() ) {
-        if ( iterations++ >= 128 ) {
-          throw runtime_error( "EventLoop: busy wait detected: rule \""
-                               + _rule_categories.at( this_rule.category_id ).name + "\" is still interested after "
-                               + to_string( iterations ) + " iterations" );
-        }
+  arm_timer();
+
+  return _backend == Backend::Poll ? wait_poll( timeout_ms ) : wait_epoll( timeout_ms );
+}
+
+bool EventLoop::run_timed_rules()
+{
+  bool rule_fired = false;
+
+  for ( auto it = _timed_rules.begin(); it != _timed_rules.end(); ) {
+    auto& this_rule = **it;
+
+    if ( this_rule.cancel_requested ) {
+      it = _timed_rules.erase( it );
+      continue;
+    }
 
-        rule_fired = true;
-        RecordScopeTimer<Timer::Category::Nonblock> record_timer {
-          _rule_categories.at( this_rule.category_id ).timer
-        };
-        this_rule.callback();
+    uint8_t iterations = 0;
+    while ( this_rule.deadline() <= Timer::clock_ns() ) {
+      if ( iterations++ >= 128 ) {
+        throw runtime_error( "EventLoop: busy wait detected: timed rule \""
+                             + _rule_categories.at( this_rule.category_id ).name + "\" is still due after "
+                             + to_string( iterations ) + " iterations" );
       }
 
-      if ( rule_fired ) {
-        return Result::Success; /* only serve one rule on each iteration */
+      rule_fired = true;
+      RecordScopeTimer<Timer::Category::Nonblock> record_timer {
+        _rule_categories.at( this_rule.category_id ).timer
+      };
+      this_rule.callback();
+    }
+
+    ++it;
+  }
+
+  return rule_fired;
+}
+
+void EventLoop::arm_timer()
+{
+  uint64_t earliest = numeric_limits<uint64_t>::max();
+  for ( const auto& rule : _timed_rules ) {
+    if ( not rule->cancel_requested ) {
+      earliest = min( earliest, rule->deadline() );
+    }
+  }
+
+  /* zero disarms the timer, so "nothing due" is stored as zero and an actual deadline as at least 1 ns */
+  const uint64_t deadline = earliest == numeric_limits<uint64_t>::max() ? 0 : max( earliest, uint64_t( 1 ) );
+  if ( deadline == _timerfd_deadline ) {
+    return;
+  }
+
+  itimerspec spec {};
+  spec.it_value.tv_sec = deadline / 1'000'000'000;
+  spec.it_value.tv_nsec = deadline % 1'000'000'000;
+  CheckSystemCall( "timerfd_settime", timerfd_settime( _timerfd.fd_num(), TFD_TIMER_ABSTIME, &spec, nullptr ) );
+  _timerfd_deadline = deadline;
+}
+
+void EventLoop::drain_timer()
+{
+  array<char, sizeof( uint64_t )> expirations;
+  _timerfd.read( { expirations.data(), expirations.size() } );
+}
+
+bool EventLoop::run_non_fd_rules()
+{
+  // the non-file-descriptor-related rules come first
+  for ( auto it = _non_fd_rules.begin(); it != _non_fd_rules.end(); ) {
+    auto& this_rule = **it;
+    bool rule_fired = false;
+
+    if ( this_rule.cancel_requested ) {
+      it = _non_fd_rules.erase( it );
+      continue;
+    }
+
+    uint8_t iterations = 0;
+    while ( this_rule.interest() ) {
+      if ( iterations++ >= 128 ) {
+        throw runtime_error( "EventLoop: busy wait detected: rule \""
+                             + _rule_categories.at( this_rule.category_id ).name + "\" is still interested after "
+                             + to_string( iterations ) + " iterations" );
       }
 
-      ++it;
+      rule_fired = true;
+      RecordScopeTimer<Timer::Category::Nonblock> record_timer {
+        _rule_categories.at( this_rule.category_id ).timer
+      };
+      this_rule.callback();
+    }
+
+    if ( rule_fired ) {
+      return true; /* only serve one rule on each iteration */
     }
+
+    ++it;
   }
 
-  // now the file-descriptor-related rules. poll any "interested" file descriptors
+  return false;
+}
+
+EventLoop::Result EventLoop::wait_poll( const int timeout_ms )
+{
+  // poll any "interested" file descriptors
   vector<pollfd> pollfds {};
   pollfds.reserve( _fd_rules.size() );
   bool something_to_poll = false;
@@ -166,6 +321,13 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
     ++it;
   }
 
+  // the timerfd goes last, after one entry per rule
+  const bool timer_polled = _timerfd_deadline != 0;
+  if ( timer_polled ) {
+    pollfds.push_back( { _timerfd.fd_num(), POLLIN, 0 } );
+    something_to_poll = true;
+  }
+
   // quit if there is nothing left to poll
   if ( not something_to_poll ) {
     return Result::Exit;
@@ -179,6 +341,12 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
     }
   }
 
+  // a deadline has passed; the timed rules run at the start of the next call
+  if ( timer_polled and ( pollfds.back().revents & POLLIN ) ) {
+    drain_timer();
+    return Result::Success;
+  }
+
   // go through the poll results
   for ( auto [it, idx] = make_pair( _fd_rules.begin(), size_t( 0 ) ); it != _fd_rules.end(); ++idx ) {
     const auto& this_pollfd = pollfds.at( idx );
@@ -194,21 +362,7 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
         }
       }
 
-      /* see if fd is a socket */
-      int socket_error = 0;
-      socklen_t optlen = sizeof( socket_error );
-      const int ret = getsockopt( this_rule.fd.fd_num(), SOL_SOCKET, SO_ERROR, &socket_error, &optlen );
-      if ( ret == -1 and errno == ENOTSOCK ) {
-        cerr << "error on polled file descriptor for rule \"" << _rule_categories.at( this_rule.category_id ).name
-             << "\"\n";
-      } else if ( ret == -1 ) {
-        throw unix_error( "getsockopt" );
-      } else if ( optlen != sizeof( socket_error ) ) {
-        throw runtime_error( "unexpected length from getsockopt: " + to_string( optlen ) );
-      } else if ( socket_error ) {
-        cerr << "error on polled socket for rule \"" << _rule_categories.at( this_rule.category_id ).name
-             << "\": " << strerror( socket_error ) << "\n";
-      }
+      report_fd_error( this_rule );
 
       this_rule.cancel();
       it = _fd_rules.erase( it );
@@ -249,11 +403,251 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
   return Result::Success;
 }
 
+EventLoop::Result EventLoop::wait_epoll( const int timeout_ms )
+{
+  const bool edge_triggered = _backend == Backend::EpollEdgeTriggered;
+  bool something_to_wait_for = false;
+
+  // forget any rules left queued by a callback that threw
+  for ( FDRule* rule : _ready_rules ) {
+    rule->queued = false;
+    rule->epoll_revents = 0;
+  }
+  _ready_rules.clear();
+
+  // rules whose interest is reported: only those added, served or reported since the last wait
+  epoll_update_reported();
+
+  // rules whose interest is polled: ask each one (this is the per-wakeup cost that reporting avoids)
+  for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) {
+    auto& this_rule = **it;
+
+    if ( this_rule.cancel_requested ) {
+      epoll_unregister( this_rule );
+      it = _fd_rules.erase( it );
+      continue;
+    }
+
+    if ( ( this_rule.direction == Direction::In and this_rule.fd.eof() ) or this_rule.fd.closed() ) {
+      this_rule.cancel();
+      epoll_unregister( this_rule );
+      it = _fd_rules.erase( it );
+      continue;
+    }
+
+    epoll_update( this_rule );
+    something_to_wait_for |= this_rule.interested;
+
+    ++it;
+  }
+
+  // quit if there is nothing left to wait for
+  if ( not something_to_wait_for and _reported_interested == 0 and _timerfd_deadline == 0 ) {
+    return Result::Exit;
+  }
+
+  // wait (without blocking if an edge-triggered rule has not been drained yet)
+  const bool something_still_ready = not _ready_rules.empty();
+  _epoll_events.resize( _fd_rules.size() + _reported_fd_rules.size() + 1 );
+  int num_events;
+  {
+    RecordScopeTimer<Timer::Category::WaitingForEvent> record_timer { _waiting };
+    num_events = CheckSystemCall( "epoll_wait",
+                                  epoll_wait( _epoll->fd_num(),
+                                              _epoll_events.data(),
+                                              _epoll_events.size(),
+                                              something_still_ready ? 0 : timeout_ms ) );
+  }
+
+  if ( num_events == 0 and not something_still_ready ) {
+    return Result::Timeout;
+  }
+
+  // each event leads straight to its rule (the timerfd's event has none)
+  for ( int i = 0; i < num_events; i++ ) {
+    FDRule* const rule = static_cast<FDRule*>( _epoll_events[i].data.ptr );
+    if ( not rule ) {
+      drain_timer(); /* the timed rules run at the start of the next call */
+      continue;
+    }
+
+    rule->epoll_revents = _epoll_events[i].events;
+    if ( not rule->queued ) {
+      rule->queued = true;
+      _ready_rules.push_back( rule );
+    }
+  }
+
+  // serve only the ready rules; any that turn out to be defunct are erased by the next call
+  for ( FDRule* const rule : _ready_rules ) {
+    auto& this_rule = *rule;
+    const uint32_t revents = this_rule.epoll_revents;
+    this_rule.epoll_revents = 0;
+    this_rule.queued = false;
+
+    /* serving a rule may change its interest (or retire it) */
+    if ( this_rule.interest_reported ) {
+      this_rule.report_change();
+    }
+
+    if ( this_rule.cancel_requested ) {
+      continue;
+    }
+
+    if ( revents & EPOLLERR ) {
+      /* recoverable error? */
+      if ( this_rule.recover() ) {
+        continue;
+      }
+
+      report_fd_error( this_rule );
+      epoll_retire( this_rule );
+      continue;
+    }
+
+    const bool ready = revents & static_cast<uint32_t>( this_rule.direction );
+    if ( edge_triggered ) {
+      this_rule.edge_ready |= ready;
+    }
+
+    if ( ( revents & EPOLLHUP ) and this_rule.interested and not this_rule.edge_ready and not ready ) {
+      // same as for poll: a hangup with nothing to read (or no way to write) means this fd is defunct
+      epoll_retire( this_rule );
+      continue;
+    }
+
+    // an earlier callback in this batch may have closed the fd or changed the rule's interest
+    const bool call = edge_triggered ? this_rule.edge_ready : ready;
+    if ( call and not this_rule.fd.closed() and this_rule.interest() ) {
+      RecordScopeTimer<Timer::Category::Nonblock> record_timer {
+        _rule_categories.at( this_rule.category_id ).timer
+      };
+      const auto count_before = this_rule.service_count();
+      this_rule.callback();
+
+      if ( count_before == this_rule.service_count() ) {
+        if ( edge_triggered ) {
+          this_rule.edge_ready = false; /* drained */
+        } else if ( ( not this_rule.fd.closed() ) and this_rule.interest() ) {
+          throw runtime_error( "EventLoop: busy wait detected: rule \""
+                               + _rule_categories.at( this_rule.category_id ).name
+                               + "\" did not read/write fd and is still interested" );
+        }
+      }
+    }
+  }
+  _ready_rules.clear();
+
+  return Result::Success;
+}
+
+//! Ask a rule for its interest, queue it if it is edge-triggered and not yet drained, and bring its
+//! registration up to date (a system call only when its interest has changed)
+void EventLoop::epoll_update( FDRule& rule )
+{
+  const bool edge_triggered = _backend == Backend::EpollEdgeTriggered;
+
+  rule.interested = rule.interest();
+
+  /* edge-triggered: a rule not yet drained is served again without waiting for a new edge */
+  if ( rule.interested and rule.edge_ready ) {
+    rule.queued = true;
+    _ready_rules.push_back( &rule );
+  }
+
+  /* edge-triggered registrations never change; level-triggered ones follow interest (errors always report) */
+  const uint32_t events = edge_triggered ? ( static_cast<uint32_t>( rule.direction ) | EPOLLET )
+                          : rule.interested ? static_cast<uint32_t>( rule.direction )
+                                            : 0;
+
+  if ( not rule.epoll_fd.has_value() ) {
+    /* a private duplicate, so that several rules can watch the same fd */
+    rule.epoll_fd.emplace( CheckSystemCall( "dup", dup( rule.fd.fd_num() ) ) );
+    epoll_event ev {};
+    ev.events = events;
+    ev.data.ptr = &rule;
+    CheckSystemCall( "epoll_ctl", epoll_ctl( _epoll->fd_num(), EPOLL_CTL_ADD, rule.epoll_fd->fd_num(), &ev ) );
+    rule.epoll_events = events;
+  } else if ( events != rule.epoll_events ) {
+    epoll_event ev {};
+    ev.events = events;
+    ev.data.ptr = &rule;
+    CheckSystemCall( "epoll_ctl", epoll_ctl( _epoll->fd_num(), EPOLL_CTL_MOD, rule.epoll_fd->fd_num(), &ev ) );
+    rule.epoll_events = events;
+  }
+}
+
+//! Look at the reported rules queued since the last wait, erasing those cancelled or defunct
+void EventLoop::epoll_update_reported()
+{
+  vector<FDRule*>& changed = *_changed_rules;
+
+  /* a cancel callback may cancel (and so queue) more rules; a rule stays marked queued until it is done with,
+     so it is never queued twice */
+  for ( size_t i = 0; i < changed.size(); i++ ) {
+    FDRule& rule = *changed[i];
+
+    _reported_interested -= rule.interested;
+    rule.interested = false;
+
+    const bool defunct = ( rule.direction == Direction::In and rule.fd.eof() ) or rule.fd.closed();
+    if ( rule.cancel_requested or defunct ) {
+      if ( not rule.cancel_requested ) {
+        rule.cancel();
+      }
+      epoll_unregister( rule );
+      _reported_fd_rules.erase( rule.reported_position );
+      continue;
+    }
+
+    epoll_update( rule );
+    _reported_interested += rule.interested;
+    rule.change_queued = false;
+  }
+
+  changed.clear();
+}
+
+void EventLoop::epoll_unregister( FDRule& rule )
+{
+  if ( rule.epoll_fd.has_value() ) {
+    CheckSystemCall( "epoll_ctl", epoll_ctl( _epoll->fd_num(), EPOLL_CTL_DEL, rule.epoll_fd->fd_num(), nullptr ) );
+    rule.epoll_fd.reset();
+  }
+}
+
+//! Cancel a rule whose fd is defunct, leaving it to be erased before the next wait
+void EventLoop::epoll_retire( FDRule& rule )
+{
+  rule.cancel();
+  epoll_unregister( rule );
+  rule.cancel_requested = true;
+}
+
+void EventLoop::report_fd_error( const FDRule& rule ) const
+{
+  /* see if fd is a socket */
+  int socket_error = 0;
+  socklen_t optlen = sizeof( socket_error );
+  const int ret = getsockopt( rule.fd.fd_num(), SOL_SOCKET, SO_ERROR, &socket_error, &optlen );
+  if ( ret == -1 and errno == ENOTSOCK ) {
+    cerr << "error on polled file descriptor for rule \"" << _rule_categories.at( rule.category_id ).name
+         << "\"\n";
+  } else if ( ret == -1 ) {
+    throw unix_error( "getsockopt" );
+  } else if ( optlen != sizeof( socket_error ) ) {
+    throw runtime_error( "unexpected length from getsockopt: " + to_string( optlen ) );
+  } else if ( socket_error ) {
+    cerr << "error on polled socket for rule \"" << _rule_categories.at( rule.category_id ).name
+         << "\": " << strerror( socket_error ) << "\n";
+  }
+}
+
 void EventLoop::summary( ostream& out ) const
 {
   out << "EventLoop timing summary\n------------------------\n\n";
 
-  auto print_timer = [&]( const string_view name, const Timer::Record timer ) {
+  auto print_timer = [&]( const string_view name, const Timer::Record& timer ) {
     if ( timer.count == 0 ) {
       return;
     }
@@ -267,7 +661,8 @@ void EventLoop::summary( ostream& out ) const
     Timer::pp_ns( out, timer.min_ns );
     out << "..";
     Timer::pp_ns( out, timer.max_ns );
-    out << "]";
+    out << "]  ";
+    timer.print_percentiles( out );
 
     out << " N=" << timer.count;
     out << "\n";
@@ -3,9 +3,12 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <poll.h>
 #include <string_view>
+#include <sys/epoll.h>
+#include <vector>
 
 #include "file_descriptor.hh"
 #include "summarize.hh"
@@ -22,9 +25,36 @@ public:
     Out = POLLOUT //!< Callback will be triggered when Rule::fd is writable.
   };
 
+  //! Returned by each call to EventLoop::wait_next_event.
+  enum class Result
+  {
+    Success, //!< At least one Rule was triggered.
+    Timeout, //!< No rules were triggered before timeout.
+    Exit     //!< All rules have been canceled or were uninterested; make no further calls to
+             //!< EventLoop::wait_next_event.
+  };
+
+  //! How EventLoop::wait_next_event waits for file descriptors.
+  enum class Backend
+  {
+    Poll,                //!< [poll(2)](\ref man2::poll) on every interested fd; one ready rule is served per call.
+    EpollLevelTriggered, //!< Persistent [epoll(7)](\ref man7::epoll) registrations; every ready rule is served.
+    EpollEdgeTriggered   //!< As above, but each ready rule is called until it stops reading/writing its fd.
+                         //!< Callbacks must tolerate being called once more after the fd is drained.
+  };
+
+  //! How EventLoop finds out whether an fd rule is interested.
+  enum class Interest
+  {
+    Polled,  //!< Rule's interest callback is asked before every wait.
+    Reported //!< With epoll, asked only when the rule is added, has just been served, or reports a change
+             //!< with RuleHandle::interest_changed(). A rule whose fd is closed must be cancelled.
+  };
+
 private:
   using CallbackT = std::function<void( void )>;
   using InterestT = std::function<bool( void )>;
+  using DeadlineT = std::function<uint64_t( void )>;
 
   struct RuleCategory
   {
@@ -38,6 +68,7 @@ private:
     InterestT interest;
     CallbackT callback;
     bool cancel_requested;
+    CallbackT report_change {}; //!< Queues a rule whose interest is reported to be looked at before the next wait.
 
     BasicRule( const size_t s_category_id, const InterestT& s_interest, const CallbackT& s_callback );
   };
@@ -58,24 +89,59 @@ private:
     //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
     //! \details This function is used internally by EventLoop; you will not need to call it
     unsigned int service_count() const;
+
+    std::optional<FileDescriptor> epoll_fd {}; //!< Private duplicate of fd registered with epoll.
+    uint32_t epoll_events {};                  //!< Events currently registered for epoll_fd.
+    uint32_t epoll_revents {};                 //!< Events reported by the latest epoll_wait.
+    bool interested {};                        //!< Result of interest() when the wait began.
+    bool edge_ready {};                        //!< Edge-triggered: became ready and not yet drained.
+    bool queued {};                            //!< Already in EventLoop::_ready_rules for this wait.
+
+    bool interest_reported {};                                         //!< Interest::Reported (with epoll).
+    bool change_queued {};                                             //!< Already in EventLoop::_changed_rules.
+    std::list<std::shared_ptr<FDRule>>::iterator reported_position {}; //!< In EventLoop::_reported_fd_rules.
   };
 
+  struct TimedRule : public BasicRule
+  {
+    DeadlineT deadline; //!< When the rule is next due, on the Timer::clock_ns() clock.
+
+    TimedRule( BasicRule&& base, const DeadlineT& s_deadline );
+  };
+
+  Backend _backend;
   std::vector<RuleCategory> _rule_categories;
   std::list<std::shared_ptr<FDRule>> _fd_rules {};
+  std::list<std::shared_ptr<FDRule>> _reported_fd_rules {}; //!< Interest::Reported rules (epoll backends only)
   std::list<std::shared_ptr<BasicRule>> _non_fd_rules {};
+  std::list<std::shared_ptr<TimedRule>> _timed_rules {};
   Timer::Record _waiting {};
 
-public:
-  EventLoop();
+  FileDescriptor _timerfd;        //!< Armed for the earliest deadline among _timed_rules.
+  uint64_t _timerfd_deadline {}; //!< Deadline the timerfd is currently armed for (0 if disarmed).
+
+  std::optional<FileDescriptor> _epoll {};
+  std::vector<epoll_event> _epoll_events {};
+  std::vector<FDRule*> _ready_rules {}; //!< The rules served after epoll_wait (only those with something to do)
+
+  //! Reported rules to look at before the next wait (shared with the rules, which may outlive the loop)
+  std::shared_ptr<std::vector<FDRule*>> _changed_rules { std::make_shared<std::vector<FDRule*>>() };
+  size_t _reported_interested {}; //!< How many reported rules were interested when last asked
+
+  bool run_timed_rules();
+  bool run_non_fd_rules();
+  void arm_timer();
+  void drain_timer();
+  Result wait_poll( const int timeout_ms );
+  Result wait_epoll( const int timeout_ms );
+  void epoll_update( FDRule& rule );
+  void epoll_update_reported();
+  void epoll_unregister( FDRule& rule );
+  void epoll_retire( FDRule& rule );
+  void report_fd_error( const FDRule& rule ) const;
 
-  //! Returned by each call to EventLoop::wait_next_event.
-  enum class Result
-  {
-    Success, //!< At least one Rule was triggered.
-    Timeout, //!< No rules were triggered before timeout.
-    Exit     //!< All rules have been canceled or were uninterested; make no further calls to
-             //!< EventLoop::wait_next_event.
-  };
+public:
+  explicit EventLoop( const Backend backend = Backend::Poll );
 
   size_t add_category( const std::string& name );
 
@@ -90,6 +156,9 @@ public:
     {}
 
     void cancel();
+
+    //! For a rule added with Interest::Reported: its interest may have changed, so ask again before the next wait
+    void interest_changed();
   };
 
   RuleHandle add_rule(
@@ -101,11 +170,31 @@ public:
     const CallbackT& cancel = [] {},
     const InterestT& recover = [] { return false; } );
 
+  RuleHandle add_rule(
+    const size_t category_id,
+    const Interest interest_mode,
+    const FileDescriptor& fd,
+    const Direction direction,
+    const CallbackT& callback,
+    const InterestT& interest = [] { return true; },
+    const CallbackT& cancel = [] {},
+    const InterestT& recover = [] { return false; } );
+
   RuleHandle add_rule(
     const size_t category_id,
     const CallbackT& callback,
     const InterestT& interest = [] { return true; } );
 
+  //! \brief Add a rule whose callback runs once the Timer::clock_ns() clock reaches `deadline()`.
+  //! \details The loop sleeps on a [timerfd](\ref man2::timerfd_create) until the earliest deadline, so timed
+  //! rules need no short wait_next_event timeout. The callback is expected to move the deadline forward.
+  RuleHandle add_timed_rule( const size_t category_id, const CallbackT& callback, const DeadlineT& deadline );
+
+  RuleHandle add_timed_rule( const std::string& name, const CallbackT& callback, const DeadlineT& deadline )
+  {
+    return add_timed_rule( add_category( name ), callback, deadline );
+  }
+
   //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
   Result wait_next_event( const int timeout_ms );
 
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+//! Log-bucketed histogram of durations, in the style of HdrHistogram
+//! \details Each power of two is split into 16 linear sub-buckets, so a percentile is reported within 1/16
+//! of its true value. Logging a value costs a count-leading-zeros, a shift and an increment.
+class LatencyHistogram
+{
+  static constexpr unsigned int SUB_BUCKET_BITS = 4;
+  static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+  /* values of 2^40 ns (about 18 minutes) and up share the last bucket */
+  static constexpr unsigned int MAX_MAGNITUDE = 40;
+  static constexpr size_t NUM_BUCKETS = ( MAX_MAGNITUDE - SUB_BUCKET_BITS + 2 ) * SUB_BUCKETS;
+
+  std::array<uint64_t, NUM_BUCKETS> counts_ {};
+  uint64_t count_ {};
+
+  static size_t bucket_of( const uint64_t value )
+  {
+    const unsigned int magnitude = 63 - __builtin_clzll( value | 1 );
+    if ( magnitude < SUB_BUCKET_BITS ) {
+      return value;
+    }
+    if ( magnitude > MAX_MAGNITUDE ) {
+      return NUM_BUCKETS - 1;
+    }
+
+    const unsigned int shift = magnitude - SUB_BUCKET_BITS;
+    return ( shift + 1 ) * SUB_BUCKETS + ( ( value >> shift ) & ( SUB_BUCKETS - 1 ) );
+  }
+
+  /* the largest value that lands in a bucket */
+  static uint64_t highest_value_in( const size_t bucket )
+  {
+    if ( bucket < SUB_BUCKETS ) {
+      return bucket;
+    }
+
+    const unsigned int shift = bucket / SUB_BUCKETS - 1;
+    const uint64_t lowest = ( SUB_BUCKETS + bucket % SUB_BUCKETS ) << shift;
+    return lowest + ( uint64_t( 1 ) << shift ) - 1;
+  }
+
+public:
+  void log( const uint64_t value )
+  {
+    counts_[bucket_of( value )]++;
+    count_++;
+  }
+
+  //! The smallest bucket bound at or above `fraction` of the logged values (e.g. 0.99 for p99)
+  uint64_t percentile( const double fraction ) const
+  {
+    if ( count_ == 0 ) {
+      return 0;
+    }
+
+    const uint64_t rank = std::max( uint64_t( 1 ), uint64_t( std::ceil( fraction * count_ ) ) );
+    uint64_t seen = 0;
+    for ( size_t bucket = 0; bucket < NUM_BUCKETS; bucket++ ) {
+      seen += counts_[bucket];
+      if ( seen >= rank ) {
+        return highest_value_in( bucket );
+      }
+    }
+
+    return highest_value_in( NUM_BUCKETS - 1 );
+  }
+
+  uint64_t count() const { return count_; }
+
+  void reset()
+  {
+    counts_.fill( 0 );
+    count_ = 0;
+  }
+};
@@ -4,10 +4,83 @@
 #include <cstring>
 #include <iostream>
 #include <string>
+#include <type_traits>
 
 #include "exception.hh"
 #include "spans.hh"
 
+//! Wire encoding of fixed-size fields: integers big-endian, floating-point in host order
+namespace wire {
+
+template<size_t size>
+struct unsigned_of_size;
+template<>
+struct unsigned_of_size<1>
+{
+  using type = uint8_t;
+};
+template<>
+struct unsigned_of_size<2>
+{
+  using type = uint16_t;
+};
+template<>
+struct unsigned_of_size<4>
+{
+  using type = uint32_t;
+};
+template<>
+struct unsigned_of_size<8>
+{
+  using type = uint64_t;
+};
+
+//! Bytes on the wire for a sequence of fixed-size fields
+template<typename... Ts>
+constexpr size_t size_of = ( sizeof( Ts ) + ... + 0 );
+
+template<typename U>
+U to_big_endian( const U x )
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if constexpr ( sizeof( U ) == 8 ) {
+    return __builtin_bswap64( x );
+  } else if constexpr ( sizeof( U ) == 4 ) {
+    return __builtin_bswap32( x );
+  } else if constexpr ( sizeof( U ) == 2 ) {
+    return __builtin_bswap16( x );
+  }
+#endif
+  return x;
+}
+
+/* the caller has checked that there is room */
+template<typename T>
+void load( const char* in, T& out )
+{
+  if constexpr ( std::is_floating_point_v<T> ) {
+    memcpy( &out, in, sizeof( T ) );
+  } else {
+    typename unsigned_of_size<sizeof( T )>::type x;
+    memcpy( &x, in, sizeof( x ) );
+    out = static_cast<T>( to_big_endian( x ) );
+  }
+}
+
+template<typename T>
+void store( char* out, const T& val )
+{
+  if constexpr ( std::is_floating_point_v<T> ) {
+    memcpy( out, &val, sizeof( T ) );
+  } else {
+    using U = typename unsigned_of_size<sizeof( T )>::type;
+    const U x = to_big_endian( static_cast<U>( val ) );
+    memcpy( out, &x, sizeof( x ) );
+  }
+}
+
+}
+
 class Parser
 {
   bool error_ {};
@@ -41,18 +114,23 @@ public:
   template<typename T>
   void integer( T& out )
   {
-    check_size( sizeof( T ) );
+    static_assert( std::is_integral_v<T> );
+    fixed( out );
+  }
+
+  //! Parse a run of fixed-size fields (integers and floating-point) with a single length check
+  template<typename... Ts>
+  void fixed( Ts&... out )
+  {
+    constexpr size_t len = wire::size_of<Ts...>;
+    check_size( len );
     if ( error() ) {
       return;
     }
 
-    out = static_cast<T>( 0 );
-    for ( size_t i = 0; i < sizeof( T ); i++ ) {
-      out <<= 8;
-      out += uint8_t( input_.at( i ) );
-    }
-
-    input_.remove_prefix( sizeof( T ) );
+    const char* in = input_.data();
+    ( ( wire::load( in, out ), in += sizeof( Ts ) ), ... );
+    input_.remove_prefix( len );
   }
 
   template<typename T>
@@ -109,13 +187,20 @@ public:
   template<typename T>
   void integer( const T& val )
   {
-    constexpr size_t len = sizeof( T );
+    static_assert( std::is_integral_v<T> );
+    fixed( val );
+  }
+
+  //! Serialize a run of fixed-size fields (integers and floating-point) with a single length check
+  template<typename... Ts>
+  void fixed( const Ts&... vals )
+  {
+    constexpr size_t len = wire::size_of<Ts...>;
     check_size( len );
 
-    for ( size_t i = 0; i < len; ++i ) {
-      *output_.mutable_data() = ( val >> ( ( len - i - 1 ) * 8 ) ) & 0xff;
-      output_.remove_prefix( 1 );
-    }
+    char* out = output_.mutable_data();
+    ( ( wire::store( out, vals ), out += sizeof( Ts ) ), ... );
+    output_.remove_prefix( len );
   }
 
   template<typename T>
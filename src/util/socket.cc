@@ -2,6 +2,7 @@
 
 #include "exception.hh"
 
+#include <array>
 #include <cstddef>
 #include <netinet/tcp.h>
 #include <stdexcept>
@@ -136,6 +137,77 @@ void UDPSocket::send( const string_view payload )
   register_write();
 }
 
+size_t UDPSocket::recv_batch( span<Address> source_addresses, span<string_span> payloads )
+{
+  if ( source_addresses.size() != payloads.size() ) {
+    throw runtime_error( "UDPSocket::recv_batch: mismatched addresses and payloads" );
+  }
+
+  const size_t count = min( payloads.size(), max_batch );
+
+  array<Address::Raw, max_batch> datagram_source_addresses;
+  array<iovec, max_batch> iovecs;
+  array<mmsghdr, max_batch> headers;
+
+  for ( size_t i = 0; i < count; i++ ) {
+    iovecs[i] = { payloads[i].mutable_data(), payloads[i].size() };
+    headers[i] = {};
+    headers[i].msg_hdr.msg_name = static_cast<sockaddr*>( datagram_source_addresses[i] );
+    headers[i].msg_hdr.msg_namelen = sizeof( datagram_source_addresses[i] );
+    headers[i].msg_hdr.msg_iov = &iovecs[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  const int num_received = ::recvmmsg( fd_num(), headers.data(), count, MSG_DONTWAIT, nullptr );
+  register_read();
+  if ( num_received < 0 and ( errno == EAGAIN or errno == EWOULDBLOCK ) ) {
+    return 0;
+  }
+  CheckSystemCall( "recvmmsg", num_received );
+
+  for ( int i = 0; i < num_received; i++ ) {
+    if ( headers[i].msg_hdr.msg_flags & MSG_TRUNC ) {
+      throw runtime_error( "recvmmsg (oversized datagram)" );
+    }
+
+    source_addresses[i] = { datagram_source_addresses[i], headers[i].msg_hdr.msg_namelen };
+    payloads[i] = payloads[i].substr( 0, headers[i].msg_len );
+  }
+
+  return num_received;
+}
+
+void UDPSocket::sendto_batch( const span_view<Address> destinations, const span_view<string_view> payloads )
+{
+  if ( destinations.size() != payloads.size() ) {
+    throw runtime_error( "UDPSocket::sendto_batch: mismatched destinations and payloads" );
+  }
+
+  array<iovec, max_batch> iovecs;
+  array<mmsghdr, max_batch> headers;
+
+  size_t sent = 0;
+  while ( sent < payloads.size() ) {
+    const size_t count = min( payloads.size() - sent, max_batch );
+
+    for ( size_t i = 0; i < count; i++ ) {
+      const Address& destination = destinations[sent + i];
+      const string_view payload = payloads[sent + i];
+
+      iovecs[i] = { const_cast<char*>( payload.data() ), payload.size() };
+      headers[i] = {};
+      headers[i].msg_hdr.msg_name = const_cast<sockaddr*>( static_cast<const sockaddr*>( destination ) );
+      headers[i].msg_hdr.msg_namelen = destination.size();
+      headers[i].msg_hdr.msg_iov = &iovecs[i];
+      headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    /* a partial send means the next datagram failed; retrying from there reports its error */
+    sent += CheckSystemCall( "sendmmsg", ::sendmmsg( fd_num(), headers.data(), count, 0 ) );
+    register_write();
+  }
+}
+
 void UnixDatagramSocket::sendto_ignore_errors( const Address& destination, const std::string_view payload )
 {
   ::sendto( fd_num(), payload.data(), payload.length(), 0, destination, destination.size() );
@@ -78,6 +78,18 @@ public:
 
   //! Send datagram to the socket's connected address (must call connect() first)
   void send( const std::string_view payload );
+
+  //! Largest number of datagrams handed to the kernel in one batched system call
+  static constexpr size_t max_batch = 64;
+
+  //! \brief Receive up to `payloads.size()` datagrams with one [recvmmsg(2)](\ref man2::recvmmsg)
+  //! \details Datagram i is written into payloads[i], which is trimmed to the datagram's length, and its
+  //! sender is stored in source_addresses[i]. Does not wait for more than are already queued.
+  //! \returns the number of datagrams received (possibly zero)
+  size_t recv_batch( span<Address> source_addresses, span<string_span> payloads );
+
+  //! Send payloads[i] to destinations[i] for each i, with one [sendmmsg(2)](\ref man2::sendmmsg) per max_batch
+  void sendto_batch( const span_view<Address> destinations, const span_view<std::string_view> payloads );
 };
 
 class UnixDatagramSocket : public Socket
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+
+#include "typed_ring_buffer.hh"
+
+//! A TypedRingBuffer that one thread may push to while another thread pops from, without locking
+//! \details The producer thread may only call writable_region() and push(); the consumer thread may only call
+//! readable_region() and pop(). Because the storage is mirrored, both regions are always contiguous.
+template<typename T>
+class SPSCRingBuffer : public TypedRingStorage<T>
+{
+  static_assert( std::is_trivially_copyable_v<T> );
+
+  /* each counter is written by only one side; keep them on separate cache lines */
+  alignas( 64 ) std::atomic<size_t> num_pushed_ {};
+  alignas( 64 ) std::atomic<size_t> num_popped_ {};
+
+public:
+  using TypedRingStorage<T>::TypedRingStorage;
+  using TypedRingStorage<T>::capacity;
+
+  //! \name Producer side
+  //!@{
+  span<T> writable_region()
+  {
+    const size_t pushed = num_pushed_.load( std::memory_order_relaxed );
+    const size_t popped = num_popped_.load( std::memory_order_acquire );
+    return TypedRingStorage<T>::mutable_storage( pushed % capacity() )
+      .substr( 0, capacity() - ( pushed - popped ) );
+  }
+
+  void push( const size_t num_elems )
+  {
+    const size_t pushed = num_pushed_.load( std::memory_order_relaxed );
+    if ( pushed + num_elems - num_popped_.load( std::memory_order_acquire ) > capacity() ) {
+      throw std::runtime_error( "SPSCRingBuffer::push exceeded size of writable region" );
+    }
+
+    num_pushed_.store( pushed + num_elems, std::memory_order_release );
+  }
+  //!@}
+
+  //! \name Consumer side
+  //!@{
+  span_view<T> readable_region() const
+  {
+    const size_t popped = num_popped_.load( std::memory_order_relaxed );
+    const size_t pushed = num_pushed_.load( std::memory_order_acquire );
+    return TypedRingStorage<T>::storage( popped % capacity() ).substr( 0, pushed - popped );
+  }
+
+  void pop( const size_t num_elems )
+  {
+    const size_t popped = num_popped_.load( std::memory_order_relaxed );
+    if ( popped + num_elems > num_pushed_.load( std::memory_order_acquire ) ) {
+      throw std::runtime_error( "SPSCRingBuffer::pop exceeded size of readable region" );
+    }
+
+    num_popped_.store( popped + num_elems, std::memory_order_release );
+  }
+  //!@}
+
+  size_t num_pushed() const { return num_pushed_.load( std::memory_order_acquire ); }
+  size_t num_popped() const { return num_popped_.load( std::memory_order_acquire ); }
+};
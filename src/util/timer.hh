@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <iomanip>
 #include <optional>
@@ -8,12 +9,17 @@
 #include <string>
 #include <type_traits>
 
+#include "latency_histogram.hh"
+
 constexpr double THOUSAND = 1000.0;
 constexpr double MILLION = 1000000.0;
 constexpr double BILLION = 1000000000.0;
 
 class Timer
 {
+  /* zero when the real clock is in use */
+  static inline std::atomic<uint64_t> virtual_clock_ns_ {};
+
 public:
   static inline uint64_t timestamp_ns()
   {
@@ -22,6 +28,20 @@ public:
     return std::chrono::steady_clock::now().time_since_epoch().count();
   }
 
+  //! The time that deadlines and timeouts are measured against: timestamp_ns(), unless a virtual clock is set.
+  //! \details Durations that measure work (phase times, rule timers) keep using timestamp_ns().
+  static inline uint64_t clock_ns()
+  {
+    const uint64_t virtual_now = virtual_clock_ns_.load( std::memory_order_relaxed );
+    return virtual_now ? virtual_now : timestamp_ns();
+  }
+
+  //! Freeze clock_ns() at `now_ns` (nonzero) until the next call, for deterministic tests
+  static void set_virtual_clock( const uint64_t now_ns ) { virtual_clock_ns_.store( now_ns ); }
+
+  //! Return clock_ns() to the real clock
+  static void clear_virtual_clock() { virtual_clock_ns_.store( 0 ); }
+
   static void pp_ns( std::ostream& out, const uint64_t duration_ns )
   {
     out << std::fixed << std::setprecision( 1 ) << std::setw( 5 ) << std::setfill( ' ' );
@@ -43,6 +63,7 @@ public:
     uint64_t total_ns;
     uint64_t max_ns;
     uint64_t min_ns = std::numeric_limits<uint64_t>::max();
+    LatencyHistogram histogram {};
 
     void log( const uint64_t time_ns )
     {
@@ -50,12 +71,31 @@ public:
       total_ns += time_ns;
       max_ns = std::max( max_ns, time_ns );
       min_ns = std::min( min_ns, time_ns );
+      histogram.log( time_ns );
     }
 
     void reset()
     {
       count = total_ns = max_ns = 0;
       min_ns = std::numeric_limits<uint64_t>::max();
+      histogram.reset();
+    }
+
+    //! e.g. percentile_ns( 0.99 ) for p99 (an upper bound within 1/16, but never above max_ns)
+    uint64_t percentile_ns( const double fraction ) const
+    {
+      return std::min( histogram.percentile( fraction ), max_ns );
+    }
+
+    //! Print "p50=... p99=... p99.9=..."
+    void print_percentiles( std::ostream& out ) const
+    {
+      out << "p50=";
+      pp_ns( out, percentile_ns( 0.5 ) );
+      out << " p99=";
+      pp_ns( out, percentile_ns( 0.99 ) );
+      out << " p99.9=";
+      pp_ns( out, percentile_ns( 0.999 ) );
     }
   };
 
@@ -105,9 +145,10 @@ public:
   void summary( std::ostream& out ) const;
 };
 
+//! Each thread has its own global timer, so that a thread may run its own EventLoop
 inline Timer& global_timer()
 {
-  static Timer the_global_timer;
+  static thread_local Timer the_global_timer;
   return the_global_timer;
 }
 
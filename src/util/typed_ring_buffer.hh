@@ -164,4 +164,26 @@ public:
 
     EndlessBuffer<T>::region( pos, 1 ).at( 0 ) = val;
   }
+
+  //! Copy the values starting at `pos` into `out`, with T {} for any outside the stored range
+  void safe_get_region( const size_t pos, span<T> out ) const
+  {
+    std::fill( out.begin(), out.end(), T {} );
+
+    const size_t begin = std::max( pos, EndlessBuffer<T>::range_begin() );
+    const size_t end = std::min( pos + out.size(), EndlessBuffer<T>::range_end() );
+    if ( begin < end ) {
+      out.substr( begin - pos, end - begin ).copy( EndlessBuffer<T>::region( begin, end - begin ) );
+    }
+  }
+
+  //! Store `values` starting at `pos`, dropping any that fall outside the stored range
+  void safe_set_region( const size_t pos, const span_view<T> values )
+  {
+    const size_t begin = std::max( pos, EndlessBuffer<T>::range_begin() );
+    const size_t end = std::min( pos + values.size(), EndlessBuffer<T>::range_end() );
+    if ( begin < end ) {
+      EndlessBuffer<T>::region( begin, end - begin ).copy( values.substr( begin - pos, end - begin ) );
+    }
+  }
 };
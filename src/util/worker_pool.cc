@@ -0,0 +1,166 @@
+#include "worker_pool.hh"
+#include "exception.hh"
+
+#include <pthread.h>
+#include <sched.h>
+
+using namespace std;
+
+WorkerPool::WorkerPool( const size_t num_threads )
+  : shares_( num_threads + 1 )
+{
+  /* the CPUs this process may run on */
+  cpu_set_t allowed;
+  CPU_ZERO( &allowed );
+  CheckSystemCall( "sched_getaffinity", sched_getaffinity( 0, sizeof( allowed ), &allowed ) );
+
+  vector<int> cpus;
+  for ( int cpu = 0; cpu < CPU_SETSIZE; cpu++ ) {
+    if ( CPU_ISSET( cpu, &allowed ) ) {
+      cpus.push_back( cpu );
+    }
+  }
+
+  threads_.reserve( num_threads );
+  try {
+    for ( size_t i = 0; i < num_threads; i++ ) {
+      threads_.emplace_back( [this, i] { worker_loop( i + 1 ); } );
+
+      /* keep the workers off the first allowed CPU, so the calling thread (which is not pinned, since threads
+         it creates later would inherit its affinity) usually finds it idle */
+      if ( not cpus.empty() ) {
+        cpu_set_t one_cpu;
+        CPU_ZERO( &one_cpu );
+        CPU_SET( cpus.at( ( i + 1 ) % cpus.size() ), &one_cpu );
+        const int ret = pthread_setaffinity_np( threads_.back().native_handle(), sizeof( one_cpu ), &one_cpu );
+        if ( ret ) {
+          throw unix_error( "pthread_setaffinity_np", ret );
+        }
+      }
+    }
+  } catch ( ... ) {
+    stop();
+    throw;
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  stop();
+}
+
+void WorkerPool::stop()
+{
+  {
+    lock_guard<mutex> lock { mutex_ };
+    exiting_ = true;
+  }
+  batch_ready_.notify_all();
+
+  for ( auto& thread : threads_ ) {
+    thread.join();
+  }
+}
+
+void WorkerPool::drain( const size_t share_index )
+{
+  /* own share first, then steal from the others in turn */
+  for ( size_t i = 0; i < shares_.size(); i++ ) {
+    const size_t victim = ( share_index + i ) % shares_.size();
+    Share& share = shares_[victim];
+
+    while ( true ) {
+      const size_t task_index = share.next.fetch_add( 1, memory_order_relaxed );
+      if ( task_index >= share.end ) {
+        break;
+      }
+
+      if ( victim != share_index ) {
+        stats_.stolen.fetch_add( 1, memory_order_relaxed );
+      }
+
+      try {
+        ( *task_ )( task_index );
+      } catch ( ... ) {
+        lock_guard<mutex> lock { mutex_ };
+        if ( not exception_ ) {
+          exception_ = current_exception();
+        }
+      }
+    }
+  }
+}
+
+void WorkerPool::worker_loop( const size_t share_index )
+{
+  uint64_t last_batch = 0;
+
+  while ( true ) {
+    {
+      unique_lock<mutex> lock { mutex_ };
+      batch_ready_.wait( lock, [&] { return exiting_ or batch_number_ != last_batch; } );
+      if ( exiting_ ) {
+        return;
+      }
+      last_batch = batch_number_;
+    }
+
+    drain( share_index );
+
+    {
+      lock_guard<mutex> lock { mutex_ };
+      if ( --workers_busy_ == 0 ) {
+        batch_done_.notify_one();
+      }
+    }
+  }
+}
+
+void WorkerPool::run( const size_t num_tasks, const Task& task )
+{
+  if ( num_tasks == 0 ) {
+    return;
+  }
+
+  /* split the indices into one contiguous share per thread */
+  {
+    lock_guard<mutex> lock { mutex_ };
+    for ( size_t i = 0; i < shares_.size(); i++ ) {
+      shares_[i].next.store( num_tasks * i / shares_.size(), memory_order_relaxed );
+      shares_[i].end = num_tasks * ( i + 1 ) / shares_.size();
+    }
+    task_ = &task;
+    exception_ = nullptr;
+    workers_busy_ = threads_.size();
+    batch_number_++;
+  }
+  batch_ready_.notify_all();
+
+  drain( 0 );
+
+  /* barrier: every worker has finished with this batch before any share is reused */
+  {
+    unique_lock<mutex> lock { mutex_ };
+    batch_done_.wait( lock, [&] { return workers_busy_ == 0; } );
+    task_ = nullptr;
+  }
+
+  stats_.batches++;
+  stats_.tasks += num_tasks;
+
+  if ( exception_ ) {
+    rethrow_exception( exception_ );
+  }
+}
+
+void WorkerPool::summary( ostream& out ) const
+{
+  out << "worker pool: " << threads_.size() << " threads + caller, batches=" << stats_.batches
+      << " tasks=" << stats_.tasks << " stolen=" << stats_.stolen.load( memory_order_relaxed ) << "\n";
+}
+
+void WorkerPool::reset_summary()
+{
+  stats_.batches = stats_.tasks = 0;
+  stats_.stolen.store( 0, memory_order_relaxed );
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+//! Runs batches of independent tasks on a fixed set of threads, each pinned to its own CPU.
+//! \details The calling thread takes part in every batch, but is left unpinned. Each thread starts on its own contiguous share
+//! of the task indices and steals from the others' shares once it runs out, so a given task index tends
+//! to run on the same thread (with warm caches) from one batch to the next.
+class WorkerPool
+{
+public:
+  using Task = std::function<void( const size_t task_index )>;
+
+private:
+  struct alignas( 64 ) Share
+  {
+    std::atomic<size_t> next {};
+    size_t end {};
+  };
+
+  std::vector<Share> shares_;
+  std::vector<std::thread> threads_ {};
+
+  std::mutex mutex_ {};
+  std::condition_variable batch_ready_ {}, batch_done_ {};
+  uint64_t batch_number_ {};
+  size_t workers_busy_ {};
+  bool exiting_ {};
+
+  const Task* task_ {};
+  std::exception_ptr exception_ {};
+
+  struct Statistics
+  {
+    uint64_t batches, tasks;
+    std::atomic<uint64_t> stolen;
+  } stats_ {};
+
+  void worker_loop( const size_t share_index );
+  void stop();
+  void drain( const size_t share_index );
+
+public:
+  //! \param[in] num_threads is the number of threads in addition to the caller (zero runs everything inline)
+  explicit WorkerPool( const size_t num_threads );
+  ~WorkerPool();
+
+  //! Call task(i) for each i in [0, num_tasks), returning once all have finished
+  //! \details If any task throws, the first exception is rethrown here after the batch completes.
+  void run( const size_t num_tasks, const Task& task );
+
+  size_t num_threads() const { return threads_.size(); }
+
+  void summary( std::ostream& out ) const;
+  void reset_summary();
+
+  WorkerPool( const WorkerPool& other ) = delete;
+  WorkerPool& operator=( const WorkerPool& other ) = delete;
+};
@@ -132,12 +132,8 @@ Camera::~Camera()
   CheckSystemCall( "stream off", ioctl( camera_fd_.fd_num(), VIDIOC_STREAMOFF, &capture_type ) );
 }
 
-void Camera::get_next_frame( RasterYUV422& raster )
+v4l2_buffer Camera::dequeue_buffer()
 {
-  if ( raster.width() != width_ or raster.height() != height_ ) {
-    throw runtime_error( "Camera::get_next_frame: mismatched raster size" );
-  }
-
   v4l2_buffer buffer_info;
   buffer_info.type = capture_type;
   buffer_info.memory = V4L2_MEMORY_MMAP;
@@ -147,6 +143,22 @@ void Camera::get_next_frame( RasterYUV422& raster )
   CheckSystemCall( "dequeue buffer", ioctl( camera_fd_.fd_num(), VIDIOC_DQBUF, &buffer_info ) );
   camera_fd_.buffer_dequeued();
 
+  return buffer_info;
+}
+
+void Camera::enqueue_buffer( v4l2_buffer& buffer_info )
+{
+  CheckSystemCall( "enqueue buffer", ioctl( camera_fd_.fd_num(), VIDIOC_QBUF, &buffer_info ) );
+
+  next_buffer_index = ( next_buffer_index + 1 ) % NUM_BUFFERS;
+}
+
+/* the JPEG is decoded straight from the kernel's buffer, which is requeued as soon as it has been read */
+template<class RasterType>
+void Camera::decode_next_frame( RasterType& raster )
+{
+  v4l2_buffer buffer_info = dequeue_buffer();
+
   if ( buffer_info.bytesused > 2048 and not( buffer_info.flags & V4L2_BUF_FLAG_ERROR ) ) {
     const MMap_Region& mmap_region = kernel_v4l2_buffers_.at( next_buffer_index );
 
@@ -162,9 +174,7 @@ void Camera::get_next_frame( RasterYUV422& raster )
     frame_count_++;
   }
 
-  CheckSystemCall( "enqueue buffer", ioctl( camera_fd_.fd_num(), VIDIOC_QBUF, &buffer_info ) );
-
-  next_buffer_index = ( next_buffer_index + 1 ) % NUM_BUFFERS;
+  enqueue_buffer( buffer_info );
 
   if ( jpegdec_.bad() ) {
     cerr << "Restarting Camera for " << device_name_ << "... ";
@@ -174,3 +184,30 @@ void Camera::get_next_frame( RasterYUV422& raster )
     cerr << "done.\n";
   }
 }
+
+void Camera::get_next_frame( RasterYUV422& raster )
+{
+  if ( raster.width() != width_ or raster.height() != height_ ) {
+    throw runtime_error( "Camera::get_next_frame: mismatched raster size" );
+  }
+
+  decode_next_frame( raster );
+}
+
+void Camera::get_next_frame( RasterYUV420& raster )
+{
+  for ( const unsigned int reduction : { 1, 2, 4 } ) {
+    if ( raster.width() * reduction == width_ and raster.height() * reduction == height_ ) {
+      decode_next_frame( raster );
+      return;
+    }
+  }
+
+  throw runtime_error( "Camera::get_next_frame: mismatched raster size" );
+}
+
+void Camera::skip_next_frame()
+{
+  v4l2_buffer buffer_info = dequeue_buffer();
+  enqueue_buffer( buffer_info );
+}
@@ -60,6 +60,12 @@ private:
 
   void init();
 
+  v4l2_buffer dequeue_buffer();
+  void enqueue_buffer( v4l2_buffer& buffer_info );
+
+  template<class RasterType>
+  void decode_next_frame( RasterType& raster );
+
   unsigned int frame_count_ {};
 
 public:
@@ -69,5 +75,12 @@ public:
 
   void get_next_frame( RasterYUV422& raster );
 
+  //! Decode the next frame straight to 4:2:0, at the camera's size or reduced by a factor of 2 or 4 in the
+  //! decoder (the raster's size picks which)
+  void get_next_frame( RasterYUV420& raster );
+
+  //! Take the next frame from the device without decoding it (when there is nowhere to put it)
+  void skip_next_frame();
+
   FileDescriptor& fd() { return camera_fd_; }
 };
@@ -7,6 +7,18 @@
 
 using namespace std;
 
+bool contains_idr_slice( const string_view access_unit )
+{
+  /* NAL unit type 5 follows a start code */
+  for ( size_t pos = access_unit.find( "\x00\x00\x01"sv ); pos != string_view::npos;
+        pos = access_unit.find( "\x00\x00\x01"sv, pos + 3 ) ) {
+    if ( pos + 3 < access_unit.size() and ( access_unit[pos + 3] & 0x1f ) == 5 ) {
+      return true;
+    }
+  }
+  return false;
+}
+
 H264Decoder::H264Decoder()
   : codec_( notnull( "avcodec_find_decoder", avcodec_find_decoder( AV_CODEC_ID_H264 ) ) )
   , context_( notnull( "avcodec_alloc_context3", avcodec_alloc_context3( codec_ ) ) )
@@ -40,9 +52,15 @@ bool H264Decoder::decode( const span_view<uint8_t> nal, RasterYUV420& output )
     return false;
   }
 
-  memcpy( output.Y_row( 0 ), frame_.frame->data[0], output.width() * output.height() );
-  memcpy( output.Cb_row( 0 ), frame_.frame->data[1], output.chroma_width() * output.chroma_height() );
-  memcpy( output.Cr_row( 0 ), frame_.frame->data[2], output.chroma_width() * output.chroma_height() );
+  /* each side's rows may be padded differently */
+  const AVFrame& frame = *frame_.frame;
+  for ( uint16_t y = 0; y < output.height(); y++ ) {
+    memcpy( output.Y_row( y ), frame.data[0] + y * frame.linesize[0], output.width() );
+  }
+  for ( uint16_t y = 0; y < output.chroma_height(); y++ ) {
+    memcpy( output.Cb_row( y ), frame.data[1] + y * frame.linesize[1], output.chroma_width() );
+    memcpy( output.Cr_row( y ), frame.data[2] + y * frame.linesize[2], output.chroma_width() );
+  }
 
   return true;
 }
@@ -5,6 +5,7 @@
 #include "spans.hh"
 
 #include <memory>
+#include <string_view>
 
 extern "C"
 {
@@ -15,13 +16,10 @@ struct FrameWrapper
 {
   AVFrame* frame;
 
+  /* the decoder supplies the frame's buffers (from its own pool) when a picture is received */
   FrameWrapper()
     : frame( notnull( "av_frame_alloc", av_frame_alloc() ) )
-  {
-    frame->buf[0] = av_buffer_alloc( 1024 * 1024 );
-    frame->buf[1] = av_buffer_alloc( 1024 * 1024 );
-    frame->buf[2] = av_buffer_alloc( 1024 * 1024 );
-  }
+  {}
 
   ~FrameWrapper()
   {
@@ -40,6 +38,9 @@ struct FrameWrapper
   }
 };
 
+//! Whether an access unit (in Annex B format) holds a slice of an IDR picture, which needs no earlier pictures
+bool contains_idr_slice( const std::string_view access_unit );
+
 class H264Decoder
 {
   AVCodec* codec_;
@@ -0,0 +1,134 @@
+#include "h264_decoder_task.hh"
+#include "eventloop.hh"
+
+#include <cstring>
+
+using namespace std;
+
+H264DecoderTask::H264DecoderTask( RasterPool<RasterYUV420>& rasters )
+  : rasters_( rasters )
+{
+  for ( unsigned int i = 0; i < 3; i++ ) {
+    pictures_.push_back( rasters_.take() );
+  }
+
+  for ( Handle i = 0; i < NUM_NALS; i++ ) {
+    free_nals_.writable_region().at( 0 ) = i;
+    free_nals_.push( 1 );
+  }
+
+  thread_ = thread( [&] { decoder_thread_main(); } );
+}
+
+H264DecoderTask::~H264DecoderTask()
+{
+  stopping_ = true;
+  stop_requested_.notify();
+  thread_.join();
+
+  for ( auto& picture : pictures_ ) {
+    rasters_.recycle( move( picture ) );
+  }
+}
+
+void H264DecoderTask::decoder_thread_main()
+{
+  try {
+    EventLoop loop;
+
+    loop.add_rule( "decode", nal_queued_, Direction::In, [&] {
+      nal_queued_.drain();
+      decode_queued_nals();
+    } );
+
+    loop.add_rule( "stop", stop_requested_, Direction::In, [] {} );
+
+    while ( not stopping_ and loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {
+    }
+  } catch ( ... ) {
+    /* hand the exception to the EventLoop thread, which rethrows it with the next NAL */
+    {
+      lock_guard<mutex> lock { failure_mutex_ };
+      exception_ = current_exception();
+    }
+    failed_.store( true, memory_order_release );
+  }
+}
+
+void H264DecoderTask::decode_queued_nals()
+{
+  const span_view<Handle> queued = queued_nals_.readable_region();
+
+  for ( size_t i = 0; i < queued.size(); i++ ) {
+    const QueuedNAL& nal = nals_.at( queued[i] );
+
+    if ( decoder_.decode( { nal.buffer.data(), nal.length }, pictures_.at( back_ ) ) ) {
+      back_ = middle_.exchange( back_ | FRESH, memory_order_acq_rel ) & ~FRESH;
+      pictures_decoded_++;
+    }
+
+    free_nals_.writable_region().at( 0 ) = queued[i];
+    free_nals_.push( 1 );
+  }
+
+  queued_nals_.pop( queued.size() );
+}
+
+void H264DecoderTask::push_nal( const string_view nal )
+{
+  if ( failed_.load( memory_order_acquire ) ) {
+    lock_guard<mutex> lock { failure_mutex_ };
+    rethrow_exception( exception_ );
+  }
+
+  if ( nal.size() > MAX_NAL_LENGTH ) {
+    throw runtime_error( "NAL too big" );
+  }
+
+  /* a picture other than IDR can only be decoded if every picture since the last IDR was */
+  const bool idr = contains_idr_slice( nal );
+  if ( mode_ == Mode::None or not( idr or ( mode_ == Mode::All and synced_ ) ) ) {
+    stats_.skipped++;
+    synced_ = false;
+    return;
+  }
+
+  const span_view<Handle> available = free_nals_.readable_region();
+  if ( available.size() == 0 ) {
+    stats_.dropped++;
+    synced_ = false;
+    return;
+  }
+
+  QueuedNAL& slot = nals_.at( available[0] );
+  memcpy( slot.buffer.data(), nal.data(), nal.size() );
+  memset( slot.buffer.data() + nal.size(), 0, AV_INPUT_BUFFER_PADDING_SIZE );
+  slot.length = nal.size();
+
+  queued_nals_.writable_region().at( 0 ) = available[0];
+  queued_nals_.push( 1 );
+  free_nals_.pop( 1 );
+  nal_queued_.notify();
+
+  stats_.queued++;
+  synced_ = true;
+}
+
+RasterYUV420& H264DecoderTask::picture()
+{
+  if ( middle_.load( memory_order_relaxed ) & FRESH ) {
+    front_ = middle_.exchange( front_, memory_order_acq_rel ) & ~FRESH;
+  }
+  return pictures_.at( front_ );
+}
+
+void H264DecoderTask::summary( ostream& out ) const
+{
+  out << "video frames decoded: " << pictures_decoded_;
+  out << " (mode=" << ( mode_ == Mode::All ? "all" : mode_ == Mode::IDROnly ? "IDR-only" : "none" );
+  out << " queued=" << stats_.queued << " skipped=" << stats_.skipped;
+  if ( stats_.dropped ) {
+    out << " dropped=" << stats_.dropped;
+  }
+  out << ")\n";
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "eventfd.hh"
+#include "h264_decoder.hh"
+#include "raster.hh"
+#include "spsc_ring_buffer.hh"
+
+//! Decodes one client's H.264 stream on a thread of its own
+//! \details Whole NALs are handed to the decoder thread in a small pool of buffers, passed by index through
+//! lock-free rings, and decoded pictures come back through a triple buffer, so the EventLoop thread never
+//! waits for the decoder. NALs the decoder has no room for are dropped, as are NALs the decode mode skips;
+//! either way, decoding resumes at the next IDR picture, which needs no earlier pictures.
+class H264DecoderTask
+{
+public:
+  enum class Mode : uint8_t
+  {
+    All,     //!< Decode every picture
+    IDROnly, //!< Decode only IDR pictures (a picture every keyframe interval)
+    None     //!< Decode nothing; the last picture decoded stays
+  };
+
+private:
+  static constexpr uint8_t NUM_NALS = 4;
+  static constexpr size_t MAX_NAL_LENGTH = 1048576;
+
+  using Handle = uint8_t;
+
+  struct QueuedNAL
+  {
+    std::vector<uint8_t> buffer = std::vector<uint8_t>( MAX_NAL_LENGTH + AV_INPUT_BUFFER_PADDING_SIZE );
+    size_t length {};
+  };
+
+  struct Statistics
+  {
+    unsigned int queued, skipped, dropped;
+  };
+
+  /* touched only by the decoder thread (once started) */
+  H264Decoder decoder_ {};
+  uint8_t back_ { 0 };
+
+  /* the pictures: the decoder thread writes the back one, the EventLoop thread reads the front one, and they
+     trade with the middle one (marked fresh when the decoder has put a newer picture there) */
+  static constexpr uint8_t FRESH = 4;
+  RasterPool<RasterYUV420>& rasters_;
+  std::vector<RasterYUV420> pictures_ {};
+  std::atomic<uint8_t> middle_ { 1 };
+
+  std::array<QueuedNAL, NUM_NALS> nals_ {};
+  SPSCRingBuffer<Handle> free_nals_ { 4096 }, queued_nals_ { 4096 };
+
+  EventFD nal_queued_ {}, stop_requested_ {};
+  std::atomic<bool> stopping_ {}, failed_ {};
+  std::mutex failure_mutex_ {};
+  std::exception_ptr exception_ {};
+
+  std::atomic<unsigned int> pictures_decoded_ {};
+
+  /* touched only by the EventLoop thread */
+  uint8_t front_ { 2 };
+  Mode mode_ { Mode::All };
+  bool synced_ {};
+  Statistics stats_ {};
+
+  std::thread thread_ {};
+
+  void decoder_thread_main();
+  void decode_queued_nals();
+
+public:
+  //! \param rasters where the task's pictures come from, and go back to when it is destroyed
+  explicit H264DecoderTask( RasterPool<RasterYUV420>& rasters );
+  ~H264DecoderTask();
+
+  //! Queue a whole NAL (an access unit, in Annex B format) for decoding, unless the mode skips it
+  void push_nal( const std::string_view nal );
+
+  void set_mode( const Mode mode ) { mode_ = mode; }
+  Mode mode() const { return mode_; }
+
+  //! The newest picture decoded (all zero before the first)
+  RasterYUV420& picture();
+
+  void summary( std::ostream& out ) const;
+
+  H264DecoderTask( const H264DecoderTask& other ) = delete;
+  H264DecoderTask& operator=( const H264DecoderTask& other ) = delete;
+};
@@ -52,9 +52,9 @@ void H264Encoder::encode( RasterYUV420& raster )
 
   pic_in_.img.i_csp = X264_CSP_I420;
   pic_in_.img.i_plane = 3;
-  pic_in_.img.i_stride[0] = raster.width();
-  pic_in_.img.i_stride[1] = raster.chroma_width();
-  pic_in_.img.i_stride[2] = raster.chroma_width();
+  pic_in_.img.i_stride[0] = raster.stride();
+  pic_in_.img.i_stride[1] = raster.chroma_stride();
+  pic_in_.img.i_stride[2] = raster.chroma_stride();
 
   pic_in_.img.plane[0] = raster.Y_row( 0 );
   pic_in_.img.plane[1] = raster.Cb_row( 0 );
@@ -67,6 +67,7 @@ void H264Encoder::encode( RasterYUV420& raster )
   x264_nal_t* nal;
   //  x264_encoder_intra_refresh( encoder_.get() );
   const auto frame_size = x264_encoder_encode( encoder_.get(), &nal, &nals_count, &pic_in_, &pic_out_ );
+  pic_in_.i_type = X264_TYPE_AUTO;
 
   if ( not nal or frame_size <= 0 ) {
     encoded_.reset();
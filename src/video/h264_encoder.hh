@@ -54,4 +54,7 @@ public:
   void reset_nal() { encoded_.reset(); }
 
   uint32_t frames_encoded() const { return frame_num_; }
+
+  //! Make the next picture encoded an IDR picture (which a decoder can start from)
+  void request_keyframe() { pic_in_.i_type = X264_TYPE_IDR; }
 };
@@ -33,6 +33,18 @@
 
 using namespace std;
 
+namespace {
+
+/* even = average of even and odd, rounding up (distinct rows, so the loop vectorizes) */
+void average_rows( uint8_t* __restrict__ even, const uint8_t* __restrict__ odd, const size_t length )
+{
+  for ( size_t x = 0; x < length; x++ ) {
+    even[x] = ( even[x] + odd[x] + 1 ) / 2;
+  }
+}
+
+}
+
 JPEGDecompresser::JPEGDecompresser()
 {
   jpeg_std_error( &error_manager_ );
@@ -125,14 +137,89 @@ void JPEGDecompresser::decode( RasterYUV422& r )
     throw runtime_error( "size mismatch" );
   }
 
+  Y_rows_.resize( DCTSIZE );
+  Cb_rows_.resize( DCTSIZE );
+  Cr_rows_.resize( DCTSIZE );
+  array<uint8_t**, 3> planes { Y_rows_.data(), Cb_rows_.data(), Cr_rows_.data() };
+
+  try {
+    jpeg_start_decompress( &decompresser_ );
+
+    while ( decompresser_.output_scanline < decompresser_.output_height ) {
+      for ( unsigned int i = 0; i < DCTSIZE; i++ ) {
+        Y_rows_[i] = r.Y_row( decompresser_.output_scanline + i );
+        Cb_rows_[i] = r.Cb_row( decompresser_.output_scanline + i );
+        Cr_rows_[i] = r.Cr_row( decompresser_.output_scanline + i );
+      }
+
+      if ( jpeg_read_raw_data( &decompresser_, planes.data(), DCTSIZE ) != DCTSIZE ) {
+        throw runtime_error( "jpeg_read_raw_data returned short read" );
+      }
+    }
+
+    jpeg_finish_decompress( &decompresser_ );
+  } catch ( const JPEGException& e ) {
+    cerr << "JPEG exception in decompress: " << e.what() << "\n";
+    bad_ = true;
+  }
+}
+
+void JPEGDecompresser::decode( RasterYUV420& r )
+{
+  if ( bad_ ) {
+    return;
+  }
+
+  unsigned int reduction = 1;
+  while ( reduction < 4 and r.width() * reduction < width() ) {
+    reduction *= 2;
+  }
+
+  if ( r.width() * reduction != width() or r.height() * reduction != height() ) {
+    throw runtime_error( "size mismatch" );
+  }
+
+  decompresser_.scale_num = 1;
+  decompresser_.scale_denom = reduction;
+
+  /* each call returns one row of MCUs, scaled down with the image; always an even number of rows */
+  const unsigned int lines = decompresser_.max_v_samp_factor * DCTSIZE / reduction;
+  const uint16_t chroma_width = r.chroma_width();
+
+  chroma_scratch_.resize( lines * chroma_width );
+  Y_rows_.resize( lines );
+  Cb_rows_.resize( lines );
+  Cr_rows_.resize( lines );
+  array<uint8_t**, 3> planes { Y_rows_.data(), Cb_rows_.data(), Cr_rows_.data() };
+
+  uint8_t* const Cb_scratch = chroma_scratch_.data();
+  uint8_t* const Cr_scratch = Cb_scratch + lines / 2 * chroma_width;
+
   try {
     jpeg_start_decompress( &decompresser_ );
 
+    if ( decompresser_.output_width != r.width() or decompresser_.output_height != r.height() ) {
+      throw runtime_error( "unexpected scaled JPEG size" );
+    }
+
     while ( decompresser_.output_scanline < decompresser_.output_height ) {
-      if ( jpeg_read_raw_data( &decompresser_, r.rows( decompresser_.output_scanline ).data(), height() )
-           != DCTSIZE ) {
+      const unsigned int first = decompresser_.output_scanline;
+
+      /* even chroma rows go straight to the raster, odd ones to the scratch rows */
+      for ( unsigned int i = 0; i < lines; i++ ) {
+        Y_rows_[i] = r.Y_row( first + i );
+        Cb_rows_[i] = i % 2 ? Cb_scratch + i / 2 * chroma_width : r.Cb_row( ( first + i ) / 2 );
+        Cr_rows_[i] = i % 2 ? Cr_scratch + i / 2 * chroma_width : r.Cr_row( ( first + i ) / 2 );
+      }
+
+      if ( jpeg_read_raw_data( &decompresser_, planes.data(), lines ) != lines ) {
         throw runtime_error( "jpeg_read_raw_data returned short read" );
       }
+
+      for ( unsigned int i = 1; i < lines; i += 2 ) {
+        average_rows( Cb_rows_[i - 1], Cb_rows_[i], chroma_width );
+        average_rows( Cr_rows_[i - 1], Cr_rows_[i], chroma_width );
+      }
     }
 
     jpeg_finish_decompress( &decompresser_ );
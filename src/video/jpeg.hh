@@ -33,6 +33,7 @@
 #include <jpeglib.h>
 #include <optional>
 #include <string_view>
+#include <vector>
 
 #include "raster.hh"
 
@@ -52,6 +53,11 @@ class JPEGDecompresser
 
   bool bad_ {};
 
+  /* rows handed to libjpeg for each row of MCUs, and (for a 4:2:0 raster) the chroma rows decoded between
+     the rows kept, which are averaged into them */
+  std::vector<uint8_t*> Y_rows_ {}, Cb_rows_ {}, Cr_rows_ {};
+  std::vector<uint8_t> chroma_scratch_ {};
+
 public:
   JPEGDecompresser();
   ~JPEGDecompresser();
@@ -60,6 +66,11 @@ public:
 
   void decode( RasterYUV422& r );
 
+  //! Decode straight to 4:2:0, averaging each pair of chroma rows
+  //! \details The raster may be the size of the image, or smaller by a factor of 2 or 4, in which case the
+  //! decoder scales the image down in the DCT domain (and never produces the full-size picture).
+  void decode( RasterYUV420& r );
+
   unsigned int width() const;
   unsigned int height() const;
 
@@ -1,18 +1,50 @@
 #pragma once
 
-#include <array>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
+//! A picture in three planes, Y'CbCr, held in one allocation
+//! \details The planes follow one another in the buffer. Every row starts on a 64-byte boundary (rows are
+//! padded out to a multiple of 64 bytes), so SIMD code may load whole rows with aligned loads.
 class RasterYUV
 {
+public:
+  static constexpr size_t ALIGNMENT = 64;
+
 private:
+  struct aligned_deleter
+  {
+    void operator()( uint8_t* buffer ) const { ::operator delete[]( buffer, std::align_val_t { ALIGNMENT } ); }
+  };
+
   uint16_t width_, height_;
   uint16_t chroma_width_, chroma_height_;
+  size_t stride_, chroma_stride_;
+
+  std::unique_ptr<uint8_t[], aligned_deleter> buffer_;
+
+  static size_t padded( const size_t length ) { return ( length + ALIGNMENT - 1 ) / ALIGNMENT * ALIGNMENT; }
 
-  std::vector<uint8_t> Y_ {}, Cb_ {}, Cr_ {};
-  std::vector<uint8_t*> Y_rows_ {}, Cb_rows_ {}, Cr_rows_ {};
+  size_t Y_length() const { return stride_ * height_; }
+  size_t chroma_length() const { return chroma_stride_ * chroma_height_; }
+  size_t buffer_length() const { return Y_length() + 2 * chroma_length(); }
+
+  const uint8_t* Y_plane() const { return buffer_.get(); }
+  const uint8_t* Cb_plane() const { return buffer_.get() + Y_length(); }
+  const uint8_t* Cr_plane() const { return buffer_.get() + Y_length() + chroma_length(); }
+
+  static void check_row( const uint16_t y, const uint16_t height )
+  {
+    if ( y >= height ) {
+      throw std::out_of_range( "RasterYUV: row " + std::to_string( y ) + " >= " + std::to_string( height ) );
+    }
+  }
 
 protected:
   RasterYUV( const uint16_t width,
@@ -23,22 +55,10 @@ protected:
     , height_( height )
     , chroma_width_( chroma_width )
     , chroma_height_( chroma_height )
-    , Y_( width * height )
-    , Cb_( chroma_width * chroma_height )
-    , Cr_( chroma_width * chroma_height )
-  {
-    Y_rows_.reserve( height );
-    Cb_rows_.reserve( chroma_height );
-    Cr_rows_.reserve( chroma_height );
-    for ( uint16_t y = 0; y < height; y++ ) {
-      Y_rows_.push_back( Y_row( y ) );
-    }
-
-    for ( uint16_t y = 0; y < chroma_height; y++ ) {
-      Cb_rows_.push_back( Cb_row( y ) );
-      Cr_rows_.push_back( Cr_row( y ) );
-    }
-  }
+    , stride_( padded( width ) )
+    , chroma_stride_( padded( chroma_width ) )
+    , buffer_( new ( std::align_val_t { ALIGNMENT } ) uint8_t[buffer_length()]() )
+  {}
 
 public:
   uint16_t width() const { return width_; }
@@ -46,27 +66,35 @@ public:
   uint16_t chroma_width() const { return chroma_width_; }
   uint16_t chroma_height() const { return chroma_height_; }
 
-  std::string_view Y_view() const { return { reinterpret_cast<const char*>( Y_.data() ), Y_.size() }; }
-  std::string_view Cb_view() const { return { reinterpret_cast<const char*>( Cb_.data() ), Cb_.size() }; }
-  std::string_view Cr_view() const { return { reinterpret_cast<const char*>( Cr_.data() ), Cr_.size() }; }
+  //! Distance in bytes from one row to the next
+  size_t stride() const { return stride_; }
+  size_t chroma_stride() const { return chroma_stride_; }
 
-  const std::vector<uint8_t>& Y() const { return Y_; }
-  const std::vector<uint8_t>& Cb() const { return Cb_; }
-  const std::vector<uint8_t>& Cr() const { return Cr_; }
+  uint8_t* Y_row( const uint16_t y ) { return const_cast<uint8_t*>( std::as_const( *this ).Y_row( y ) ); }
+  uint8_t* Cb_row( const uint16_t y ) { return const_cast<uint8_t*>( std::as_const( *this ).Cb_row( y ) ); }
+  uint8_t* Cr_row( const uint16_t y ) { return const_cast<uint8_t*>( std::as_const( *this ).Cr_row( y ) ); }
 
-  uint8_t* Y_row( const uint16_t y ) { return &Y_.at( y * width() ); }
-  uint8_t* Cb_row( const uint16_t y ) { return &Cb_.at( y * chroma_width() ); }
-  uint8_t* Cr_row( const uint16_t y ) { return &Cr_.at( y * chroma_width() ); }
+  const uint8_t* Y_row( const uint16_t y ) const
+  {
+    check_row( y, height_ );
+    return Y_plane() + y * stride_;
+  }
 
-  const uint8_t* Y_row( const uint16_t y ) const { return &Y_.at( y * width() ); }
-  const uint8_t* Cb_row( const uint16_t y ) const { return &Cb_.at( y * chroma_width() ); }
-  const uint8_t* Cr_row( const uint16_t y ) const { return &Cr_.at( y * chroma_width() ); }
+  const uint8_t* Cb_row( const uint16_t y ) const
+  {
+    check_row( y, chroma_height_ );
+    return Cb_plane() + y * chroma_stride_;
+  }
 
-  std::array<uint8_t**, 3> rows( const uint16_t y )
+  const uint8_t* Cr_row( const uint16_t y ) const
   {
-    return { &Y_rows_.at( y ), &Cb_rows_.at( y ), &Cr_rows_.at( y ) };
+    check_row( y, chroma_height_ );
+    return Cr_plane() + y * chroma_stride_;
   }
 
+  //! Set every sample to zero, as in a newly allocated raster
+  void clear() { memset( buffer_.get(), 0, buffer_length() ); }
+
   RasterYUV( const RasterYUV& other ) = delete;
   RasterYUV& operator=( const RasterYUV& other ) = delete;
   RasterYUV( RasterYUV&& other ) = default;
@@ -88,3 +116,40 @@ public:
     : RasterYUV( width, height, width / 2, height / 2 )
   {}
 };
+
+//! Rasters of one size that are handed out again when returned, rather than freed and reallocated
+template<class RasterType>
+class RasterPool
+{
+  uint16_t width_, height_;
+  std::vector<RasterType> free_ {};
+
+public:
+  RasterPool( const uint16_t width, const uint16_t height )
+    : width_( width )
+    , height_( height )
+  {}
+
+  //! A cleared raster: a returned one if any, or else a new one
+  RasterType take()
+  {
+    if ( free_.empty() ) {
+      return RasterType { width_, height_ };
+    }
+
+    RasterType raster = std::move( free_.back() );
+    free_.pop_back();
+    raster.clear();
+    return raster;
+  }
+
+  void recycle( RasterType&& raster )
+  {
+    if ( raster.width() != width_ or raster.height() != height_ ) {
+      throw std::runtime_error( "RasterPool::recycle: size mismatch" );
+    }
+    free_.push_back( std::move( raster ) );
+  }
+
+  size_t available() const { return free_.size(); }
+};
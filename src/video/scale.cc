@@ -9,9 +9,9 @@ void Scaler::create_context()
 {
   context_ = notnull( "sws_getCachedContext",
                       sws_getCachedContext( context_,
-                                            source_width_,
-                                            source_height_,
-                                            AV_PIX_FMT_YUV422P,
+                                            source_width_ / source_reduction_,
+                                            source_height_ / source_reduction_,
+                                            source_format_,
                                             output_width,
                                             output_height,
                                             AV_PIX_FMT_YUV420P,
@@ -53,24 +53,77 @@ void Scaler::saturate_params()
   }
 }
 
+void Scaler::use_source( const AVPixelFormat format, const uint8_t reduction )
+{
+  if ( format != source_format_ or reduction != source_reduction_ ) {
+    source_format_ = format;
+    source_reduction_ = reduction;
+    create_context();
+  }
+}
+
+uint8_t Scaler::max_reduction( const uint16_t width, const uint16_t height )
+{
+  uint8_t reduction = 1;
+  while ( reduction < 4 and width / ( reduction * 2 ) >= output_width
+          and height / ( reduction * 2 ) >= output_height ) {
+    reduction *= 2;
+  }
+  return reduction;
+}
+
 void Scaler::scale( const RasterYUV422& source, RasterYUV420& dest )
 {
   if ( source.width() != input_width or source.height() != input_height ) {
     throw runtime_error( "source size mismatch" );
   }
 
+  use_source( AV_PIX_FMT_YUV422P, 1 );
+
+  const array<const uint8_t*, 3> source_planes { source.Y_row( source_y_ ) + source_x_,
+                                                 source.Cb_row( source_y_ ) + source_x_ / 2,
+                                                 source.Cr_row( source_y_ ) + source_x_ / 2 };
+
+  const array<const int, 3> source_strides { int( source.stride() ),
+                                             int( source.chroma_stride() ),
+                                             int( source.chroma_stride() ) };
+
+  scale_planes( source_planes, source_strides, dest );
+}
+
+void Scaler::scale( const RasterYUV420& source, RasterYUV420& dest )
+{
+  const uint8_t reduction = input_width / source.width();
+  if ( source.width() * reduction != input_width or source.height() * reduction != input_height ) {
+    throw runtime_error( "source size mismatch" );
+  }
+
+  use_source( AV_PIX_FMT_YUV420P, reduction );
+
+  const uint16_t x = source_x_ / reduction, y = source_y_ / reduction;
+
+  const array<const uint8_t*, 3> source_planes {
+    source.Y_row( y ) + x, source.Cb_row( y / 2 ) + x / 2, source.Cr_row( y / 2 ) + x / 2 };
+
+  const array<const int, 3> source_strides { int( source.stride() ),
+                                             int( source.chroma_stride() ),
+                                             int( source.chroma_stride() ) };
+
+  scale_planes( source_planes, source_strides, dest );
+}
+
+void Scaler::scale_planes( const array<const uint8_t*, 3>& source_planes,
+                           const array<const int, 3>& source_strides,
+                           RasterYUV420& dest )
+{
   if ( dest.width() != output_width or dest.height() != output_height ) {
     throw runtime_error( "dest size mismatch" );
   }
 
-  const array<const uint8_t*, 3> source_planes { source.Y().data() + source_y_ * input_width + source_x_,
-                                                 source.Cb().data() + source_y_ * input_width / 2 + source_x_ / 2,
-                                                 source.Cr().data() + source_y_ * input_width / 2 + source_x_ / 2 };
-
   const array<uint8_t*, 3> dest_planes { dest.Y_row( 0 ), dest.Cb_row( 0 ), dest.Cr_row( 0 ) };
-
-  const array<const int, 3> source_strides { input_width, input_width / 2, input_width / 2 };
-  const array<const int, 3> dest_strides { output_width, output_width / 2, output_width / 2 };
+  const array<const int, 3> dest_strides { int( dest.stride() ),
+                                           int( dest.chroma_stride() ),
+                                           int( dest.chroma_stride() ) };
 
   if ( not context_ ) {
     throw runtime_error( "null ptr!" );
@@ -80,7 +133,7 @@ void Scaler::scale( const RasterYUV422& source, RasterYUV420& dest )
                                       source_planes.data(),
                                       source_strides.data(),
                                       0,
-                                      source_height_,
+                                      source_height_ / source_reduction_,
                                       dest_planes.data(),
                                       dest_strides.data() );
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 
 #include "raster.hh"
@@ -18,11 +19,20 @@ class Scaler
 
   uint16_t source_x_ { 0 }, source_y_ { 0 }, source_width_ { input_width }, source_height_ { input_height };
 
+  /* the source last scaled: its chroma subsampling, and by how much it was reduced from the camera's size */
+  AVPixelFormat source_format_ { AV_PIX_FMT_YUV422P };
+  uint8_t source_reduction_ { 1 };
+
   void saturate_params();
 
   bool need_new_context_ { false };
   void create_context();
 
+  void use_source( const AVPixelFormat format, const uint8_t reduction );
+  void scale_planes( const std::array<const uint8_t*, 3>& source_planes,
+                     const std::array<const int, 3>& source_strides,
+                     RasterYUV420& dest );
+
 public:
   Scaler() { create_context(); }
   ~Scaler()
@@ -32,10 +42,17 @@ public:
     }
   }
 
+  //! Crop to this region of the camera's (full-size) picture
   void setup( const uint16_t x, const uint16_t y, const uint16_t width, const uint16_t height );
 
   void scale( const RasterYUV422& source, RasterYUV420& dest );
 
+  //! Scale a 4:2:0 picture, which may have been decoded at a half or quarter of the camera's size
+  void scale( const RasterYUV420& source, RasterYUV420& dest );
+
+  //! By how much a source could be reduced from the camera's size with this crop, and still be scaled down
+  static uint8_t max_reduction( const uint16_t width, const uint16_t height );
+
   Scaler( const Scaler& other ) = delete;
   Scaler& operator=( const Scaler& other ) = delete;
 };
@@ -0,0 +1,267 @@
+#include "video_pipeline.hh"
+#include "timer.hh"
+
+using namespace std;
+
+namespace {
+
+template<typename Handle>
+void push_handle( SPSCRingBuffer<Handle>& ring, const Handle handle )
+{
+  ring.writable_region().at( 0 ) = handle;
+  ring.push( 1 );
+}
+
+}
+
+VideoPipeline::VideoPipeline( const string& camera_device,
+                              const uint8_t fps,
+                              shared_ptr<VideoSource> source,
+                              EventLoop& loop )
+  : camera_( camera_width, camera_height, camera_device )
+  , encoder_( output_width, output_height, fps, "fast", "zerolatency" )
+  , source_( move( source ) )
+{
+  for ( Handle i = 0; i < NUM_CAMERA_RASTERS; i++ ) {
+    camera_frames_.emplace_back();
+    push_handle( free_camera_rasters_, i );
+  }
+
+  for ( Handle i = 0; i < NUM_SCALED_RASTERS; i++ ) {
+    scaled_rasters_.emplace_back( output_width, output_height );
+    push_handle( free_scaled_rasters_, i );
+  }
+
+  for ( Handle i = 0; i < NUM_ENCODED_NALS; i++ ) {
+    push_handle( free_encoded_, i );
+  }
+
+  loop.add_rule( "video pipeline output", nal_ready_, Direction::In, [&] { deliver_nals(); } );
+}
+
+VideoPipeline::~VideoPipeline()
+{
+  stopping_ = true;
+  stop_requested_.notify();
+  for ( auto& thread : threads_ ) {
+    thread.join();
+  }
+}
+
+void VideoPipeline::start()
+{
+  if ( not threads_.empty() ) {
+    throw runtime_error( "VideoPipeline already started" );
+  }
+
+  threads_.emplace_back( [&] {
+    run_stage( [&]( EventLoop& loop ) {
+      loop.add_rule( "capture", camera_.fd(), Direction::In, [&] { capture_frame(); } );
+    } );
+  } );
+
+  threads_.emplace_back( [&] {
+    run_stage( [&]( EventLoop& loop ) {
+      loop.add_rule( "scale", frame_captured_, Direction::In, [&] {
+        frame_captured_.drain();
+        scale_frames();
+      } );
+    } );
+  } );
+
+  threads_.emplace_back( [&] {
+    run_stage( [&]( EventLoop& loop ) {
+      loop.add_rule( "encode", frame_scaled_, Direction::In, [&] {
+        frame_scaled_.drain();
+        encode_frames();
+      } );
+
+      loop.add_rule( "encoded NAL freed", encoded_freed_, Direction::In, [&] {
+        encoded_freed_.drain();
+        encode_frames();
+      } );
+    } );
+  } );
+}
+
+void VideoPipeline::run_stage( const function<void( EventLoop& )>& add_rules )
+{
+  try {
+    EventLoop loop;
+    add_rules( loop );
+
+    /* never drained, so that it wakes every stage */
+    loop.add_rule( "stop", stop_requested_, Direction::In, [] {} );
+
+    while ( not stopping_ and loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {
+    }
+  } catch ( ... ) {
+    /* hand the (first) exception to the EventLoop thread, which rethrows it */
+    {
+      lock_guard<mutex> lock { failure_mutex_ };
+      if ( not exception_ ) {
+        exception_ = current_exception();
+      }
+    }
+    failed_.store( true, memory_order_release );
+    nal_ready_.notify();
+  }
+}
+
+void VideoPipeline::capture_frame()
+{
+  const uint64_t start = Timer::timestamp_ns();
+
+  const span_view<Handle> available = free_camera_rasters_.readable_region();
+  if ( available.size() == 0 ) {
+    camera_.skip_next_frame();
+    dropped_at_capture_++;
+    return;
+  }
+
+  const Handle handle = available[0];
+  free_camera_rasters_.pop( 1 );
+
+  CameraFrame& frame = camera_frames_.at( handle );
+  frame.reduced = capture_reduction_.load( memory_order_relaxed ) > 1;
+  if ( frame.reduced ) {
+    camera_.get_next_frame( frame.half );
+  } else {
+    if ( not frame.full ) {
+      frame.full.emplace( camera_width, camera_height );
+    }
+    camera_.get_next_frame( frame.full.value() );
+  }
+
+  camera_times_.at( handle ) = {};
+  camera_times_.at( handle ).capture_start = start;
+  camera_times_.at( handle ).captured = Timer::timestamp_ns();
+
+  push_handle( captured_, handle );
+  frames_captured_++;
+  frame_captured_.notify();
+}
+
+void VideoPipeline::scale_frames()
+{
+  if ( zoom_pending_.exchange( false ) ) {
+    lock_guard<mutex> lock { zoom_mutex_ };
+    const Zoom& zoom = pending_zoom_.value();
+    scaler_.setup( zoom.x, zoom.y, zoom.width, zoom.height );
+  }
+
+  const span_view<Handle> captured = captured_.readable_region();
+  if ( captured.size() == 0 ) {
+    return;
+  }
+
+  /* only the newest frame is worth scaling; any older ones waiting were missed */
+  for ( size_t i = 0; i + 1 < captured.size(); i++ ) {
+    push_handle( free_camera_rasters_, captured[i] );
+    dropped_at_scale_++;
+  }
+
+  const Handle input = captured[captured.size() - 1];
+  const span_view<Handle> available = free_scaled_rasters_.readable_region();
+
+  if ( available.size() == 0 ) {
+    dropped_at_scale_++;
+  } else {
+    const Handle output = available[0];
+    free_scaled_rasters_.pop( 1 );
+
+    scaled_times_.at( output ) = camera_times_.at( input );
+    scaled_times_.at( output ).scale_start = Timer::timestamp_ns();
+    scaler_.scale( camera_frames_.at( input ).raster(), scaled_rasters_.at( output ) );
+    scaled_times_.at( output ).scaled = Timer::timestamp_ns();
+
+    push_handle( scaled_, output );
+    frames_scaled_++;
+    frame_scaled_.notify();
+  }
+
+  push_handle( free_camera_rasters_, input );
+  captured_.pop( captured.size() );
+}
+
+void VideoPipeline::encode_frames()
+{
+  /* every scaled frame is encoded, in order; if no NAL is free, wait for the EventLoop thread to free one */
+  while ( scaled_.readable_region().size() and free_encoded_.readable_region().size() ) {
+    const Handle input = scaled_.readable_region()[0];
+    const Handle output = free_encoded_.readable_region()[0];
+
+    if ( keyframe_requested_.exchange( false ) ) {
+      encoder_.request_keyframe();
+    }
+
+    VideoSource::StageTimestamps times = scaled_times_.at( input );
+    times.encode_start = Timer::timestamp_ns();
+    encoder_.encode( scaled_rasters_.at( input ) );
+    times.encoded = Timer::timestamp_ns();
+
+    scaled_.pop( 1 );
+    push_handle( free_scaled_rasters_, input );
+    frames_encoded_++;
+
+    if ( encoder_.has_nal() ) {
+      EncodedNAL& nal = encoded_.at( output );
+      nal.NAL.assign( encoder_.nal().NAL );
+      nal.pts = encoder_.nal().pts;
+      nal.dts = encoder_.nal().dts;
+      encoder_.reset_nal();
+      encoded_times_.at( output ) = times;
+
+      free_encoded_.pop( 1 );
+      push_handle( encoded_ready_, output );
+      nal_ready_.notify();
+    }
+  }
+}
+
+void VideoPipeline::deliver_nals()
+{
+  nal_ready_.drain();
+
+  if ( failed_.load( memory_order_acquire ) ) {
+    lock_guard<mutex> lock { failure_mutex_ };
+    rethrow_exception( exception_ );
+  }
+
+  const span_view<Handle> ready = encoded_ready_.readable_region();
+  if ( ready.size() == 0 ) {
+    return;
+  }
+
+  const VideoSource::StageCounts counts { frames_captured_, frames_scaled_, frames_encoded_, dropped_at_capture_,
+                                          dropped_at_scale_ };
+
+  for ( size_t i = 0; i < ready.size(); i++ ) {
+    const Handle handle = ready[i];
+    const EncodedNAL& nal = encoded_.at( handle );
+    const uint64_t now = Timer::timestamp_ns();
+
+    source_->record_pipeline_frame( encoded_times_.at( handle ), counts, now );
+    source_->push( { nal.NAL, nal.pts, nal.dts }, now );
+
+    push_handle( free_encoded_, handle );
+  }
+
+  encoded_ready_.pop( ready.size() );
+  encoded_freed_.notify();
+}
+
+void VideoPipeline::set_zoom( const uint16_t x, const uint16_t y, const uint16_t width, const uint16_t height )
+{
+  {
+    lock_guard<mutex> lock { zoom_mutex_ };
+    pending_zoom_ = { x, y, width, height };
+  }
+  zoom_pending_ = true;
+
+  /* decode at half size if the crop still has at least as many pixels as the output (an invalid crop means
+     the whole picture) */
+  const bool valid = width and height and x + width <= camera_width and y + height <= camera_height;
+  capture_reduction_ = valid ? Scaler::max_reduction( width, height )
+                             : Scaler::max_reduction( camera_width, camera_height );
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "camera.hh"
+#include "eventfd.hh"
+#include "eventloop.hh"
+#include "h264_encoder.hh"
+#include "scale.hh"
+#include "spsc_ring_buffer.hh"
+#include "video_source.hh"
+
+//! Captures (and decodes), scales and encodes the camera's video, each stage on a thread of its own
+//! \details Rasters and encoded NALs come from pools allocated up front, and travel between the stages by
+//! index through lock-free single-producer/single-consumer rings. A slow stage only backs up its own input:
+//! capture skips a frame when every camera raster is in use, and scale keeps only the newest captured frame
+//! and skips it if every scaled raster is in use, so the encoder always sees whole frames in order. Encoded
+//! NALs reach the EventLoop thread, which pushes them into the VideoSource. Unless the crop is too small, the
+//! camera's MJPEG is decoded at half size, straight to 4:2:0, so no 4K picture is ever produced.
+class VideoPipeline
+{
+  static constexpr uint16_t camera_width = 3840, camera_height = 2160;
+  static constexpr uint16_t output_width = 1280, output_height = 720;
+
+  static constexpr uint8_t NUM_CAMERA_RASTERS = 3;
+  static constexpr uint8_t NUM_SCALED_RASTERS = 3;
+  static constexpr uint8_t NUM_ENCODED_NALS = 4;
+
+  using Handle = uint8_t;
+  using HandleRing = SPSCRingBuffer<Handle>;
+
+  struct EncodedNAL
+  {
+    std::string NAL {};
+    int64_t pts {}, dts {};
+  };
+
+  //! A camera frame, decoded at full size or (when the crop leaves enough pixels) at half size
+  struct CameraFrame
+  {
+    RasterYUV420 half { camera_width / 2, camera_height / 2 };
+    std::optional<RasterYUV420> full {}; /* allocated the first time a crop needs it */
+    bool reduced {};
+
+    const RasterYUV420& raster() const { return reduced ? half : full.value(); }
+  };
+
+  struct Zoom
+  {
+    uint16_t x {}, y {}, width {}, height {};
+  };
+
+  /* each stage's objects are touched only by its own thread (once started) */
+  Camera camera_;
+  Scaler scaler_ {};
+  H264Encoder encoder_;
+
+  /* the pools, with the timestamps of the frame each entry currently holds */
+  std::vector<CameraFrame> camera_frames_ {};
+  std::vector<RasterYUV420> scaled_rasters_ {};
+  std::array<EncodedNAL, NUM_ENCODED_NALS> encoded_ {};
+  std::array<VideoSource::StageTimestamps, NUM_CAMERA_RASTERS> camera_times_ {};
+  std::array<VideoSource::StageTimestamps, NUM_SCALED_RASTERS> scaled_times_ {};
+  std::array<VideoSource::StageTimestamps, NUM_ENCODED_NALS> encoded_times_ {};
+
+  /* each handle goes around a loop: free -> filled by one stage -> used by the next -> free */
+  HandleRing free_camera_rasters_ { 4096 }, captured_ { 4096 };
+  HandleRing free_scaled_rasters_ { 4096 }, scaled_ { 4096 };
+  HandleRing free_encoded_ { 4096 }, encoded_ready_ { 4096 };
+
+  EventFD frame_captured_ {}, frame_scaled_ {}, nal_ready_ {}, encoded_freed_ {}, stop_requested_ {};
+  std::atomic<bool> stopping_ {}, failed_ {};
+  std::mutex failure_mutex_ {};
+  std::exception_ptr exception_ {};
+
+  std::atomic<uint64_t> frames_captured_ {}, frames_scaled_ {}, frames_encoded_ {};
+  std::atomic<uint64_t> dropped_at_capture_ {}, dropped_at_scale_ {};
+
+  std::mutex zoom_mutex_ {};
+  std::optional<Zoom> pending_zoom_ {};
+  std::atomic<bool> zoom_pending_ {};
+  std::atomic<bool> keyframe_requested_ {};
+  std::atomic<uint8_t> capture_reduction_ { Scaler::max_reduction( camera_width, camera_height ) };
+
+  std::shared_ptr<VideoSource> source_;
+  std::vector<std::thread> threads_ {};
+
+  void run_stage( const std::function<void( EventLoop& )>& add_rules );
+
+  void capture_frame();
+  void scale_frames();
+  void encode_frames();
+  void deliver_nals();
+
+public:
+  VideoPipeline( const std::string& camera_device,
+                 const uint8_t fps,
+                 std::shared_ptr<VideoSource> source,
+                 EventLoop& loop );
+  ~VideoPipeline();
+
+  //! Start the stage threads
+  void start();
+
+  //! Crop the camera's picture to this region before scaling (takes effect from the next frame scaled)
+  void set_zoom( const uint16_t x, const uint16_t y, const uint16_t width, const uint16_t height );
+
+  //! Make the next frame encoded an IDR picture
+  void request_keyframe() { keyframe_requested_ = true; }
+
+  VideoPipeline( const VideoPipeline& other ) = delete;
+  VideoPipeline& operator=( const VideoPipeline& other ) = delete;
+};
@@ -19,6 +19,23 @@ void VideoSource::push( const H264Encoder::EncodedNAL& nal, const uint64_t now )
   }
 }
 
+void VideoSource::record_pipeline_frame( const StageTimestamps& times,
+                                         const StageCounts& counts,
+                                         const uint64_t now )
+{
+  if ( not pipeline_stats_.has_value() ) {
+    pipeline_stats_.emplace();
+    pipeline_stats_->first_capture = times.capture_start;
+  }
+
+  auto& stats = pipeline_stats_.value();
+  stats.decode.log( times.captured - times.capture_start );
+  stats.scale.log( times.scaled - times.scale_start );
+  stats.encode.log( times.encoded - times.encode_start );
+  stats.capture_to_send.log( now - times.capture_start );
+  stats.counts = counts;
+}
+
 unsigned int VideoSource::TimedNAL::num_chunks() const
 {
   static constexpr size_t capacity = VideoChunk::Buffer::capacity();
@@ -95,15 +112,19 @@ uint64_t VideoSource::wait_time_ms( const uint64_t now ) const
 VideoChunk VideoSource::front( const uint32_t frame_index ) const
 {
   VideoChunk ret;
-  ret.frame_index = frame_index;
-  ret.nal_index = outbound_queue_.front().nal_index;
+  front( frame_index, ret );
+  return ret;
+}
 
-  ret.data.resize( outbound_queue_.front().next_chunk_size() );
-  ret.data.mutable_buffer().copy( outbound_queue_.front().next_chunk() );
+void VideoSource::front( const uint32_t frame_index, VideoChunk& out ) const
+{
+  out.frame_index = frame_index;
+  out.nal_index = outbound_queue_.front().nal_index;
 
-  ret.end_of_nal = outbound_queue_.front().last_chunk();
+  out.data.resize( outbound_queue_.front().next_chunk_size() );
+  out.data.mutable_buffer().copy( outbound_queue_.front().next_chunk() );
 
-  return ret;
+  out.end_of_nal = outbound_queue_.front().last_chunk();
 }
 
 void VideoSource::summary( ostream& out ) const
@@ -111,6 +132,31 @@ void VideoSource::summary( ostream& out ) const
   out << "next NAL: " << next_nal_index_;
   out << " fps: " << next_nal_index_ / ( double( Timer::timestamp_ns() - beginning_time_ ) / 1000000000.0 );
   out << "\n";
+
+  if ( pipeline_stats_.has_value() ) {
+    const auto& stats = pipeline_stats_.value();
+    const double seconds = double( Timer::timestamp_ns() - stats.first_capture ) / BILLION;
+
+    out << "Pipeline fps: captured " << setprecision( 1 ) << fixed << stats.counts.captured / seconds << ", scaled "
+        << stats.counts.scaled / seconds << ", encoded " << stats.counts.encoded / seconds;
+    if ( stats.counts.dropped_at_capture or stats.counts.dropped_at_scale ) {
+      out << " (dropped " << stats.counts.dropped_at_capture << " at capture, " << stats.counts.dropped_at_scale
+          << " at scale!)";
+    }
+    out << "\n";
+
+    const pair<const char*, const Timer::Record*> stages[] = { { "decode", &stats.decode },
+                                                               { "scale", &stats.scale },
+                                                               { "encode", &stats.encode },
+                                                               { "capture to send", &stats.capture_to_send } };
+    for ( const auto& [name, record] : stages ) {
+      out << "   " << name << ": ";
+      record->print_percentiles( out );
+      out << " max=";
+      Timer::pp_ns( out, record->max_ns );
+      out << "\n";
+    }
+  }
 }
 
 #include "connection.cc"
@@ -3,6 +3,7 @@
 #include "formats.hh"
 #include "h264_encoder.hh"
 #include "summarize.hh"
+#include "timer.hh"
 #include "timestamp.hh"
 #include "typed_ring_buffer.hh"
 
@@ -12,6 +13,20 @@
 
 class VideoSource : public Summarizable
 {
+public:
+  //! When a frame started and finished each stage of the capture pipeline (Timer::timestamp_ns())
+  struct StageTimestamps
+  {
+    uint64_t capture_start, captured, scale_start, scaled, encode_start, encoded;
+  };
+
+  //! Frames through each stage of the capture pipeline so far
+  struct StageCounts
+  {
+    uint64_t captured, scaled, encoded, dropped_at_capture, dropped_at_scale;
+  };
+
+private:
   struct TimedNAL
   {
     uint32_t nal_index;
@@ -30,9 +45,22 @@ class VideoSource : public Summarizable
   std::queue<TimedNAL> outbound_queue_ {};
   std::optional<uint64_t> timestamp_next_chunk_ {};
 
+  struct PipelineStatistics
+  {
+    Timer::Record decode {}, scale {}, encode {}; /* time spent in each stage */
+    Timer::Record capture_to_send {};             /* from the start of capture until the NAL is pushed here */
+    StageCounts counts {};
+    uint64_t first_capture {};
+  };
+
+  std::optional<PipelineStatistics> pipeline_stats_ {};
+
 public:
   void push( const H264Encoder::EncodedNAL& nal, const uint64_t now );
 
+  //! Account for a frame that came through a VideoPipeline, as its NAL is pushed
+  void record_pipeline_frame( const StageTimestamps& times, const StageCounts& counts, const uint64_t now );
+
   uint64_t wait_time_ms( const uint64_t now ) const;
   bool ready( const uint64_t now ) const;
 
@@ -40,6 +68,7 @@ public:
   bool has_frame() const;
   void pop_frame();
   VideoChunk front( const uint32_t frame_index ) const;
+  void front( const uint32_t frame_index, VideoChunk& out ) const;
 
   void summary( std::ostream& out ) const override;
 };
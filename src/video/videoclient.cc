@@ -17,14 +17,22 @@ void VideoClient::NetworkSession::transmit_frame( VideoSource& source, UDPSocket
   connection.send_packet( socket );
 }
 
-void VideoClient::NetworkSession::network_receive( const Ciphertext& ciphertext )
+void VideoClient::NetworkSession::network_receive( Ciphertext& ciphertext )
 {
-  connection.receive_packet( ciphertext );
+  connection.receive_packet_in_place( ciphertext );
 
   if ( connection.has_inbound_unreliable_data() ) {
     Parser p { connection.inbound_unreliable_data() };
     control.emplace();
     p.object( control.value() );
+    if ( not p.error() and not p.input().empty() ) {
+      uint8_t keyframe_requests;
+      p.integer( keyframe_requests );
+      if ( not p.error() ) {
+        keyframe_requested |= keyframe_requests != keyframe_requests_seen;
+        keyframe_requests_seen = keyframe_requests;
+      }
+    }
     if ( p.error() ) {
       p.clear_error();
     }
@@ -18,11 +18,16 @@ class VideoClient : public Summarizable
     NetworkSession( const uint8_t node_id, const KeyPair& session_key, const Address& destination );
 
     void transmit_frame( VideoSource& source, UDPSocket& socket );
-    void network_receive( const Ciphertext& ciphertext );
+    void network_receive( Ciphertext& ciphertext );
     void decode();
     void summary( std::ostream& out ) const;
 
     std::optional<video_control> control {};
+
+    /* the server asks for an IDR picture by incrementing a counter sent after each control update (which
+       starts from zero in each session, so a session's first value is a request unless it is zero) */
+    uint8_t keyframe_requests_seen {};
+    bool keyframe_requested {};
   };
 
   UDPSocket socket_ {};
@@ -57,4 +62,7 @@ public:
   bool has_control() const { return session_.has_value() and session_.value().control.has_value(); }
   const video_control& control() { return session_.value().control.value(); }
   void pop_control() { session_.value().control.reset(); }
+
+  bool keyframe_requested() const { return session_.has_value() and session_.value().keyframe_requested; }
+  void pop_keyframe_request() { session_.value().keyframe_requested = false; }
 };
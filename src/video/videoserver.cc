@@ -12,6 +12,12 @@ uint64_t VideoServer::server_clock() const
   return ( Timer::timestamp_ns() - global_ns_timestamp_at_creation_ ) * 24 / 1'000'000'000;
 }
 
+uint64_t VideoServer::timestamp_of_frame( const uint64_t frame ) const
+{
+  /* the first timestamp at which server_clock() >= frame */
+  return global_ns_timestamp_at_creation_ + ( frame * 1'000'000'000 + 23 ) / 24;
+}
+
 void VideoServer::receive_keyrequest( const Address& src, const Ciphertext& ciphertext )
 {
   /* decrypt */
@@ -23,12 +29,31 @@ void VideoServer::receive_keyrequest( const Address& src, const Ciphertext& ciph
   stats_.bad_packets++;
 }
 
+void VideoServer::receive_datagram( const Address& src, const Ciphertext& ciphertext )
+{
+  if ( ciphertext.length() > 24 ) {
+    const uint8_t node_id = ciphertext.as_string_view().back();
+    if ( node_id == uint8_t( KeyMessage::keyreq_id ) ) {
+      receive_keyrequest( src, ciphertext );
+    } else if ( node_id > 0 and node_id <= clients_.size() ) {
+      clients_.at( node_id - 1 ).receive_packet( src, ciphertext, server_clock() );
+    } else {
+      stats_.bad_packets++;
+    }
+  } else {
+    stats_.bad_packets++;
+  }
+}
+
 void VideoServer::add_key( const LongLivedKey& key )
 {
   const uint8_t next_id = clients_.size() + 1;
   const uint8_t ch1 = 2 * clients_.size();
   const uint8_t ch2 = ch1 + 1;
-  clients_.emplace_back( next_id, key );
+  clients_.emplace_back(
+    next_id, key, rasters_, [this, client_no = clients_.size()]( const string_view nal ) {
+      receive_nal( client_no, nal );
+    } );
   cerr << "Added key #" << int( next_id ) << " for: " << key.name() << " on channels " << int( ch1 ) << ":"
        << int( ch2 ) << "\n";
 }
@@ -44,44 +69,77 @@ VideoServer::VideoServer( const uint8_t num_clients, EventLoop& loop )
   socket_.bind( { "0", 9201 } );
 
   loop.add_rule( "network receive", socket_, Direction::In, [&] {
-    Address src { nullptr, 0 };
-    Ciphertext ciphertext;
-    ciphertext.resize( socket_.recv( src, ciphertext.mutable_buffer() ) );
-    if ( ciphertext.length() > 24 ) {
-      const uint8_t node_id = ciphertext.as_string_view().back();
-      if ( node_id == uint8_t( KeyMessage::keyreq_id ) ) {
-        receive_keyrequest( src, ciphertext );
-      } else if ( node_id > 0 and node_id <= clients_.size() ) {
-        clients_.at( node_id - 1 ).receive_packet( src, ciphertext, server_clock() );
-      } else {
-        stats_.bad_packets++;
-      }
-    } else {
-      stats_.bad_packets++;
+    inbound_payloads_.clear();
+    for ( auto& ciphertext : inbound_ciphertexts_ ) {
+      inbound_payloads_.push_back( ciphertext.mutable_buffer() );
+    }
+
+    const size_t num_received = socket_.recv_batch( { inbound_sources_.data(), inbound_sources_.size() },
+                                                    { inbound_payloads_.data(), inbound_payloads_.size() } );
+    for ( size_t i = 0; i < num_received; i++ ) {
+      inbound_ciphertexts_[i].resize( inbound_payloads_[i].size() );
+      receive_datagram( inbound_sources_[i], inbound_ciphertexts_[i] );
     }
   } );
 
-  loop.add_rule(
+  loop.add_timed_rule(
     "send acks",
     [&] {
       const uint64_t ts_now = Timer::timestamp_ns();
 
-      for ( auto& client : clients_ ) {
+      outbound_ciphertexts_.resize( max( outbound_ciphertexts_.size(), clients_.size() ) );
+      outbound_destinations_.clear();
+      outbound_payloads_.clear();
+      for ( size_t i = 0; i < clients_.size(); i++ ) {
+        auto& client = clients_[i];
         if ( client ) {
-          client.client().send_packet( socket_ );
+          if ( client.client().make_packet( outbound_ciphertexts_[i] ) ) {
+            outbound_destinations_.push_back( client.client().connection().destination() );
+            outbound_payloads_.push_back( outbound_ciphertexts_[i] );
+          }
 
           if ( client.client().connection().sender_stats().last_good_ack_ts + CLIENT_TIMEOUT_NS < ts_now ) {
             client.clear_current_session();
           }
         }
       }
+      socket_.sendto_batch( { outbound_destinations_.data(), outbound_destinations_.size() },
+                            { outbound_payloads_.data(), outbound_payloads_.size() } );
+
       next_ack_ts_ = Timer::timestamp_ns() + 5'000'000;
     },
-    [&] { return Timer::timestamp_ns() > next_ack_ts_; } );
+    [&] { return next_ack_ts_; } );
 
-  loop.add_rule(
+  loop.add_timed_rule(
     "encode [camera]",
     [&] {
+      camera_feed_ticks_++;
+
+      /* the source forwarded went away, started a new session, or passthrough was turned off */
+      if ( forwarding_from_.has_value() and not forwarding_source_intact() ) {
+        stop_forwarding();
+      }
+
+      /* waiting to switch to the live client's stream: ask it for an IDR picture now and then */
+      const bool live_connected = bool( clients_.at( camera_feed_live_no_ ) );
+      if ( passthrough_ and live_connected and forwarding_from_ != camera_feed_live_no_
+           and Timer::timestamp_ns() >= next_keyframe_request_ts_ ) {
+        clients_.at( camera_feed_live_no_ ).client().request_keyframe();
+        next_keyframe_request_ts_ = Timer::timestamp_ns() + KEYFRAME_REQUEST_INTERVAL_NS;
+      }
+
+      /* a client that becomes live is decoded in full from its next IDR picture, unless its NALs are forwarded */
+      for ( size_t i = 0; i < clients_.size(); i++ ) {
+        if ( clients_[i] ) {
+          const bool transcoded = i == camera_feed_live_no_ and forwarding_from_ != camera_feed_live_no_;
+          clients_[i].client().set_decode_mode( transcoded ? H264DecoderTask::Mode::All : idle_decode_mode_ );
+        }
+      }
+
+      if ( forwarding_from_.has_value() ) {
+        return;
+      }
+
       RasterYUV420& output = clients_.at( camera_feed_live_no_ )
                                ? clients_.at( camera_feed_live_no_ ).client().raster()
                                : default_raster_;
@@ -93,13 +151,58 @@ VideoServer::VideoServer( const uint8_t num_clients, EventLoop& loop )
         camera_feed_.reset_nal();
       }
     },
-    [&] { return server_clock() >= camera_feed_.frames_encoded() and not camera_feed_.has_nal(); } );
+    [&] { return timestamp_of_frame( camera_feed_ticks_ ); } );
+}
+
+bool VideoServer::forwarding_source_intact() const
+{
+  /* a new session of the same client picks up wherever its sender is, and the old session's partial NAL is
+     gone with it, so its NALs can't follow on from those already forwarded */
+  const KnownVideoClient& source = clients_.at( forwarding_from_.value() );
+  return passthrough_ and source and source.sessions_started() == forwarding_session_;
+}
+
+void VideoServer::stop_forwarding()
+{
+  /* transcode, starting with an IDR picture so that the feed's receivers can decode on from it, and ask the
+     live client for an IDR picture right away, to switch back to forwarding from */
+  forwarding_from_.reset();
+  camera_feed_.request_keyframe();
+  next_keyframe_request_ts_ = 0;
+}
+
+void VideoServer::receive_nal( const uint8_t client_no, const string_view nal )
+{
+  if ( not passthrough_ ) {
+    return;
+  }
+
+  if ( forwarding_from_ == client_no and not forwarding_source_intact() ) {
+    stop_forwarding();
+  }
+
+  /* switch to the live client's stream at an IDR picture, which needs nothing from before it */
+  if ( client_no == camera_feed_live_no_ and forwarding_from_ != client_no and contains_idr_slice( nal ) ) {
+    forwarding_from_ = client_no;
+    forwarding_session_ = clients_.at( client_no ).sessions_started();
+    stats_.source_switches++;
+  }
+
+  if ( forwarding_from_ == client_no ) {
+    camera_broadcast_socket_.sendto_ignore_errors( camera_destination_, nal );
+    stats_.NALs_forwarded++;
+  }
 }
 
 void VideoServer::summary( ostream& out ) const
 {
   out << "bad packets: " << stats_.bad_packets;
   out << " camera frames encoded: " << camera_feed_.frames_encoded();
+  if ( passthrough_ ) {
+    out << " passthrough: "
+        << ( forwarding_from_.has_value() ? "from #" + to_string( forwarding_from_.value() ) : "transcoding"s );
+    out << " NALs forwarded=" << stats_.NALs_forwarded << " switches=" << stats_.source_switches;
+  }
   out << " live now: "
       << ( clients_.at( camera_feed_live_no_ ) ? clients_.at( camera_feed_live_no_ ).name()
                                                : "none " + to_string( camera_feed_live_no_ ) );
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <optional>
 #include <ostream>
+#include <string_view>
 
 #include "crypto.hh"
 #include "eventloop.hh"
@@ -16,22 +18,49 @@ class VideoServer : public Summarizable
   UDPSocket socket_;
   uint64_t global_ns_timestamp_at_creation_;
   uint64_t server_clock() const;
+  uint64_t timestamp_of_frame( const uint64_t frame ) const;
 
   void receive_keyrequest( const Address& src, const Ciphertext& ciphertext );
+  void receive_datagram( const Address& src, const Ciphertext& ciphertext );
 
   uint8_t num_clients_;
   uint64_t next_ack_ts_;
 
+  /* clients' decoded pictures, reused from one session to the next */
+  RasterPool<RasterYUV420> rasters_ { 1280, 720 };
   std::vector<KnownVideoClient> clients_ {};
 
   struct Stats
   {
-    unsigned int bad_packets;
+    unsigned int bad_packets, NALs_forwarded, source_switches;
   } stats_ {};
 
+  /* datagrams are received and sent in batches, one system call per batch */
+  static constexpr size_t RECEIVE_BATCH = UDPSocket::max_batch;
+  std::vector<Ciphertext> inbound_ciphertexts_ = std::vector<Ciphertext>( RECEIVE_BATCH );
+  std::vector<Address> inbound_sources_ = std::vector<Address>( RECEIVE_BATCH );
+  std::vector<string_span> inbound_payloads_ {};
+
+  std::vector<Ciphertext> outbound_ciphertexts_ {};
+  std::vector<Address> outbound_destinations_ {};
+  std::vector<std::string_view> outbound_payloads_ {};
+
   RasterYUV420 default_raster_ { 1280, 720 };
   H264Encoder camera_feed_ { 1280, 720, 24, "veryfast", "zerolatency" };
   uint8_t camera_feed_live_no_ {};
+  H264DecoderTask::Mode idle_decode_mode_ { H264DecoderTask::Mode::All };
+  uint64_t camera_feed_ticks_ {};
+
+  /* in passthrough, the live client's NALs are forwarded as they are, rather than decoded and re-encoded */
+  static constexpr uint64_t KEYFRAME_REQUEST_INTERVAL_NS = 1'000'000'000;
+  bool passthrough_ {};
+  std::optional<uint8_t> forwarding_from_ {};
+  unsigned int forwarding_session_ {}; /* which of the source's sessions (a new one starts mid-stream) */
+  uint64_t next_keyframe_request_ts_ {};
+
+  bool forwarding_source_intact() const;
+  void stop_forwarding();
+  void receive_nal( const uint8_t client_no, const std::string_view nal );
 
   Address camera_destination_ { Address::abstract_unix( "stagecast-camera-video" ) };
   UnixDatagramSocket camera_broadcast_socket_ {};
@@ -44,6 +73,13 @@ public:
 
   void set_live( const std::string_view name );
 
+  //! How much of each non-live client's video to decode (the live client's is decoded in full when transcoded)
+  void set_idle_decode_mode( const H264DecoderTask::Mode mode ) { idle_decode_mode_ = mode; }
+
+  //! Forward the live client's NALs to the camera feed instead of transcoding them, switching clients at IDR
+  //! pictures (and transcoding only while no client's stream can be forwarded)
+  void set_passthrough( const bool passthrough ) { passthrough_ = passthrough; }
+
   void set_zoom( const video_control& control );
 
   void initialize_clock();
@@ -5,8 +5,13 @@ using namespace chrono;
 
 using Option = RubberBand::RubberBandStretcher::Option;
 
-VSClient::VSClient( const uint8_t node_id, CryptoSession&& crypto )
+VSClient::VSClient( const uint8_t node_id,
+                    CryptoSession&& crypto,
+                    RasterPool<RasterYUV420>& rasters,
+                    const NALCallback& on_nal )
   : connection_( 0, node_id, move( crypto ) )
+  , on_nal_( on_nal )
+  , decoder_( make_unique<H264DecoderTask>( rasters ) )
 {
   zoom_.x = 0;
   zoom_.y = 0;
@@ -19,7 +24,7 @@ bool VSClient::receive_packet( const Address& source, const Ciphertext& cipherte
   const bool ret = connection_.receive_packet( ciphertext, source );
 
   while ( connection_.next_frame_needed() > connection_.frames().range_begin() ) {
-    const VideoChunk& chunk = connection_.frames().at( connection_.frames().range_begin() ).value();
+    const VideoChunk& chunk = connection_.frames().at( connection_.frames().range_begin() );
     const size_t new_size = current_nal_.length() + chunk.data.length();
     if ( new_size + AV_INPUT_BUFFER_PADDING_SIZE > current_nal_.capacity() ) {
       throw runtime_error( "NAL too big" );
@@ -29,8 +34,8 @@ bool VSClient::receive_packet( const Address& source, const Ciphertext& cipherte
     current_nal_.resize( new_size );
 
     if ( chunk.end_of_nal ) {
-      decoder_.decode( current_nal_.as_string_view(), raster_ );
-      NALs_decoded_++;
+      on_nal_( current_nal_.as_string_view() );
+      decoder_->push_nal( current_nal_.as_string_view() );
       current_nal_.resize( 0 );
     }
 
@@ -40,23 +45,26 @@ bool VSClient::receive_packet( const Address& source, const Ciphertext& cipherte
   return ret;
 }
 
-void VSClient::send_packet( UDPSocket& socket )
+bool VSClient::make_packet( Ciphertext& ciphertext )
 {
-  if ( connection_.has_destination() ) {
+  if ( not connection_.has_destination() ) {
+    return false;
+  }
 
-    const uint64_t now = Timer::timestamp_ns();
-    if ( now > next_zoom_update_ ) {
-      NetString update;
-      Serializer s { update.mutable_buffer() };
-      s.object( zoom_ );
-      update.resize( s.bytes_written() );
+  const uint64_t now = Timer::timestamp_ns();
+  if ( now > next_zoom_update_ ) {
+    NetString update;
+    Serializer s { update.mutable_buffer() };
+    s.object( zoom_ );
+    s.integer( keyframe_requests_ );
+    update.resize( s.bytes_written() );
 
-      connection_.set_outbound_unreliable_data( update );
-      next_zoom_update_ = now + 25'000'000;
-    }
-
-    connection_.send_packet( socket );
+    connection_.set_outbound_unreliable_data( update );
+    next_zoom_update_ = now + 25'000'000;
   }
+
+  connection_.make_packet( ciphertext );
+  return true;
 }
 
 void VSClient::summary( ostream& out ) const
@@ -64,7 +72,7 @@ void VSClient::summary( ostream& out ) const
   if ( connection_.has_destination() ) {
     out << " (" << connection_.destination().to_string() << ") ";
   }
-  out << "video frames decoded: " << NALs_decoded_ << "\n";
+  decoder_->summary( out );
   connection_.summary( out );
 }
 
@@ -107,11 +115,16 @@ bool KnownVideoClient::try_keyrequest( const Address& src, const Ciphertext& cip
   return false;
 }
 
-KnownVideoClient::KnownVideoClient( const uint8_t node_id, const LongLivedKey& key )
+KnownVideoClient::KnownVideoClient( const uint8_t node_id,
+                                    const LongLivedKey& key,
+                                    RasterPool<RasterYUV420>& rasters,
+                                    const VSClient::NALCallback& on_nal )
   : id_( node_id )
   , name_( key.name() )
   , long_lived_crypto_( key.key_pair().downlink, key.key_pair().uplink, true )
   , next_reply_allowed_( steady_clock::now() )
+  , rasters_( rasters )
+  , on_nal_( on_nal )
   , next_session_( CryptoSession { next_keys_.downlink, next_keys_.uplink } )
 {}
 
@@ -126,7 +139,7 @@ void KnownVideoClient::receive_packet( const Address& src,
   Plaintext throwaway_plaintext;
   if ( next_session_.value().decrypt( ciphertext, { &id_, 1 }, throwaway_plaintext ) ) {
     /* new session established */
-    current_session_.emplace( id_, move( next_session_.value() ) );
+    current_session_.emplace( id_, move( next_session_.value() ), rasters_, on_nal_ );
 
     next_keys_ = KeyPair {};
     next_session_.emplace( next_keys_.downlink, next_keys_.uplink );
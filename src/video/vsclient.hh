@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <ostream>
 #include <vector>
 
@@ -8,7 +9,7 @@
 #include "connection.hh"
 #include "crypto.hh"
 #include "cursor.hh"
-#include "h264_decoder.hh"
+#include "h264_decoder_task.hh"
 #include "keys.hh"
 #include "videoclient.hh"
 
@@ -17,16 +18,21 @@ class VSClient
   VideoNetworkConnection connection_;
 
 public:
-  VSClient( const uint8_t node_id, CryptoSession&& crypto );
+  //! Called with each whole NAL received
+  using NALCallback = std::function<void( std::string_view nal )>;
 
-  H264Decoder decoder_ {};
-  RasterYUV420 raster_ { 1280, 720 };
-  StackBuffer<0, uint32_t, 1048576> current_nal_ {};
+  VSClient( const uint8_t node_id,
+            CryptoSession&& crypto,
+            RasterPool<RasterYUV420>& rasters,
+            const NALCallback& on_nal );
 
-  unsigned int NALs_decoded_ {};
+  NALCallback on_nal_;
+  std::unique_ptr<H264DecoderTask> decoder_;
+  StackBuffer<0, uint32_t, 1048576> current_nal_ {};
 
   bool receive_packet( const Address& source, const Ciphertext& ciphertext );
-  void send_packet( UDPSocket& sock );
+  //! Build the next packet for this client; returns false if it has no destination yet
+  bool make_packet( Ciphertext& ciphertext );
 
   void summary( std::ostream& out ) const;
 
@@ -35,10 +41,16 @@ public:
 
   const VideoNetworkConnection& connection() const { return connection_; }
 
-  RasterYUV420& raster() { return raster_; }
+  RasterYUV420& raster() { return decoder_->picture(); }
+
+  void set_decode_mode( const H264DecoderTask::Mode mode ) { decoder_->set_mode( mode ); }
 
   video_control zoom_ {};
   uint64_t next_zoom_update_ = 0;
+
+  //! Ask the client to encode an IDR picture (sent with the zoom updates)
+  void request_keyframe() { keyframe_requests_++; }
+  uint8_t keyframe_requests_ {};
 };
 
 class KnownVideoClient
@@ -51,6 +63,10 @@ class KnownVideoClient
 
   std::optional<VSClient> current_session_ {};
 
+  /* each session's pictures come from (and go back to) the server's pool */
+  RasterPool<RasterYUV420>& rasters_;
+  VSClient::NALCallback on_nal_;
+
   KeyPair next_keys_ {};
   std::optional<CryptoSession> next_session_;
 
@@ -60,7 +76,10 @@ class KnownVideoClient
   } stats_ {};
 
 public:
-  KnownVideoClient( const uint8_t node_id, const LongLivedKey& key );
+  KnownVideoClient( const uint8_t node_id,
+                    const LongLivedKey& key,
+                    RasterPool<RasterYUV420>& rasters,
+                    const VSClient::NALCallback& on_nal );
   bool try_keyrequest( const Address& src, const Ciphertext& ciphertext, UDPSocket& socket );
   void receive_packet( const Address& src, const Ciphertext& ciphertext, const uint64_t clock_sample );
 
@@ -69,6 +88,7 @@ public:
   const VSClient& client() const { return current_session_.value(); }
   const std::string& name() const { return name_; }
   uint8_t id() const { return id_; }
+  unsigned int sessions_started() const { return stats_.new_sessions; }
 
   void clear_current_session() { current_session_.reset(); }
 
@@ -140,7 +140,13 @@ static void write_all( string_view s, FileDescriptor& fd )
 void YUV4MPEGFrameWriter::write( const RasterYUV& r, FileDescriptor& fd )
 {
   fd.write( "FRAME\n"sv );
-  write_all( r.Y_view(), fd );
-  write_all( r.Cb_view(), fd );
-  write_all( r.Cr_view(), fd );
+  for ( uint16_t y = 0; y < r.height(); y++ ) {
+    write_all( { reinterpret_cast<const char*>( r.Y_row( y ) ), r.width() }, fd );
+  }
+  for ( uint16_t y = 0; y < r.chroma_height(); y++ ) {
+    write_all( { reinterpret_cast<const char*>( r.Cb_row( y ) ), r.chroma_width() }, fd );
+  }
+  for ( uint16_t y = 0; y < r.chroma_height(); y++ ) {
+    write_all( { reinterpret_cast<const char*>( r.Cr_row( y ) ), r.chroma_width() }, fd );
+  }
 }